@@ -12,14 +12,116 @@
 // Author: 	Mathieu Lattes (mathieu dot lattes at yahoo dot fr)						//
 //																					//
 //		 																			//
-// Version:	v0.0.8_20170530-01 : Refactored "comp*" variables to "sibling*" and     //
+// Version:	v0.3.0_20261017-22 : Buffered --output-console writer (large    //
+//          blocks instead of a flush per batch), paths quoted for the        //
+//          shell, new sh, cmd, nul and jsonl formats                         //
+//																				//
+//**********************************************************************************//
+// History:	v0.2.9_20261017-21 : Added --check-duplicates, pre-flight report//
+//          of the targets of several datasets over a whole inventory, hash   //
+//          table within a memory budget (--check-memory) spilled to sorted   //
+//          runs merged at the end                                            //
+//																				//
+//			v0.2.8_20261017-20 : Added --archive, datasets renamed inside   //
+//          ZIP and TAR archives (read through /vsizip/ and /vsitar/),        //
+//          entries copied without recompression to a new archive written in  //
+//          bounded memory                                                    //
+//																				//
+//			v0.2.7_20261017-19 : Added --output-dir, datasets moved across  //
+//          file systems by reflink or in kernel copy (copy_file_range,       //
+//          sendfile), synced before the sources are unlinked, copied in      //
+//          parallel (--transfer-threads)                                     //
+//																				//
+//			v0.2.6_20261017-18 : Added --drivers, only the drivers of the   //
+//          datasets formats registered at startup (plugins loaded one by     //
+//          one) and probed by GDALOpenEx, per file startup benchmark stages  //
+//																				//
+//			v0.2.5_20261017-17 : Core split into a reusable library         //
+//          (gdal_rename_lib.cpp/.h, GDALRenamer API), the cpp file only      //
+//          holds the command line                                            //
+//																				//
+//			v0.2.4_20261017-16 : Added --watch, datasets written to the     //
+//          input directories renamed once settled (inotify, CLOSE_WRITE and  //
+//          settle window)                                                    //
+//																				//
+//			v0.2.3_20261017-15 : Added --tile-index, GeoPackage or          //
+//          FlatGeobuf tile index of the renamed datasets written by the      //
+//          rename stage in large transactions                                //
+//																				//
+//			v0.2.2_20261017-14 : Added {col}/{row} tiles grid indices       //
+//          (--grid, --coord-type grid), grid given or inferred from the      //
+//          batch, datasets off the grid reported and suffixed                //
+//																				//
+//			v0.2.1_20261017-13 : Names computed by groups of datasets in the//
+//          batch workers : structure of arrays georeferencing, SSE2/AVX2     //
+//          corner and digit count kernels, table driven digits. nDigits      //
+//          fixed for the powers of ten and negative values                   //
+//																				//
+//			v0.2.0_20261017-12 : Added --target-srs, the reference point is //
+//          transformed from the SRS of each dataset (GeoTIFF keys, .prj or   //
+//          GDAL), datasets grouped by source SRS and transformed by arrays   //
+//																				//
+//			v0.1.9_20261017-11 : Added a benchmark mode (--benchmark)       //
+//          generating synthetic tile trees (GeoTIFF, JPEG2000, world files)  //
+//          and timing getCoord, the name formatting, dry runs, renames and   //
+//          renameFileNoOverWrite as files/s and syscalls/file                //
+//																				//
+//			v0.1.8_20261017-10 : Added per phase latency histograms and     //
+//          counters of the run (files, siblings, backups, failures by        //
+//          cause, syscalls) written as JSON with --stats, progress lines     //
+//          with --progress                                                   //
+//																				//
+//			v0.1.7_20261017-09 : Added a compiled name template engine      //
+//          (--name-template), the naming options and --printf-syntax are     //
+//          checked and compiled once, names rendered without printf nor      //
+//          length limit                                                      //
+//																				//
+//			v0.1.6_20261017-08 : Added a persistent memory mapped           //
+//          georeferencing cache (--georef-cache) keyed by path, size,        //
+//          modification time and inode                                       //
+//																				//
+//			v0.1.5_20261017-07 : Added a crash safe rename journal          //
+//          (--journal) synced once per group of renames, --resume and        //
+//          --rollback to finish or undo an interrupted run                   //
+//																				//
+//			v0.1.4_20261017-06 : Whole batch rename planner (--plan) :      //
+//          renames done in dependency order, cycles broken with exchanges    //
+//          or one temporary name, duplicate targets reported                 //
+//																				//
+//			v0.1.3_20261017-05 : Renames with renameat2                     //
+//          (RENAME_NOREPLACE/RENAME_EXCHANGE) relative to cached directory   //
+//          fds, optional io_uring batched submission, --rename-backend       //
+//          option                                                            //
+//																				//
+//			v0.1.2_20261017-04 : Added a sibling index, in batch mode each  //
+//          directory is read once and the sibling files and rename targets   //
+//          are looked for in memory (case insensitive extensions), only the  //
+//          siblings which exist are renamed                                  //
+//																				//
+//			v0.1.1_20261017-03 : Added a fast path reading the              //
+//          georeferencing from the headers only (GeoTIFF tags, world files   //
+//          with the TIFF or JPEG2000 raster size, ER Mapper .ers), GDALOpen  //
+//          is only used when it can't be resolved this way (--no-fast-       //
+//          georef to always use it)                                          //
+//																				//
+//			v0.1.0_20261017-02 : Added --from-stdin (and -0 for NUL         //
+//          delimited paths) and a pipelined batch mode, a reader stage       //
+//          feeds a bounded queue of workers computing the new names, the     //
+//          renames are done by a single rename stage                         //
+//																				//
+//			v0.0.9_20261017-01 : Added batch mode, several datasets and/or      //
+//          directories (walked recursively) are renamed by a single process    //
+//          using a pool of worker threads (--threads|-j), with a summary of    //
+//          successes and failures at the end (--extensions|-e filters the      //
+//          files found in directories)                                         //
+//																					//
+//			v0.0.8_20170530-01 : Refactored "comp*" variables to "sibling*" and     //
 //          compiled on linux (gdal 2.2.0 + g++ 5.4.0 + Ubuntu 16.04 +              //
 //          Code::Blocks 16.01. Change renameFileNoOverWrite proc as the posix      //
 //		 	rename() function mapped by ::VSILRename overwrite by default on linux  //
 //          and return error on windows                                             //
 //																					//
-//**********************************************************************************//
-// History:	v0.0.7_20170320-01 : Added --output-console option to allow the print	//
+//			v0.0.7_20170320-01 : Added --output-console option to allow the print	//
 //			(in the console) of the command line to perform the rename instead of	//
 //			doing it. It allow user to create a batch file using redirection	 	//
 //			operator of the system	console '>', '>>', '|'...						//
@@ -36,290 +138,764 @@
 //																					//
 //##################################################################################//
 
-#include <iostream>
-
-#include "gdal_priv.h"
-
-#include "cpl_error.h"
-#include "cpl_conv.h"
-#include "cpl_vsi.h"
+#include "gdal_rename_priv.h"
 
-#include "json_object.h"
-#include "ogr_srs_api.h"
+#include "cpl_spawn.h"
 
-#include "commonutils.h"
-
-#include <string>
-#include <math.h>
+//!Result of a benchmark stage
+struct BenchmarkResult
+	{
+	int			nTiles;
+	std::string	sLayout;	//flat or nested
+	std::string	sStage;
+	GIntBig		nFiles;		//datasets, tiles or files processed by the stage
+	double		dfSeconds;
+	GIntBig		nSyscalls;	//file system calls counted by the stage, -1 if not counted
+	};
 
-#ifdef _WIN32
-std::string  sDirSep = "\\";
-#else //Linux or MacOsX
-std::string  sDirSep = "/";
-#endif
+//!Number of per file invocations timed by the benchmark startup stages
+#define GDAL_RENAME_BENCHMARK_STARTUP	50
 
-//!Return number of digits from integer part of double
-int nDigits (double dValue);
+//!Generate a synthetic tile tree (GeoTIFF, JPEG2000, world files and .prj)
+bool generateSyntheticTiles(const std::string& sRoot, int nTiles, bool bNested, std::vector<DatasetGeoRef>& aoGeoRefs, GIntBig& nFiles);
 
-//!Get integer coordinate from GDALDataset
-double getCoord (char refPointPart, double *adfGeoTransform, GDALDataset *poDataset);
-//!Get char of coordinate hemisphere from GDALDataset
+//!Benchmark the rename path on synthetic tile trees
+int runBenchmark(const char* pszExecutable, const char* pszWorkDir, const char* pszTiles, const char* pszLayouts, int nThreads, const RenameOptions& oOptions, const char* pszStats);
 
-char getCoordHemi (char refPointPart, double *adfGeoTransform, GDALDataset *poDataset);
-//!Call VSIL rename function and rename old file if already existing
-bool renameFileNoOverWrite (std::string sourcePath, std::string newPath);
+//!Usage
+static void Usage(const char* pszErrorMsg = NULL);
 
-//!Get world file extension of a GDALDataset
-std::string getWorldFileExt (std::string inputFile);
+/************************************************************************/
+/*                               Usage()                                */
+/************************************************************************/
+static void Usage(const char* pszErrorMsg)
+	{
+    printf( "Usage: gdal_rename [--help|-h] [--input-file-to-rename|-i] [--refpoint|-r]\n"
+			"                   { [--coord-zero-padding|-z] [--coord-length|-l]\n"
+			"                     [--coord-type|-t] [--coord-sep|-s] [--prefix|-p]\n"
+			"                     [--suffix|-s] } | { [--printf-syntax|-f] }\n"
+			"                   | { [--name-template|-n] } [--target-srs srs]\n"
+			"					[--grid auto|origin_x,origin_y,tile_size_x,tile_size_y]\n"
+			"					[--offgrid-suffix suffix]\n"
+			"					[--output-console|-o]\n"
+			"					[--threads|-j] [--extensions|-e] [--from-stdin [-0]]\n"
+			"					[--watch [--watch-settle seconds]] [--archive]\n"
+			"					[--no-fast-georef] [--drivers all|auto|driver,...]\n"
+			"					[--rename-backend] [--plan]\n"
+			"					[--output-dir dir [--transfer-threads n]]\n"
+			"					[--check-duplicates [--check-memory MB]]\n"
+			"					[--journal|--resume|--rollback journal_file]\n"
+			"					[--georef-cache cache_file]\n"
+			"					[--tile-index index_file [--tile-index-format GPKG|FlatGeobuf]]\n"
+			"					[--stats stats_file] [--progress seconds]\n"
+			"					dataset_or_directory [dataset_or_directory ...]\n"
+			"       gdal_rename --benchmark work_dir [--benchmark-tiles 1k,100k,1M]\n"
+			"					[--benchmark-layout flat,nested] [naming and rename options]\n\n\n" );
 
-//!Get an array of sibling files extensions of a dataset (ie: tfw, prj
-//!for a tif file). Need to be populated for other datasets !!!
-std::vector<std::string> getSiblingFilesExt (std::string inputFile);
+    printf( " --help|-h: print this message\n"
+			" --refpoint|-r: Ref point to use in the name. Any pair of 'W', 'E' and 'N',\n"
+			"                'S' (ie: WN, NW, EN, NE, WS, SW, ES, SE).\n"
+			" --prefix|-p: Prefix to use for the new file name format (ie: \n"
+			"              Prefix_XXXXXXXXXXX.EXT)\n"
+			" --coord-length|-l: number of digits to use in coordinates value starting with\n"
+			"                    high wheight digits (ie: using 4 with easting value of \n"
+			"                    621000.0 will print 06210 with zero padding and \n"
+			"                    6210 without)\n"
+			" --coord-decimal-length|-d: number of digits to use in decimal part for real coordinates\n"
+			" --coord-zero-padding|-z: wether or not padding coordinate with 0 if inequal \n"
+			"                          number of digits between easting and northing\n \n"
+			" --coord-type|-t: 'int' or 'real' used to format coordinates, or 'grid' for the\n"
+			"                  column and row of the tile in the tiles grid (see --grid)\n"
+			" --coord-sign|-g: 'std': sign printed if negative, 'force': allways printed (+/-) or 'geo': hemisphere display E-W or N-S\n"
+			" --coord-sep|-s: separator of coordinates components when formating\n"
+			" --suffix|-x: suffix to use for the new file name format (ie: \n"
+			"              XXXXXXXXXXX_suffix.EXT)\n"
+			" --printf-syntax|-f: a string with printf syntax instead of all the previous parameters\n"
+			"                     (ie: Tiles_%%.4d-%%.4d_Lambert93), checked before any rename: 2\n"
+			"                     substitutions for easting/northing (%%d or %%f), or 4 with\n"
+			"                     --coord-sign geo (%%c%%d or %%c%%f), flags, width, precision\n"
+			"                     and length modifiers (ie: %%ld) accepted\n"
+			" --name-template|-n: name template instead of all the previous parameters\n"
+			"                     (ie: \"{prefix}{x:07d}_{y:07d}{hemi}\"), fields are {x}, {y},\n"
+			"                     {hemi_x}, {hemi_y}, {hemi}, {prefix}, {suffix}, {sep},\n"
+			"                     {col}, {row} (tiles grid indices, spec [-+0 #][width]d) and\n"
+			"                     coordinates spec [-+0 #][width][.precision]d|f|t where t\n"
+			"                     keeps the high wheight digits like --coord-length,\n"
+			"                     {{ and }} for braces. Checked before any rename\n"
+			" --target-srs: SRS of the coordinates used in the names (ie: EPSG:4326, WKT,\n"
+			"               PROJ string), the reference point is transformed from the SRS\n"
+			"               of each dataset (GeoTIFF keys, .prj file or GDAL), the signs and\n"
+			"               hemispheres are the ones of the transformed coordinates. In\n"
+			"               batch mode the datasets are transformed by groups of same SRS.\n"
+			"               The georeferencing cache is not used\n"
+			" --grid: tiles grid of {col} and {row} : the reference point of the tile 0,0\n"
+			"         and the tiles size, rows go south (north with a S refpoint). 'auto'\n"
+			"         (the default) infers it from the whole batch : most common tiles\n"
+			"         size and alignment. The datasets off the grid are reported and\n"
+			"         named after the cell holding their reference point\n"
+			" --offgrid-suffix: appended to the names of the datasets off the tiles grid\n"
+			"                   (default: _offgrid)\n"
+			" --output-console|-o: a string must be \"win\" or \"unix\".\n"
+			"                     If specified, print (in the console) the command to\n"
+			"                     perform the rename instead of doing it. It allow the user to\n"  
+			"                     create a batch file using system console redirection operator\n"
+			"                     like '>', '>>', '|'...\n"
+			"                     Other formats : \"sh\" and \"cmd\" scripts (stopping at the\n"
+			"                     first failure or existing target, each target directory\n"
+			"                     created once), \"nul\" source\\0target\\0 pairs for xargs -0\n"
+			"                     and \"jsonl\" (one {\"source\":...,\"target\":...} object per\n"
+			"                     line, the bytes not UTF-8 written as \\udcXX). The paths are\n"
+			"                     quoted for the shell and the output is written by large blocks\n"
+			" --threads|-j: number of worker threads (or ALL_CPUS, the default) used\n"
+			"               when several datasets or directories are given\n"
+			" --extensions|-e: comma separated list of the datasets extensions renamed\n"
+			"                  when walking directories (default: tif,tiff,jp2,j2k,ecw,img)\n"
+			" --from-stdin: read the datasets paths from stdin, one per line, they are\n"
+			"               renamed while they arrive (ie: find . -name \"*.tif\" | gdal_rename --from-stdin)\n"
+			" -0|--null: paths read from stdin are NUL delimited (ie: find -print0)\n"
+			" --watch: rename the datasets written to the input directories (and their sub\n"
+			"          directories) as soon as they and their sibling files are closed and\n"
+			"          unchanged for the settle window, until Ctrl+C (Linux, inotify). The\n"
+			"          datasets already there are renamed first\n"
+			" --watch-settle: settle window of --watch in seconds (default: 0.2)\n"
+			" --archive: the inputs are ZIP or uncompressed TAR archives, the datasets\n"
+			"            inside (and their sibling entries) are read through /vsizip/\n"
+			"            or /vsitar/ and renamed by writing a new archive : compressed\n"
+			"            entries copied as they are, new central directory, synced then\n"
+			"            renamed over the old archive\n"
+			" --no-fast-georef: always open the datasets with GDAL to read their georeferencing.\n"
+			"                   By default it is read from the headers only when possible\n"
+			"                   (GeoTIFF tags, world files, JPEG2000 size, ER Mapper .ers)\n"
+			" --drivers: GDAL drivers registered at startup : 'all' (GDALAllRegister, the\n"
+			"            default), 'auto' (the drivers of --extensions and of the datasets\n"
+			"            given, all if one has no known driver) or a comma separated list\n"
+			"            (ie: GTiff,JP2OpenJPEG). The other plugins are not loaded (set\n"
+			"            GDAL_DRIVER_PATH for the plugin drivers) and a dataset is only\n"
+			"            probed by the drivers of its extension\n"
+			" --rename-backend: \"vsi\" (VSIRename, portable), \"renameat2\" (atomic no overwrite\n"
+			"                   renames, Linux), \"io_uring\" (renameat2 submitted in batches,\n"
+			"                   Linux 5.11) or \"auto\" (renameat2 if available, the default)\n"
+			" --plan: compute all the renames of the batch first, then do them in order\n"
+			"         (A->B after B->C), swaps and cycles need no backup files. The\n"
+			"         datasets renamed to the same name are reported and left untouched\n"
+			" --output-dir: existing directory the renamed datasets are moved to. On\n"
+			"               another file system each dataset (main file and sibling\n"
+			"               files together) is copied (reflink, else in kernel copy),\n"
+			"               synced, renamed into place, then its source files are\n"
+			"               removed. A dataset not fully copied is left in place, the\n"
+			"               .gdal_rename_part files of a killed run can be removed. Not\n"
+			"               usable with --plan\n"
+			" --transfer-threads: number of datasets copied at once by --output-dir\n"
+			"                     across file systems (default: 4)\n"
+			" --check-duplicates: compute the names of the whole inventory without renaming\n"
+			"                     anything and report the targets of several datasets (ie:\n"
+			"                     coordinates truncated by --coord-length) and the targets\n"
+			"                     held by a file out of the inventory, exit code 1 if any\n"
+			" --check-memory: memory budget of --check-duplicates in MB (default: 512),\n"
+			"                 the targets are spilled to sorted temporary files (CPL_TMPDIR)\n"
+			"                 and merged when over it\n"
+			" --journal: record the renames in a journal file (synced once per group of\n"
+			"            renames) so an interrupted run can be resumed or undone\n"
+			" --resume: finish the renames of an interrupted run from its journal, then\n"
+			"           continue with the given inputs without reopening the datasets\n"
+			"           already renamed (same inputs and current directory)\n"
+			" --rollback: undo the renames recorded in a journal, last one first\n"
+			" --georef-cache: file caching the datasets georeferencing (by path, size,\n"
+			"                 modification time and inode) so they are not opened again\n"
+			"                 by the next runs, created if missing. The datasets with a\n"
+			"                 georeferencing sidecar (world file, .tab, .ers, .aux.xml)\n"
+			"                 are not cached\n"
+			" --tile-index: write the new path, footprint and SRS of each renamed dataset\n"
+			"               to a new GeoPackage or FlatGeobuf file (spatial index built),\n"
+			"               in the same pass as the renames. The layer SRS is the one of\n"
+			"               the first dataset (the other footprints are reprojected to\n"
+			"               it), the georeferencing cache is not used. Not usable with\n"
+			"               --output-console, nothing is renamed\n"
+			" --tile-index-format: 'GPKG' or 'FlatGeobuf' (default: from the extension,\n"
+			"                      FlatGeobuf for .fgb)\n"
+			" --stats: write the statistics of the run as JSON (\"-\" for stdout) : counters\n"
+			"          (datasets, siblings, backups, stat/open/rename calls), failures by\n"
+			"          cause and latency histograms of each phase (driver registration,\n"
+			"          directory reads, stat, header read, GDALOpen, geotransform, name\n"
+			"          formatting, rename, journal sync, transfer, archive write,\n"
+			"          duplicate check)\n"
+			" --progress: print a progress line on stderr every given seconds in batch mode\n"
+			" --benchmark: generate synthetic tile trees in the work directory (GeoTIFF,\n"
+			"              JPEG2000, world files and .prj in the four hemispheres), time\n"
+			"              getCoord, the name formatting (per dataset and by groups), a dry\n"
+			"              run (--output-console), the cold start of per file runs (all\n"
+			"              drivers and --drivers auto), the renames and renameFileNoOverWrite,\n"
+			"              print files/s and syscalls/file (and write them as JSON with\n"
+			"              --stats), then remove the trees\n"
+			" --benchmark-tiles: comma separated numbers of tiles of the trees (default 1k,100k)\n"
+			" --benchmark-layout: \"flat\" (one directory), \"nested\" (a directory per row of\n"
+			"                     tiles) or both (\"flat,nested\", the default)\n"
+			"\n"
+			" Several datasets and/or directories (walked recursively) can be given,\n"
+			" the new names are computed by a pool of threads, the renames are done by\n"
+			" a single thread and a summary of the successes and failures is printed\n"
+			" on stderr at the end.\n");
 
-//!Usage
-static void Usage(const char* pszErrorMsg = NULL);
+    if( pszErrorMsg != NULL )
+        fprintf(stderr, "\nFAILURE: %s\n", pszErrorMsg);
 
-//!Check whether or not the given refpoint is good
-bool checkRefPoint(const char* CoordRefPoint);
+    exit( 1 );
+	}
 
-//!format the rename command line for output in the console
-std::string formatRenameCmdLine(const char* pszSystemType, const char* pszSourceName, const char* pszNewName);
+//***********************************************************************//
+//!Append an unsigned integer to a buffer, little or big endian
+//***********************************************************************//
+static void appendUInt(std::vector<GByte>& abyData, GUIntBig nValue, int nBytes, bool bBigEndian)
+	{
+	for( int i = 0; i < nBytes; i++ )
+		{ abyData.push_back( (GByte)( nValue >> ( 8 * ( bBigEndian ? nBytes - 1 - i : i ) ) ) ); }
+	}
 
 //***********************************************************************//
-//!Return number of digits from integer part of double
+//!Append a double to a buffer, little endian
 //***********************************************************************//
-int nDigits (double dValue)
+static void appendDouble(std::vector<GByte>& abyData, double dfValue)
 	{
-	return int(ceil(log10(dValue)));
+	GUIntBig nBits;
+	memcpy(&nBits, &dfValue, sizeof(nBits));
+	appendUInt(abyData, nBits, 8, false);
 	}
 
 //***********************************************************************//
-//!Get integer coordinate from GDALDataset
+//!Write a buffer to a new file
 //***********************************************************************//
-double getCoord (char refPointPart, double *adfGeoTransform, GDALDataset *poDataset)
+static bool writeBenchmarkFile(const std::string& sPath, const void* pData, size_t nSize)
 	{
-	double Coord = 0.;
+	VSILFILE *fp = ::VSIFOpenL(sPath.c_str(), "wb");
 
-	switch ( refPointPart )
+	if ( fp == NULL )
 		{
-		case 'W' : Coord = adfGeoTransform[0]; break;
-		case 'E' : Coord = (adfGeoTransform[0]+(poDataset->GetRasterXSize()*adfGeoTransform[1])); break;
-		case 'S' : Coord = (adfGeoTransform[3]+(poDataset->GetRasterYSize()*adfGeoTransform[5])); break;
-		case 'N' : Coord = adfGeoTransform[3]; break;
-		default	 : Coord = adfGeoTransform[0];
+		::CPLError(CE_Failure, CPLE_OpenFailed, "Unable to create \"%s\"", sPath.c_str());
+		return false;
 		}
 
-	return Coord;
+	bool bSuccess = ( ::VSIFWriteL(pData, 1, nSize, fp) == nSize );
+	if ( ::VSIFCloseL(fp) != 0 )
+		{ bSuccess = false; }
+
+	return bSuccess;
 	}
 
 //***********************************************************************//
-//!Get char of coordinate hemisphere from GDALDataset
+//!Write a synthetic 8 bits TIFF (one strip), georeferenced with the
+//!ModelTiepoint and ModelPixelScale tags if bGeoTags (otherwise by a
+//!world file)
 //***********************************************************************//
-char getCoordHemi (char refPointPart, double *adfGeoTransform, GDALDataset *poDataset)
+static bool writeSyntheticTiff(const std::string& sPath, const DatasetGeoRef& oGeoRef, bool bGeoTags)
 	{
-	double Coord = 0.0;
-	char Hemi = 'N';
-
-	switch ( refPointPart )
+	const int nEntries = bGeoTags ? 12 : 9;
+	const GUInt32 nPixels = (GUInt32)( oGeoRef.nRasterXSize * oGeoRef.nRasterYSize );
+	const GUInt32 nDataOffset = 8 + 2 + nEntries * 12 + 4;
+	const GUInt32 nScaleOffset = nDataOffset + nPixels;
+	const GUInt32 nTiepointOffset = nScaleOffset + 3 * 8;
+	const GUInt32 nGeoKeysOffset = nTiepointOffset + 6 * 8;
+
+	//tag, type (3 SHORT, 4 LONG, 12 DOUBLE), count, value or offset
+	const GUInt32 aanEntries[12][4] =
 		{
-		case 'W' : Coord = adfGeoTransform[0]; break;
-		case 'E' : Coord = (adfGeoTransform[0]+(poDataset->GetRasterXSize()*adfGeoTransform[1])); break;
-		case 'S' : Coord = (adfGeoTransform[3]+(poDataset->GetRasterYSize()*adfGeoTransform[5])); break;
-		case 'N' : Coord = adfGeoTransform[3]; break;
-		default	 : Coord = adfGeoTransform[0];
-		}
-
-	if ( Coord >= 0 )
+		{ 256, 3, 1, (GUInt32) oGeoRef.nRasterXSize },	//ImageWidth
+		{ 257, 3, 1, (GUInt32) oGeoRef.nRasterYSize },	//ImageLength
+		{ 258, 3, 1, 8 },								//BitsPerSample
+		{ 259, 3, 1, 1 },								//Compression : none
+		{ 262, 3, 1, 1 },								//Photometric : min is black
+		{ 273, 4, 1, nDataOffset },						//StripOffsets
+		{ 277, 3, 1, 1 },								//SamplesPerPixel
+		{ 278, 3, 1, (GUInt32) oGeoRef.nRasterYSize },	//RowsPerStrip
+		{ 279, 4, 1, nPixels },							//StripByteCounts
+		{ 33550, 12, 3, nScaleOffset },					//ModelPixelScale
+		{ 33922, 12, 6, nTiepointOffset },				//ModelTiepoint
+		{ 34735, 3, 12, nGeoKeysOffset }				//GeoKeyDirectory
+		};
+
+	std::vector<GByte> abyData;
+	abyData.push_back('I');
+	abyData.push_back('I');
+	appendUInt(abyData, 42, 2, false);
+	appendUInt(abyData, 8, 4, false);
+	appendUInt(abyData, nEntries, 2, false);
+
+	for( int i = 0; i < nEntries; i++ )
 		{
-		if (refPointPart == 'W' || refPointPart == 'E')
-			{ Hemi = 'E'; }
+		appendUInt(abyData, aanEntries[i][0], 2, false);
+		appendUInt(abyData, aanEntries[i][1], 2, false);
+		appendUInt(abyData, aanEntries[i][2], 4, false);
+		//a single SHORT value is left justified in the offset field
+		if ( aanEntries[i][1] == 3 && aanEntries[i][2] == 1 )
+			{
+			appendUInt(abyData, aanEntries[i][3], 2, false);
+			appendUInt(abyData, 0, 2, false);
+			}
 		else
-			{ Hemi = 'N'; }
+			{ appendUInt(abyData, aanEntries[i][3], 4, false); }
 		}
-	else
+
+	appendUInt(abyData, 0, 4, false); //no next IFD
+	abyData.resize(abyData.size() + nPixels, 0);
+
+	if ( bGeoTags )
 		{
-		if (refPointPart == 'W' || refPointPart == 'E')
-			{ Hemi = 'W'; }
-		else
-			{ Hemi = 'S'; }
+		const double adfScale[3] = { oGeoRef.adfGeoTransform[1], -oGeoRef.adfGeoTransform[5], 0.0 };
+		const double adfTiepoint[6] = { 0.0, 0.0, 0.0, oGeoRef.adfGeoTransform[0], oGeoRef.adfGeoTransform[3], 0.0 };
+		//version 1.1.0, 2 keys : projected model, pixel is area
+		const GUInt32 anGeoKeys[12] = { 1, 1, 0, 2, 1024, 0, 1, 1, 1025, 0, 1, 1 };
+
+		for( int i = 0; i < 3; i++ )
+			{ appendDouble(abyData, adfScale[i]); }
+		for( int i = 0; i < 6; i++ )
+			{ appendDouble(abyData, adfTiepoint[i]); }
+		for( int i = 0; i < 12; i++ )
+			{ appendUInt(abyData, anGeoKeys[i], 2, false); }
 		}
 
-	return Hemi;
+	return writeBenchmarkFile(sPath, &abyData[0], abyData.size());
 	}
 
 //***********************************************************************//
-//!Call VSIL rename function and rename old file if already existing
+//!Write a synthetic JPEG2000 file : JP2 boxes (signature, file type,
+//!image header, colour) and a codestream main header (SOC, SIZ, COD, QCD)
+//!without tile, no internal georeferencing
 //***********************************************************************//
-bool renameFileNoOverWrite (std::string sourcePath, std::string newPath)
+static bool writeSyntheticJP2(const std::string& sPath, const DatasetGeoRef& oGeoRef)
 	{
-    ::VSIStatBufL psStatBuf;
-    int renameSuccess = -1, renameBackupSuccess = -1;
-
-    if (::VSIStatExL ( newPath.c_str(), &psStatBuf, VSI_STAT_EXISTS_FLAG) == 0 )
-        {
-		std::string sNewFilePathTmp = newPath.substr(0,newPath.length()-4);
-		sNewFilePathTmp += "_OldOne" + newPath.substr(newPath.length()-4, 4);
+	const GUInt32 nWidth = (GUInt32) oGeoRef.nRasterXSize;
+	const GUInt32 nHeight = (GUInt32) oGeoRef.nRasterYSize;
+	std::vector<GByte> abyData;
+
+	//signature and file type boxes
+	appendUInt(abyData, 12, 4, true);
+	appendUInt(abyData, 0x6A502020, 4, true);	//"jP  "
+	appendUInt(abyData, 0x0D0A870A, 4, true);
+	appendUInt(abyData, 20, 4, true);
+	appendUInt(abyData, 0x66747970, 4, true);	//"ftyp"
+	appendUInt(abyData, 0x6A703220, 4, true);	//"jp2 "
+	appendUInt(abyData, 0, 4, true);
+	appendUInt(abyData, 0x6A703220, 4, true);
+
+	//header superbox : image header (1 component, 8 bits) and greyscale colour
+	appendUInt(abyData, 8 + 22 + 15, 4, true);
+	appendUInt(abyData, 0x6A703268, 4, true);	//"jp2h"
+	appendUInt(abyData, 22, 4, true);
+	appendUInt(abyData, 0x69686472, 4, true);	//"ihdr"
+	appendUInt(abyData, nHeight, 4, true);
+	appendUInt(abyData, nWidth, 4, true);
+	appendUInt(abyData, 1, 2, true);
+	appendUInt(abyData, 0x07070000, 4, true);	//depth, compression, unknown colourspace, IPR
+	appendUInt(abyData, 15, 4, true);
+	appendUInt(abyData, 0x636F6C72, 4, true);	//"colr"
+	appendUInt(abyData, 0x010000, 3, true);		//enumerated, precedence, approximation
+	appendUInt(abyData, 17, 4, true);			//greyscale
+
+	//codestream box
+	appendUInt(abyData, 8 + 2 + 43 + 14 + 6 + 2, 4, true);
+	appendUInt(abyData, 0x6A703263, 4, true);	//"jp2c"
+	appendUInt(abyData, 0xFF4F, 2, true);		//SOC
+	appendUInt(abyData, 0xFF51, 2, true);		//SIZ : one tile, one 8 bits component
+	appendUInt(abyData, 41, 2, true);
+	appendUInt(abyData, 0, 2, true);
+	appendUInt(abyData, nWidth, 4, true);
+	appendUInt(abyData, nHeight, 4, true);
+	appendUInt(abyData, 0, 8, true);
+	appendUInt(abyData, nWidth, 4, true);
+	appendUInt(abyData, nHeight, 4, true);
+	appendUInt(abyData, 0, 8, true);
+	appendUInt(abyData, 1, 2, true);
+	appendUInt(abyData, 0x070101, 3, true);
+	appendUInt(abyData, 0xFF52, 2, true);		//COD : one layer, no decomposition, 64x64 blocks, 5-3 wavelet
+	appendUInt(abyData, 12, 2, true);
+	appendUInt(abyData, 0, 2, true);
+	appendUInt(abyData, 1, 2, true);
+	appendUInt(abyData, 0, 2, true);
+	appendUInt(abyData, 0x0404, 2, true);
+	appendUInt(abyData, 0x0001, 2, true);
+	appendUInt(abyData, 0xFF5C, 2, true);		//QCD : no quantization
+	appendUInt(abyData, 4, 2, true);
+	appendUInt(abyData, 0x4040, 2, true);
+	appendUInt(abyData, 0xFFD9, 2, true);		//EOC
+
+	return writeBenchmarkFile(sPath, &abyData[0], abyData.size());
+	}
 
-        if ( ::VSIStatExL ( sNewFilePathTmp.c_str(), &psStatBuf, VSI_STAT_EXISTS_FLAG) == 0 )
-			{
-			std::cout << "Error while renaming \"" << sourcePath << "\" to \"" << newPath << "\"" << std::endl;
-			std::cout << "Both new name and new name backup file already exist, unable to perform the rename...." << std::endl ;
-			return false;
-            }
-        else
-            {
-            //backuping the file already existing with the new naming convention
-            renameBackupSuccess = ::VSIRename( newPath.c_str(), sNewFilePathTmp.c_str() );
-            if ( renameBackupSuccess == 0 )
-                //do the inital rename if success
-                { renameSuccess =  ::VSIRename( sourcePath.c_str(), newPath.c_str() ); }
-            else
-                {
-                std::cout << "Error while backuping \"" << newPath << "\" to \"" << sNewFilePathTmp << "\"" << std::endl;
-                std::cout << "unable to perform the rename...." << std::endl ;
-                return false;
-                }
-            }
-        }
-    else
-        { renameSuccess =  ::VSIRename( sourcePath.c_str(), newPath.c_str() ); }
-
-	if ( renameSuccess == 0 )
-		{ return true;}
-    else
-        { std::cout << "Error while renaming \"" << sourcePath << "\" to \"" << newPath << "\"" << std::endl; }
+//***********************************************************************//
+//!Write the world file of a synthetic tile (center of the top left pixel)
+//***********************************************************************//
+static bool writeSyntheticWorldFile(const std::string& sPath, const DatasetGeoRef& oGeoRef)
+	{
+	const double *adfGeoTransform = oGeoRef.adfGeoTransform;
+	std::string sContent = CPLSPrintf("%.6f\n%.6f\n%.6f\n%.6f\n%.6f\n%.6f\n",
+									  adfGeoTransform[1], adfGeoTransform[4], adfGeoTransform[2], adfGeoTransform[5],
+									  adfGeoTransform[0] + adfGeoTransform[1] * 0.5 + adfGeoTransform[2] * 0.5,
+									  adfGeoTransform[3] + adfGeoTransform[4] * 0.5 + adfGeoTransform[5] * 0.5);
 
+	return writeBenchmarkFile(sPath, sContent.c_str(), sContent.size());
 	}
 
 //***********************************************************************//
-//!Get world file extension of a GDALDataset
+//!Generate a synthetic tile tree of nTiles 1000 m tiles (16x16 pixels) :
+//!GeoTIFF with internal georeferencing, GeoTIFF + prj, TIFF + tfw + prj
+//!and JPEG2000 + j2w + prj in turn, in the four hemispheres. Flat (one
+//!directory) or nested (one directory per row of tiles) layout. The
+//!georeferencing of the tiles and the number of files are returned
 //***********************************************************************//
-std::string getWorldFileExt (std::string inputFile)
+bool generateSyntheticTiles(const std::string& sRoot, int nTiles, bool bNested, std::vector<DatasetGeoRef>& aoGeoRefs, GIntBig& nFiles)
 	{
-	std::vector<std::string> siblingFilesExt;
+	static const char szPrj[] =
+		"PROJCS[\"WGS_1984_UTM_Zone_31N\",GEOGCS[\"GCS_WGS_1984\",DATUM[\"D_WGS_1984\",SPHEROID[\"WGS_1984\",6378137.0,298.257223563]],"
+		"PRIMEM[\"Greenwich\",0.0],UNIT[\"Degree\",0.0174532925199433]],PROJECTION[\"Transverse_Mercator\"],PARAMETER[\"False_Easting\",500000.0],"
+		"PARAMETER[\"False_Northing\",0.0],PARAMETER[\"Central_Meridian\",3.0],PARAMETER[\"Scale_Factor\",0.9996],"
+		"PARAMETER[\"Latitude_Of_Origin\",0.0],UNIT[\"Meter\",1.0]]";
+	const int nColumns = (int) ceil( sqrt( (double) nTiles ) );
+	bool bSuccess = ( ::VSIMkdir(sRoot.c_str(), 0755) == 0 );
+	std::string sDirName = sRoot;
+
+	aoGeoRefs.resize(nTiles);
+	nFiles = 0;
+
+	for( int i = 0; bSuccess && i < nTiles; i++ )
+		{
+		const int nColumn = i % nColumns, nRow = i / nColumns;
+		const int nQuadrant = ( i / 4 ) % 4;
+		DatasetGeoRef& oGeoRef = aoGeoRefs[i];
+
+		oGeoRef.nRasterXSize = 16;
+		oGeoRef.nRasterYSize = 16;
+		oGeoRef.adfGeoTransform[0] = ( ( nQuadrant & 1 ) ? -1.0 : 1.0 ) * ( 500000.0 + nColumn * 1000.0 );
+		oGeoRef.adfGeoTransform[1] = 62.5;
+		oGeoRef.adfGeoTransform[2] = 0.0;
+		oGeoRef.adfGeoTransform[3] = ( ( nQuadrant & 2 ) ? -1.0 : 1.0 ) * ( 5000000.0 + nRow * 1000.0 );
+		oGeoRef.adfGeoTransform[4] = 0.0;
+		oGeoRef.adfGeoTransform[5] = -62.5;
+
+		if ( bNested && nColumn == 0 )
+			{
+			sDirName = sRoot + sDirSep + CPLSPrintf("r%05d", nRow);
+			bSuccess = ( ::VSIMkdir(sDirName.c_str(), 0755) == 0 );
+			}
 
-	std::string inputExt = ::CPLGetExtension(inputFile.c_str());
+		std::string sBasePath = sDirName + sDirSep + CPLSPrintf("tile_%07d", i);
 
-	std::string wfExt = inputExt.substr(0,1) + inputExt.substr(2,1) + 'w';
+		switch ( i % 4 )
+			{
+			case 0 :
+				bSuccess = bSuccess && writeSyntheticTiff(sBasePath + ".tif", oGeoRef, true);
+				nFiles += 1;
+				break;
+			case 1 :
+				bSuccess = bSuccess && writeSyntheticTiff(sBasePath + ".tif", oGeoRef, true) &&
+						   writeBenchmarkFile(sBasePath + ".prj", szPrj, sizeof(szPrj) - 1);
+				nFiles += 2;
+				break;
+			case 2 :
+				bSuccess = bSuccess && writeSyntheticTiff(sBasePath + ".tif", oGeoRef, false) &&
+						   writeSyntheticWorldFile(sBasePath + ".tfw", oGeoRef) &&
+						   writeBenchmarkFile(sBasePath + ".prj", szPrj, sizeof(szPrj) - 1);
+				nFiles += 3;
+				break;
+			default :
+				bSuccess = bSuccess && writeSyntheticJP2(sBasePath + ".jp2", oGeoRef) &&
+						   writeSyntheticWorldFile(sBasePath + ".j2w", oGeoRef) &&
+						   writeBenchmarkFile(sBasePath + ".prj", szPrj, sizeof(szPrj) - 1);
+				nFiles += 3;
+				break;
+			}
+		}
 
-	return wfExt;
+	return bSuccess;
 	}
 
+//***********************************************************************//
+//!Print a benchmark result and keep it for the JSON output
+//***********************************************************************//
+static void addBenchmarkResult(std::vector<BenchmarkResult>& aoResults, int nTiles, const std::string& sLayout, const char* pszStage,
+							   GIntBig nFiles, double dfSeconds, GIntBig nSyscalls)
+	{
+	BenchmarkResult oResult;
+	oResult.nTiles = nTiles;
+	oResult.sLayout = sLayout;
+	oResult.sStage = pszStage;
+	oResult.nFiles = nFiles;
+	oResult.dfSeconds = dfSeconds;
+	oResult.nSyscalls = nSyscalls;
+	aoResults.push_back(oResult);
+
+	printf("%-9d %-7s %-22s %10d %10.3f %12.0f %14s\n", nTiles, sLayout.c_str(), pszStage, (int) nFiles, dfSeconds,
+		   dfSeconds > 0.0 ? nFiles / dfSeconds : 0.0, nSyscalls < 0 ? "-" : CPLSPrintf("%.2f", nFiles > 0 ? (double) nSyscalls / nFiles : 0.0));
+	fflush(stdout);
+	}
 
 //***********************************************************************//
-//!Get an array of sibling files extensions of a dataset (ie: tfw, prj
-//!for a tif file). Need to be populated for other datasets !!!
+//!Run the batch pipeline on a synthetic tree for the benchmark, with
+//!the statistics of the run collected (and the console output discarded)
 //***********************************************************************//
-std::vector<std::string> getSiblingFilesExt (std::string inputFile)
+static bool runBenchmarkBatch(const std::string& sRoot, int nThreads, char** papszExtensions, const RenameOptions& oOptions, RunStats& oStats)
 	{
-	std::vector<std::string> siblingFilesExt;
-	std::string inputExt = ::CPLGetExtension(inputFile.c_str());
+	std::vector<std::string> aosInputPaths(1, sRoot);
+	BatchContext oContext;
 
-	siblingFilesExt.push_back(getWorldFileExt(inputFile));
+	//the errors of the datasets are counted, not printed
+	::CPLPushErrorHandler(CPLQuietErrorHandler);
+	setRunStats(&oStats);
+	runBatch(aosInputPaths, false, false, false, 0.0, nThreads, papszExtensions, oOptions, NULL, oContext);
+	setRunStats(NULL);
+	::CPLPopErrorHandler();
 
-	if ( EQUAL(inputExt.c_str(), "tif"))
-		{ siblingFilesExt.push_back("prj"); }
+	if ( !oContext.aosFailures.empty() )
+		{ ::CPLError(CE_Warning, CPLE_AppDefined, "%d dataset(s) of \"%s\" not renamed", (int) oContext.aosFailures.size(), sRoot.c_str()); }
 
-	if ( EQUAL(inputExt.c_str(), "ecw"))
-		{ siblingFilesExt.push_back("ers"); }
+	return oContext.aosFailures.empty();
+	}
 
-	if ( EQUAL(inputExt.c_str(), "img"))
+//***********************************************************************//
+//!Time the cold start of scripted per file runs : a gdal_rename process
+//!per dataset of the tree (dry run of one file) with the given drivers
+//!registration (--drivers), up to GDAL_RENAME_BENCHMARK_STARTUP processes
+//***********************************************************************//
+static bool runBenchmarkStartup(const char* pszExecutable, const std::string& sRoot, const char* pszDrivers, GIntBig& nRuns, double& dfSeconds)
+	{
+	char **papszFiles = ::VSIReadDirRecursive(sRoot.c_str());
+	const char *pszOutput = "/vsimem/gdal_rename_benchmark_startup.txt";
+	VSILFILE *fpOutput = ::VSIFOpenL(pszOutput, "wb");
+	bool bSuccess = ( fpOutput != NULL );
+	double dfStart = RunStats::GetTime();
+
+	nRuns = 0;
+	for( int i = 0; bSuccess && papszFiles != NULL && papszFiles[i] != NULL && nRuns < GDAL_RENAME_BENCHMARK_STARTUP; i++ )
 		{
-		siblingFilesExt.push_back("led");
-		siblingFilesExt.push_back("nul");
-		siblingFilesExt.push_back("trl");
-		siblingFilesExt.push_back("vol");
-		}
-
-	if ( EQUAL(inputExt.c_str(), "jp2") || EQUAL(inputExt.c_str(), "j2k"))
-		{ siblingFilesExt.push_back("prj"); }
-
-	return siblingFilesExt;
-	}
+		const char *pszExt = ::CPLGetExtension(papszFiles[i]);
 
+		if ( !EQUAL(pszExt, "tif") && !EQUAL(pszExt, "jp2") )
+			{ continue; }
 
+		std::string sFile = sRoot + sDirSep + papszFiles[i];
+		const char *apszArgv[] = { pszExecutable, "--drivers", pszDrivers, "--output-console", "unix", sFile.c_str(), NULL };
 
-/************************************************************************/
-/*                               Usage()                                */
-/************************************************************************/
-static void Usage(const char* pszErrorMsg)
-	{
-    printf( "Usage: gdal_rename [--help|-h] [--input-file-to-rename|-i] [--refpoint|-r]\n"
-			"                   { [--coord-zero-padding|-z] [--coord-length|-l]\n"
-			"                     [--coord-type|-t] [--coord-sep|-s] [--prefix|-p]\n"
-			"                     [--suffix|-s] } | { [--printf-syntax|-f] }\n"
-			"					[--output-console|-o]\n"
-			"					dataset_to_rename\n\n\n" );
+		bSuccess = ( ::CPLSpawn(apszArgv, NULL, fpOutput, TRUE) == 0 );
+		nRuns++;
+		}
+	dfSeconds = RunStats::GetTime() - dfStart;
 
-    printf( " --help|-h: print this message\n"
-			" --refpoint|-r: Ref point to use in the name. Any pair of 'W', 'E' and 'N',\n"
-			"                'S' (ie: WN, NW, EN, NE, WS, SW, ES, SE).\n"
-			" --prefix|-p: Prefix to use for the new file name format (ie: \n"
-			"              Prefix_XXXXXXXXXXX.EXT)\n"
-			" --coord-length|-l: number of digits to use in coordinates value starting with\n"
-			"                    high wheight digits (ie: using 4 with easting value of \n"
-			"                    621000.0 will print 06210 with zero padding and \n"
-			"                    6210 without)\n"
-			" --coord-decimal-length|-d: number of digits to use in decimal part for real coordinates\n"
-			" --coord-zero-padding|-z: wether or not padding coordinate with 0 if inequal \n"
-			"                          number of digits between easting and northing\n \n"
-			" --coord-type|-t: 'int' or 'real' used to format coordinates\n"
-			" --coord-sign|-g: 'std': sign printed if negative, 'force': allways printed (+/-) or 'geo': hemisphere display E-W or N-S\n"
-			" --coord-sep|-s: separator of coordinates components when formating\n"
-			" --suffix|-x: suffix to use for the new file name format (ie: \n"
-			"              XXXXXXXXXXX_suffix.EXT)\n"
-			" --printf-syntax|-f: a string with printf syntax instead of all the previous parameters\n"
-			"                     (ie: Tiles_%.4d-%.4d_Lambert93) /!\ no syntaxic check\n"
-			"                     and only 2 substitution allowed for easting/northing\n"
-			" --output-console|-o: a string must be \"win\" or \"unix\".\n"
-			"                     If specified, print (in the console) the command to\n"
-			"                     perform the rename instead of doing it. It allow the user to\n"  
-			"                     create a batch file using system console redirection operator\n"
-			"                     like '>', '>>', '|'...\n");
+	if ( fpOutput != NULL )
+		{ ::VSIFCloseL(fpOutput); }
+	::VSIUnlink(pszOutput);
+	::CSLDestroy(papszFiles);
 
-    if( pszErrorMsg != NULL )
-        fprintf(stderr, "\nFAILURE: %s\n", pszErrorMsg);
+	if ( !bSuccess )
+		{ ::CPLError(CE_Warning, CPLE_AppDefined, "Startup run of \"%s\" with --drivers %s failed", pszExecutable, pszDrivers); }
 
-    exit( 1 );
+	return bSuccess;
 	}
 
 //***********************************************************************//
-//!Check whether or not the given refpoint is good
+//!Benchmark the rename path : for each number of tiles (ie: 1k,100k,1M)
+//!and layout (flat, nested) a synthetic tile tree is generated in the
+//!work directory, then getCoord, the name formatting, a dry run
+//!(--output-console), the cold start of per file processes (all drivers
+//!or --drivers auto), the end to end renames and renameFileNoOverWrite
+//!are timed. The results are printed as files/s and syscalls/file (and
+//!written as JSON in pszStats if given). The trees are removed at the end
 //***********************************************************************//
-bool checkRefPoint(const char* CoordRefPoint)
+int runBenchmark(const char* pszExecutable, const char* pszWorkDir, const char* pszTiles, const char* pszLayouts, int nThreads, const RenameOptions& oOptions, const char* pszStats)
 	{
-	bool Success = false;
+	char **papszTiles = ::CSLTokenizeString2( pszTiles, ",", 0 );
+	char **papszLayouts = ::CSLTokenizeString2( pszLayouts, ",", 0 );
+	char **papszExtensions = ::CSLTokenizeString2( "tif,jp2", ",", 0 );
+	std::vector<BenchmarkResult> aoResults;
+	bool bSuccess = true;
+	::VSIStatBufL psStatBuf;
 
-	if ( strlen(CoordRefPoint)==2)
+	::VSIMkdir(pszWorkDir, 0755);
+
+	printf("%-9s %-7s %-22s %10s %10s %12s %14s\n", "tiles", "layout", "stage", "files", "seconds", "files/s", "syscalls/file");
+
+	for( int iTiles = 0; papszTiles != NULL && papszTiles[iTiles] != NULL; iTiles++ )
 		{
-		if ( EQUAL(CoordRefPoint, "WN" ) || EQUAL(CoordRefPoint, "EN" ) || EQUAL(CoordRefPoint, "NW" ) || EQUAL(CoordRefPoint, "NE" ) ||
-			 EQUAL(CoordRefPoint, "WS" ) || EQUAL(CoordRefPoint, "ES" ) || EQUAL(CoordRefPoint, "SW" ) || EQUAL(CoordRefPoint, "ES" ) )
-			{ Success = true ; }
+		//1000, 100k or 1M
+		char *pszEnd = NULL;
+		double dfTiles = strtod(papszTiles[iTiles], &pszEnd);
+		if ( pszEnd != NULL && ( *pszEnd == 'k' || *pszEnd == 'K' ) )
+			{ dfTiles *= 1e3; }
+		else if ( pszEnd != NULL && *pszEnd == 'M' )
+			{ dfTiles *= 1e6; }
+		int nTiles = (int) dfTiles;
+
+		if ( nTiles <= 0 )
+			{
+			::CPLError(CE_Failure, CPLE_IllegalArg, "Invalid number of tiles '%s'", papszTiles[iTiles]);
+			bSuccess = false;
+			continue;
+			}
+
+		for( int iLayout = 0; papszLayouts != NULL && papszLayouts[iLayout] != NULL; iLayout++ )
+			{
+			std::string sLayout = papszLayouts[iLayout];
+			std::string sRoot = std::string(pszWorkDir) + sDirSep + CPLSPrintf("%s_%d", sLayout.c_str(), nTiles);
+			std::vector<DatasetGeoRef> aoGeoRefs;
+			GIntBig nFiles = 0;
+
+			if ( !EQUAL(sLayout.c_str(), "flat") && !EQUAL(sLayout.c_str(), "nested") )
+				{
+				::CPLError(CE_Failure, CPLE_IllegalArg, "Invalid benchmark layout '%s' (flat or nested)", sLayout.c_str());
+				bSuccess = false;
+				continue;
+				}
+
+			//never written over existing files
+			if ( ::VSIStatExL(sRoot.c_str(), &psStatBuf, VSI_STAT_EXISTS_FLAG) == 0 )
+				{
+				::CPLError(CE_Failure, CPLE_AppDefined, "\"%s\" already exists, remove it or use another work directory", sRoot.c_str());
+				bSuccess = false;
+				continue;
+				}
+
+			double dfStart = RunStats::GetTime();
+			if ( !generateSyntheticTiles(sRoot, nTiles, EQUAL(sLayout.c_str(), "nested"), aoGeoRefs, nFiles) )
+				{
+				::CPLError(CE_Failure, CPLE_FileIO, "Unable to generate the tiles in \"%s\"", sRoot.c_str());
+				::VSIRmdirRecursive(sRoot.c_str());
+				bSuccess = false;
+				continue;
+				}
+			addBenchmarkResult(aoResults, nTiles, sLayout, "generate", nFiles, RunStats::GetTime() - dfStart, -1);
+
+			//in memory stages, repeated up to 1M tiles so they last long enough to be measured
+			const int nRepeat = std::max(1, 1000000 / nTiles);
+			const char chRefPointX = (char) toupper(oOptions.pszCoordRefPoint[0]);
+			const char chRefPointY = (char) toupper(oOptions.pszCoordRefPoint[1]);
+			volatile double dfSum = 0.0;
+			std::string sName;
+
+			dfStart = RunStats::GetTime();
+			for( int iRepeat = 0; iRepeat < nRepeat; iRepeat++ )
+				{
+				for( size_t i = 0; i < aoGeoRefs.size(); i++ )
+					{ dfSum = dfSum + getCoord(chRefPointX, aoGeoRefs[i]) + getCoord(chRefPointY, aoGeoRefs[i]); }
+				}
+			addBenchmarkResult(aoResults, nTiles, sLayout, "getCoord", (GIntBig) nTiles * nRepeat, RunStats::GetTime() - dfStart, 0);
+
+			dfStart = RunStats::GetTime();
+			for( int iRepeat = 0; iRepeat < nRepeat; iRepeat++ )
+				{
+				for( size_t i = 0; i < aoGeoRefs.size(); i++ )
+					{
+					sName.clear();
+					oOptions.poNameTemplate->Render(aoGeoRefs[i], sName);
+					}
+				}
+			addBenchmarkResult(aoResults, nTiles, sLayout, "name_format", (GIntBig) nTiles * nRepeat, RunStats::GetTime() - dfStart, 0);
+
+			//the same names by groups, as the batch mode workers compute them (the
+			//groups are filled while the datasets are read)
+			std::vector<TileExtents> aoExtents( (aoGeoRefs.size() + GDAL_RENAME_NAME_GROUP - 1) / GDAL_RENAME_NAME_GROUP );
+			std::vector<double> adfCoordsX, adfCoordsY;
+			std::vector<std::string> asNames;
+
+			for( size_t i = 0; i < aoGeoRefs.size(); i++ )
+				{ aoExtents[i / GDAL_RENAME_NAME_GROUP].Add(aoGeoRefs[i]); }
+
+			dfStart = RunStats::GetTime();
+			for( int iRepeat = 0; iRepeat < nRepeat; iRepeat++ )
+				{
+				for( size_t i = 0; i < aoExtents.size(); i++ )
+					{
+					oOptions.poNameTemplate->GetCoordsBatch(aoExtents[i], adfCoordsX, adfCoordsY);
+					oOptions.poNameTemplate->RenderBatch(adfCoordsX, adfCoordsY, asNames);
+					}
+				}
+			addBenchmarkResult(aoResults, nTiles, sLayout, "name_format_batch", (GIntBig) nTiles * nRepeat, RunStats::GetTime() - dfStart, 0);
+
+			//dry run : commands formatted then discarded, nothing renamed
+			RenameOptions oDryRunOptions = oOptions;
+			CommandWriter oDryRunWriter;
+			oDryRunWriter.Open("unix", NULL);
+			oDryRunOptions.pszOutputConsole = "unix";
+			oDryRunOptions.poCommandWriter = &oDryRunWriter;
+			RunStats oDryRunStats;
+			bSuccess = runBenchmarkBatch(sRoot, nThreads, papszExtensions, oDryRunOptions, oDryRunStats) && bSuccess;
+			addBenchmarkResult(aoResults, nTiles, sLayout, "dry_run", oDryRunStats.GetCount(COUNTER_DATASETS),
+							   oDryRunStats.GetElapsed(), oDryRunStats.GetSyscalls());
+
+			//per file processes, as scripted runs do (seconds/files is the cold start of one run)
+			GIntBig nRuns = 0;
+			double dfSeconds = 0.0;
+			bSuccess = runBenchmarkStartup(pszExecutable, sRoot, "all", nRuns, dfSeconds) && bSuccess;
+			addBenchmarkResult(aoResults, nTiles, sLayout, "startup_all_drivers", nRuns, dfSeconds, -1);
+			bSuccess = runBenchmarkStartup(pszExecutable, sRoot, "auto", nRuns, dfSeconds) && bSuccess;
+			addBenchmarkResult(aoResults, nTiles, sLayout, "startup_auto_drivers", nRuns, dfSeconds, -1);
+
+			//end to end renames
+			RenameOptions oRenameOptions = oOptions;
+			oRenameOptions.pszOutputConsole = "";
+			RunStats oRenameStats;
+			bSuccess = runBenchmarkBatch(sRoot, nThreads, papszExtensions, oRenameOptions, oRenameStats) && bSuccess;
+			addBenchmarkResult(aoResults, nTiles, sLayout, "rename", oRenameStats.GetCount(COUNTER_DATASETS),
+							   oRenameStats.GetElapsed(), oRenameStats.GetSyscalls());
+
+			//renameFileNoOverWrite alone, on all the files (datasets and siblings)
+			char **papszFiles = ::VSIReadDirRecursive(sRoot.c_str());
+			SiblingIndex oSiblingIndex(true);
+			RunStats oFileStats;
+			GIntBig nRenamed = 0;
+
+			setRunStats(&oFileStats);
+			for( int i = 0; papszFiles != NULL && papszFiles[i] != NULL; i++ )
+				{
+				std::string sFile = sRoot + sDirSep + papszFiles[i];
+
+				//directories are listed with a trailing separator
+				if ( sFile[sFile.length()-1] == '/' || sFile[sFile.length()-1] == '\\' )
+					{ continue; }
+
+				std::string sNewFile = std::string(::CPLGetDirname(sFile.c_str())) + sDirSep + "b_" + ::CPLGetFilename(sFile.c_str());
+				if ( renameFileNoOverWrite(sFile, sNewFile, oSiblingIndex) )
+					{ nRenamed++; }
+				}
+			setRunStats(NULL);
+			::CSLDestroy(papszFiles);
+			addBenchmarkResult(aoResults, nTiles, sLayout, "renameFileNoOverWrite", nRenamed, oFileStats.GetElapsed(), oFileStats.GetSyscalls());
+
+			::VSIRmdirRecursive(sRoot.c_str());
+			}
 		}
 
-	return Success;
-	}
+	::CSLDestroy(papszTiles);
+	::CSLDestroy(papszLayouts);
+	::CSLDestroy(papszExtensions);
 
-//***********************************************************************//
-//!format the rename command line for output in the console
-//***********************************************************************//
-std::string formatRenameCmdLine(const char* pszSystemType, const char* pszSourceName, const char* pszNewName)
-	{
-	bool Success = false;
-	const char* pszCommand = "move";
-	std::string sCommandLine;
+	if ( pszStats != NULL )
+		{
+		FILE *fpStats = EQUAL(pszStats, "-") ? stdout : fopen(pszStats, "wb");
 
-	if ( EQUAL(pszSystemType, "unix") )
-		{ pszCommand = "mv"; }
+		if ( fpStats == NULL )
+			{
+			::CPLError(CE_Failure, CPLE_OpenFailed, "Unable to create the statistics file \"%s\"", pszStats);
+			return 1;
+			}
+
+		fprintf(fpStats, "{\n  \"benchmark\": [");
+		for( size_t i = 0; i < aoResults.size(); i++ )
+			{
+			const BenchmarkResult& oResult = aoResults[i];
 
-	sCommandLine += pszCommand;
-	sCommandLine += " \"";
-	sCommandLine += pszSourceName;
-	sCommandLine += "\" \"";
-	sCommandLine += pszNewName;
-	sCommandLine += "\"\n";
+			fprintf(fpStats, "%s\n    {\"tiles\": %d, \"layout\": \"%s\", \"stage\": \"%s\", \"files\": " CPL_FRMT_GIB ", \"seconds\": %.6f, \"files_per_second\": %.3f, ",
+					i > 0 ? "," : "", oResult.nTiles, oResult.sLayout.c_str(), oResult.sStage.c_str(), oResult.nFiles, oResult.dfSeconds,
+					oResult.dfSeconds > 0.0 ? oResult.nFiles / oResult.dfSeconds : 0.0);
 
-	return sCommandLine.c_str();
+			if ( oResult.nSyscalls < 0 )
+				{ fprintf(fpStats, "\"syscalls_per_file\": null}"); }
+			else
+				{ fprintf(fpStats, "\"syscalls_per_file\": %.3f}", oResult.nFiles > 0 ? (double) oResult.nSyscalls / oResult.nFiles : 0.0); }
+			}
+		fprintf(fpStats, "\n  ]\n}\n");
+
+		if ( fpStats != stdout )
+			{ fclose(fpStats); }
+		}
+
+	return bSuccess ? 0 : 1;
 	}
 
 //#######################################################################//
@@ -327,228 +903,457 @@ std::string formatRenameCmdLine(const char* pszSystemType, const char* pszSource
 //#######################################################################//
 int main(int argc, char* argv[])
 	{
+	//the run statistics start with the driver registration
+	RunStats oRunStats;
+
 	//for --config options
     ::EarlySetConfigOptions(argc, argv);
 
-    ::GDALAllRegister();
+	//the drivers are registered once the options are known (--drivers), except
+	//for the general options listing them
+	bool bAllRegistered = false;
+	for( int i = 1; i < argc && !bAllRegistered; i++ )
+		{
+		if ( EQUAL(argv[i], "--formats") || EQUAL(argv[i], "--format") )
+			{
+			::GDALAllRegister();
+			bAllRegistered = true;
+			}
+		}
 
-	const char *pszFilePath = "Test.tif";
-	const char *pszCoordRefPoint = "WN"; // any Easting/Northing pair combination in the following list N, E, S, W
-	bool		pszCoordPadding = true;
+	RenameOptions oOptions;
 	bool		printUsage = false;
-	const char *pszCoordLenght = "7";
-	const char *pszCoordDecLenght = "3";
-	const char *pszCoordType = ""; //"reel"
-	const char *pszCoordSignType = "std"; // "std , force or geo"
-	const char *pszCoordSep = "_";
-	const char *pszPrefix = "";
-	const char *pszSuffix = "";
-	const char *pszPrintf= ""; // printf syntax for the whole renaming string ex: "Tile_%.4d_%.4d_SRS" /!\ no syntax check
-	const char *pszOutputConsole = "";	//"win" or "unix"
+	const char *pszThreads = "ALL_CPUS"; // number of worker threads in batch mode
+	const char *pszExtensions = "tif,tiff,jp2,j2k,ecw,img"; // datasets extensions looked for in directories
+	const char *pszDrivers = "all"; // "all", "auto" or comma separated GDAL drivers registered
+	const char *pszRenameBackend = "auto"; // "auto", "vsi", "renameat2" or "io_uring"
+	const char *pszJournal = NULL; // journal of the renames
+	const char *pszTransferThreads = "4"; // number of copy threads of the moves across file systems
+	const char *pszGeoRefCache = NULL; // persistent georeferencing cache file
+	const char *pszTileIndex = NULL; // tile index of the renamed datasets
+	const char *pszTileIndexFormat = NULL; // "GPKG" or "FlatGeobuf", from the extension by default
+	const char *pszStats = NULL; // JSON statistics file, "-" for stdout
+	double		dfProgressInterval = 0.0; // seconds between progress lines, 0 for none
+	const char *pszBenchmarkDir = NULL; // work directory of the benchmark
+	const char *pszBenchmarkTiles = "1k,100k"; // numbers of tiles of the benchmark trees
+	const char *pszBenchmarkLayouts = "flat,nested"; // layouts of the benchmark trees
+	bool		bResume = false;
+	bool		bRollback = false;
+	bool		bFromStdin = false;
+	bool		bNulDelimited = false;
+	bool		bWatch = false;
+	bool		bArchive = false;
+	bool		bCheckDuplicates = false;
+	double		dfCheckMemory = GDAL_RENAME_CHECK_MEMORY; // MB of targets held in memory by --check-duplicates
+	double		dfWatchSettle = GDAL_RENAME_WATCH_SETTLE; // seconds without write before a watched dataset is renamed
+	TileGrid	oTileGrid; // grid of the {col} and {row} fields
+	bool		bHasGrid = false;
+	std::vector<std::string> aosInputPaths;
 
     argc = ::GDALGeneralCmdLineProcessor( argc, &argv, 0 );
 
     if( argc > 1 )
 		{
-		for( int i = 0; argv != NULL && argv[i] != NULL; i++ )
+		for( int i = 1; argv != NULL && argv[i] != NULL; i++ )
 			{
+			bool bHasValue = ( i + 1 < argc );
+
 			if( EQUAL(argv[i], "--help") || EQUAL(argv[i], "-h") )
 				{ printUsage = true; }
 
-			if( EQUAL(argv[i], "--refpoint") || EQUAL(argv[i], "-r") ) //WN, WS, EN, ES
+			else if( (EQUAL(argv[i], "--refpoint") || EQUAL(argv[i], "-r")) && bHasValue ) //WN, WS, EN, ES
 				{
-				pszCoordRefPoint = argv[i+1];
+				oOptions.pszCoordRefPoint = argv[++i];
+
+				if ( !checkRefPoint(oOptions.pszCoordRefPoint) )
+					{ oOptions.pszCoordRefPoint = "WN"; } // Top Left by default
+				}
+
+			else if( EQUAL(argv[i], "--coord-zero-padding") || EQUAL(argv[i], "-z") )
+				{ oOptions.pszCoordPadding = true; }
+
+			else if( (EQUAL(argv[i], "--coord-length") || EQUAL(argv[i], "-l")) && bHasValue ) // number of digits for coord to use for renaming
+				{ oOptions.pszCoordLenght = argv[++i]; }												  // /!\ if integer and less than number removed by right
+
+			else if( (EQUAL(argv[i], "--coord-decimal-length") || EQUAL(argv[i], "-d")) && bHasValue ) // size of number of coord to use for renaming /!\ if less than number removed by right
+				{ oOptions.pszCoordDecLenght = argv[++i]; }
+
+			else if( (EQUAL(argv[i], "--coord-type") || EQUAL(argv[i], "-t")) && bHasValue ) // int or "real", default "int"
+				{ oOptions.pszCoordType = argv[++i]; }
+
+			else if( (EQUAL(argv[i], "--coord-sign") || EQUAL(argv[i], "-g")) && bHasValue ) //"std": sign printed if negative, "force": +/- or "geo": N/S - E/W, default "std"
+				{ oOptions.pszCoordSignType = argv[++i]; }
 
-				if ( !checkRefPoint(pszCoordRefPoint) )
-					{ pszCoordRefPoint = "WN"; } // Top Left by default
+			else if( (EQUAL(argv[i], "--coord-sep") || EQUAL(argv[i], "-s")) && bHasValue ) //any string
+				{ oOptions.pszCoordSep = argv[++i]; }
+
+			else if( (EQUAL(argv[i], "--prefix") || EQUAL(argv[i], "-p")) && bHasValue ) //any string
+				{ oOptions.pszPrefix = argv[++i]; }
+
+			else if( (EQUAL(argv[i], "--suffix") || EQUAL(argv[i], "-x")) && bHasValue ) //any string
+				{ oOptions.pszSuffix = argv[++i]; }
+
+			else if( (EQUAL(argv[i], "--printf-syntax") || EQUAL(argv[i], "-f")) && bHasValue ) // use instead of --coord-sign, --coord-padding, --coord-type, --coord-lenght, --prefix, --suffix
+				{ oOptions.pszPrintf = argv[++i]; }
+
+			else if( (EQUAL(argv[i], "--name-template") || EQUAL(argv[i], "-n")) && bHasValue ) // ex: "{prefix}{x:07d}{sep}{y:07d}", use instead of all the naming options
+				{ oOptions.pszNameTemplate = argv[++i]; }
+
+			else if( EQUAL(argv[i], "--target-srs") && bHasValue ) //any OSRSetFromUserInput definition, ex: "EPSG:4326"
+				{ oOptions.pszTargetSRS = argv[++i]; }
+
+			else if( EQUAL(argv[i], "--grid") && bHasValue ) //"auto" or "origin_x,origin_y,tile_size_x,tile_size_y"
+				{
+				bHasGrid = true;
+				if ( !parseTileGrid(argv[++i], oTileGrid) )
+					{ Usage(CPLSPrintf("Invalid tiles grid '%s'", argv[i])); }
 				}
 
-			if( EQUAL(argv[i], "--coord-zero-padding") || EQUAL(argv[i], "-z") )
-				{ pszCoordPadding = true; }
+			else if( EQUAL(argv[i], "--offgrid-suffix") && bHasValue ) //any string, default "_offgrid"
+				{ oOptions.pszOffGridSuffix = argv[++i]; }
+
+			else if( (EQUAL(argv[i], "--output-console")|| EQUAL(argv[i], "-o")) && bHasValue ) //"win" or "unix", default empty, performing the rename on the console instead of the file system
+				{ oOptions.pszOutputConsole = argv[++i]; }
+
+			else if( (EQUAL(argv[i], "--threads") || EQUAL(argv[i], "-j")) && bHasValue ) //number of threads or "ALL_CPUS", default "ALL_CPUS"
+				{ pszThreads = argv[++i]; }
+
+			else if( (EQUAL(argv[i], "--extensions") || EQUAL(argv[i], "-e")) && bHasValue ) //comma separated list, default "tif,tiff,jp2,j2k,ecw,img"
+				{ pszExtensions = argv[++i]; }
+
+			else if( EQUAL(argv[i], "--drivers") && bHasValue ) //"all", "auto" or comma separated list (ie: "GTiff,JP2OpenJPEG"), default "all"
+				{ pszDrivers = argv[++i]; }
+
+			else if( EQUAL(argv[i], "--no-fast-georef") ) //always use GDALOpen to read the georeferencing
+				{ oOptions.bFastGeoRef = false; }
+
+			else if( EQUAL(argv[i], "--output-dir") && bHasValue ) //existing directory the datasets are moved to
+				{ oOptions.pszOutputDir = argv[++i]; }
+
+			else if( EQUAL(argv[i], "--transfer-threads") && bHasValue ) //number of copy threads, default 4
+				{ pszTransferThreads = argv[++i]; }
+
+			else if( EQUAL(argv[i], "--rename-backend") && bHasValue ) //"auto", "vsi", "renameat2" or "io_uring", default "auto"
+				{ pszRenameBackend = argv[++i]; }
+
+			else if( (EQUAL(argv[i], "--journal") || EQUAL(argv[i], "--resume") || EQUAL(argv[i], "--rollback")) && bHasValue ) //journal file path
+				{
+				bResume = EQUAL(argv[i], "--resume");
+				bRollback = EQUAL(argv[i], "--rollback");
+				pszJournal = argv[++i];
+				}
+
+			else if( EQUAL(argv[i], "--georef-cache") && bHasValue ) //cache file path, created if missing
+				{ pszGeoRefCache = argv[++i]; }
+
+			else if( EQUAL(argv[i], "--tile-index") && bHasValue ) //tile index file, must not exist
+				{ pszTileIndex = argv[++i]; }
+
+			else if( EQUAL(argv[i], "--tile-index-format") && bHasValue ) //"GPKG" or "FlatGeobuf"
+				{ pszTileIndexFormat = argv[++i]; }
+
+			else if( EQUAL(argv[i], "--stats") && bHasValue ) //JSON statistics file, "-" for stdout
+				{ pszStats = argv[++i]; }
+
+			else if( EQUAL(argv[i], "--progress") && bHasValue ) //seconds between progress lines on stderr
+				{ dfProgressInterval = ::CPLAtof(argv[++i]); }
+
+			else if( EQUAL(argv[i], "--benchmark") && bHasValue ) //work directory, synthetic trees generated and removed there
+				{ pszBenchmarkDir = argv[++i]; }
+
+			else if( EQUAL(argv[i], "--benchmark-tiles") && bHasValue ) //comma separated numbers of tiles (ie: 1k,100k,1M)
+				{ pszBenchmarkTiles = argv[++i]; }
+
+			else if( EQUAL(argv[i], "--benchmark-layout") && bHasValue ) //"flat", "nested" or "flat,nested"
+				{ pszBenchmarkLayouts = argv[++i]; }
 
-			if( EQUAL(argv[i], "--coord-length") || EQUAL(argv[i], "-l") ) // number of digits for coord to use for renaming
-				{ pszCoordLenght = argv[i+1]; }							   // /!\ if integer and less than number removed by right
+			else if( EQUAL(argv[i], "--plan") )
+				{ oOptions.bPlanRenames = true; }
 
-			if( EQUAL(argv[i], "--coord-decimal-length") || EQUAL(argv[i], "-d") ) // size of number of coord to use for renaming /!\ if less than number removed by right
-				{ pszCoordDecLenght = argv[i+1]; }
+			else if( EQUAL(argv[i], "--from-stdin") ) //datasets paths read from stdin, one per line
+				{ bFromStdin = true; }
 
-			if( EQUAL(argv[i], "--coord-type") || EQUAL(argv[i], "-t") ) // int or "real", default "int"
-				{ pszCoordType = argv[i+1]; }
+			else if( EQUAL(argv[i], "-0") || EQUAL(argv[i], "--null") ) //stdin paths are NUL delimited (find -print0)
+				{ bNulDelimited = true; }
 
-			if( EQUAL(argv[i], "--coord-sign") || EQUAL(argv[i], "-g")  ) //"std": sign printed if negative, "force": +/- or "geo": N/S - E/W, default "std"
-				{ pszCoordSignType = argv[i+1]; }
+			else if( EQUAL(argv[i], "--watch") ) //rename the datasets written to the input directories until Ctrl+C
+				{ bWatch = true; }
 
-			if( EQUAL(argv[i], "--coord-sep") || EQUAL(argv[i], "-s") ) //any string
-				{ pszCoordSep = argv[i+1]; }
+			else if( EQUAL(argv[i], "--watch-settle") && bHasValue ) //seconds, default 0.2
+				{ dfWatchSettle = ::CPLAtof(argv[++i]); }
 
-			if( EQUAL(argv[i], "--prefix") || EQUAL(argv[i], "-p") ) //any string
-				{ pszPrefix = argv[i+1]; }
+			else if( EQUAL(argv[i], "--archive") ) //the inputs are ZIP or TAR archives whose entries are renamed
+				{ bArchive = true; }
 
-			if( EQUAL(argv[i], "--suffix") || EQUAL(argv[i], "-x") ) //any string
-				{ pszSuffix = argv[i+1]; }
+			else if( EQUAL(argv[i], "--check-duplicates") ) //report the targets of several datasets, nothing renamed
+				{ bCheckDuplicates = true; }
 
-			if( EQUAL(argv[i], "--printf-syntax") || EQUAL(argv[i], "-f") ) // use instead of --coord-sign, --coord-padding, --coord-type, --coord-lenght, --prefix, --suffix
-				{ pszPrintf = argv[i+1]; }
+			else if( EQUAL(argv[i], "--check-memory") && bHasValue ) //MB, default 512
+				{ dfCheckMemory = ::CPLAtof(argv[++i]); }
 
-			if( EQUAL(argv[i], "--output-console")|| EQUAL(argv[i], "-o")  ) //"win" or "unix", default empty, performing the rename on the console instead of the file system
-				{ pszOutputConsole = argv[i+1]; }
+			else if( argv[i][0] == '-' && argv[i][1] != '\0' )
+				{ Usage(CPLSPrintf("Unknown option name '%s'", argv[i])); }
 
+			else // dataset or directory to rename
+				{ aosInputPaths.push_back(argv[i]); }
 			}
-		pszFilePath = argv [argc - 1];
 		}
 
-	if (argc <= 1 || printUsage)
+	if (argc <= 1 || printUsage || (aosInputPaths.empty() && !bFromStdin && !bResume && !bRollback && pszBenchmarkDir == NULL))
 		{ Usage(); }
 
-    ::GDALDataset  *poDataset = NULL;
+	//the naming is checked before any file is touched
+	NameTemplate oNameTemplate;
+	std::string sTemplateError;
+
+	oOptions.poTileGrid = &oTileGrid;
+	if ( !oNameTemplate.Compile(oOptions, sTemplateError) )
+		{ Usage(sTemplateError.c_str()); }
+	oOptions.poNameTemplate = &oNameTemplate;
+
+	//without --grid the grid of the {col} and {row} fields is inferred
+	if ( oNameTemplate.HasGridFields() && !oTileGrid.bValid )
+		{ oTileGrid.bInfer = true; }
+	if ( bHasGrid && !oNameTemplate.HasGridFields() )
+		{ Usage("--grid needs {col} or {row} in the names (or --coord-type grid)"); }
+	if ( bWatch && ( bFromStdin || oOptions.bPlanRenames || oTileGrid.bInfer ) )
+		{ Usage("--watch renames each dataset once written, it can't be used with --from-stdin, --plan or an inferred grid"); }
+	if ( oOptions.bPlanRenames && oOptions.pszOutputDir != NULL )
+		{ Usage("--plan orders the renames in place, it can't be used with --output-dir"); }
+	if ( bWatch && dfWatchSettle < 0.0 )
+		{ Usage("--watch-settle must be positive"); }
+	for( size_t i = 0; i < aosInputPaths.size() && bWatch; i++ )
+		{
+		::VSIStatBufL psStatBuf;
+		if ( ::VSIStatExL(aosInputPaths[i].c_str(), &psStatBuf, VSI_STAT_EXISTS_FLAG | VSI_STAT_NATURE_FLAG) != 0 || !VSI_ISDIR(psStatBuf.st_mode) )
+			{ Usage(CPLSPrintf("--watch needs directories, '%s' is not one", aosInputPaths[i].c_str())); }
+		}
+	if ( bArchive && ( bFromStdin || bWatch || pszJournal != NULL || oOptions.bPlanRenames || oOptions.pszOutputDir != NULL ||
+					   pszTileIndex != NULL || !EQUAL(oOptions.pszOutputConsole, "") || oTileGrid.bInfer ) )
+		{ Usage("--archive rewrites each archive at once, it can't be used with --from-stdin, --watch, a journal, --plan, --output-dir, --tile-index, --output-console or an inferred grid"); }
+	for( size_t i = 0; i < aosInputPaths.size() && bArchive; i++ )
+		{
+		const char *pszExt = ::CPLGetExtension(aosInputPaths[i].c_str());
+		if ( !EQUAL(pszExt, "zip") && !EQUAL(pszExt, "tar") )
+			{ Usage(CPLSPrintf("--archive needs .zip or uncompressed .tar archives, '%s' is not one", aosInputPaths[i].c_str())); }
+		}
+	if ( bCheckDuplicates && ( bWatch || bArchive || pszJournal != NULL || pszTileIndex != NULL || oOptions.bPlanRenames ) )
+		{ Usage("--check-duplicates checks a whole inventory without renaming it, it can't be used with --watch, --archive, a journal, --tile-index or --plan"); }
+	if ( bCheckDuplicates && dfCheckMemory < 1.0 )
+		{ Usage("--check-memory must be at least 1 MB"); }
+	if ( oTileGrid.bInfer && oOptions.pszTargetSRS != NULL )
+		{ Usage("The tiles grid can't be inferred with --target-srs, use --grid origin_x,origin_y,tile_size_x,tile_size_y"); }
+
+	if ( oOptions.pszTargetSRS != NULL )
+		{
+		OGRSpatialReferenceH hTargetSRS = ::OSRNewSpatialReference(NULL);
+		bool bValidSRS = ( ::OSRSetFromUserInput(hTargetSRS, oOptions.pszTargetSRS) == OGRERR_NONE );
+
+		::OSRDestroySpatialReference(hTargetSRS);
+		if ( !bValidSRS )
+			{ Usage(CPLSPrintf("Unrecognized target SRS '%s'", oOptions.pszTargetSRS)); }
+		}
+
+	if ( !setRenameBackend(pszRenameBackend) )
+		{ Usage(CPLSPrintf("Rename backend '%s' not available", pszRenameBackend)); }
+
+	if ( !EQUAL(oOptions.pszOutputConsole, "") && !CommandWriter::IsFormat(oOptions.pszOutputConsole) )
+		{ Usage(CPLSPrintf("Unknown --output-console format '%s', must be win, unix, cmd, sh, nul or jsonl", oOptions.pszOutputConsole)); }
+	if ( pszJournal != NULL && !EQUAL(oOptions.pszOutputConsole, "") )
+		{ Usage("A journal can't be used with --output-console"); }
+	if ( pszTileIndex != NULL && !EQUAL(oOptions.pszOutputConsole, "") )
+		{ Usage("--tile-index records the renamed datasets, it can't be used with --output-console"); }
 
-	std::string inputDataset = pszFilePath;
+	if ( oOptions.pszOutputDir != NULL )
+		{
+		::VSIStatBufL psStatBuf;
+		if ( ::VSIStatExL(oOptions.pszOutputDir, &psStatBuf, VSI_STAT_EXISTS_FLAG | VSI_STAT_NATURE_FLAG) != 0 || !VSI_ISDIR(psStatBuf.st_mode) )
+			{ Usage(CPLSPrintf("Output directory '%s' does not exist", oOptions.pszOutputDir)); }
+		}
 
-	std::string sFilename	= ::CPLGetFilename(pszFilePath);
-	std::string sDirName	= ::CPLGetDirname(pszFilePath);
-	std::string sExt		= ::CPLGetExtension(pszFilePath);
-	std::string sBasename	= ::CPLGetBasename(pszFilePath);
+	oOptions.nTransferThreads = atoi(pszTransferThreads);
+	if ( oOptions.nTransferThreads < 1 )
+		{ Usage("--transfer-threads must be at least 1"); }
 
-	std::string sNewFileName;
-	std::string sSiblingFileName = sDirName + sDirSep + sBasename + "." ;
-	std::string sMainPrintfStx ;
+	int nThreads = EQUAL(pszThreads, "ALL_CPUS") ? ::CPLGetNumCPUs() : atoi(pszThreads);
+	if ( nThreads < 1 )
+		{ nThreads = 1; }
 
+	//only the drivers of the datasets formats (and of the tile index) with
+	//--drivers, without loading all the plugins
+	DriverAllowList oDrivers;
+	char **papszExtensions = ::CSLTokenizeString2( pszBenchmarkDir != NULL ? "tif,jp2" : pszExtensions, ",", 0 );
+	double dfRegistrationStart = oRunStats.GetElapsed();
 
-	poDataset = (GDALDataset *) ::GDALOpen( pszFilePath, GA_ReadOnly );
+	if ( pszTileIndex != NULL && pszTileIndexFormat == NULL )
+		{ pszTileIndexFormat = EQUAL(::CPLGetExtension(pszTileIndex), "fgb") ? "FlatGeobuf" : "GPKG"; }
 
-	if( poDataset != NULL )
+	for( size_t i = 0; i < aosInputPaths.size() && !EQUAL(pszDrivers, "all") && !bArchive; i++ )
 		{
-		double        adfGeoTransform[6];
+		::VSIStatBufL psStatBuf;
+		const char *pszExt = ::CPLGetExtension(aosInputPaths[i].c_str());
 
-		if( poDataset->GetGeoTransform( adfGeoTransform ) == CE_None )
-			{
-			std::string sCoordPrintfStx ;
+		//the datasets given are opened whatever their extension
+		if ( pszExt[0] != '\0' && ::CSLFindString(papszExtensions, pszExt) < 0 &&
+			 ( ::VSIStatExL(aosInputPaths[i].c_str(), &psStatBuf, VSI_STAT_EXISTS_FLAG | VSI_STAT_NATURE_FLAG) != 0 || !VSI_ISDIR(psStatBuf.st_mode) ) )
+			{ papszExtensions = ::CSLAddString(papszExtensions, pszExt); }
+		}
 
-			double Coord0 = .0, Coord1 = .0;
-			int iCoord0 = 0, iCoord1 = 0;
-			char Sign0 = 0x00, Sign1 = 0x00;
+	if ( bAllRegistered || EQUAL(pszDrivers, "all") || !oDrivers.Build(pszDrivers, papszExtensions) )
+		{
+		if ( !bAllRegistered )
+			{ ::GDALAllRegister(); }
+		}
+	else
+		{
+		if ( pszTileIndexFormat != NULL )
+			{ oDrivers.AddDriver(EQUAL(pszTileIndexFormat, "FlatGeobuf") ? "FlatGeobuf" : "GPKG"); }
 
-			Coord0 = getCoord(pszCoordRefPoint[0], adfGeoTransform, poDataset);
-			if ( EQUAL(pszCoordSignType , "geo") )
-				{Sign0 = getCoordHemi(pszCoordRefPoint[0], adfGeoTransform, poDataset);}
+		oDrivers.Register(!EQUAL(pszDrivers, "auto"));
+		oOptions.poDrivers = &oDrivers;
+		}
+	double dfRegistrationTime = oRunStats.GetElapsed() - dfRegistrationStart;
 
-			Coord1 = getCoord(pszCoordRefPoint[1], adfGeoTransform, poDataset);
-			if ( EQUAL(pszCoordSignType , "geo") )
-				{Sign1 = getCoordHemi(pszCoordRefPoint[1], adfGeoTransform, poDataset);}
+	//the benchmark collects the statistics of each of its stages
+	if ( pszBenchmarkDir != NULL )
+		{
+		::CSLDestroy(papszExtensions);
+		return runBenchmark(argv[0], pszBenchmarkDir, pszBenchmarkTiles, pszBenchmarkLayouts, nThreads, oOptions, pszStats);
+		}
 
-			//
-			if ( EQUAL(pszPrintf, "") )
-				{
-				sCoordPrintfStx += "%";
+	if ( pszStats != NULL || dfProgressInterval > 0.0 )
+		{
+		oRunStats.Record(PHASE_DRIVER_REGISTRATION, dfRegistrationTime);
+		oRunStats.SetProgressInterval(dfProgressInterval);
+		setRunStats(&oRunStats);
+		}
 
-				//Sign formatting
-				if ( EQUAL(pszCoordSignType , "geo") ) // E/W or N/S adding an extra %c to add the char
-					{sCoordPrintfStx+="c%";}
-				else if ( EQUALN(pszCoordSignType , "force", 4) )
-					{ sCoordPrintfStx +=  "+"; }
+	if ( bRollback )
+		{
+		bool bSuccess = rollbackJournal(pszJournal);
+		::CSLDestroy(papszExtensions);
+		return ( ( pszStats == NULL || oRunStats.WriteJSON(pszStats) ) && bSuccess ) ? 0 : 1;
+		}
 
-				if ( EQUAL(pszCoordType , "real") )
-					{
+	GeoRefCache oGeoRefCache;
 
-					if ( pszCoordPadding && pszCoordLenght != "") //if real padding is made with %0n where n is a digit or %0* with extra param
-						{ sCoordPrintfStx = sCoordPrintfStx + "0" + pszCoordLenght + "." + pszCoordDecLenght + "f"; }
+	if ( pszGeoRefCache != NULL && oGeoRefCache.Open(pszGeoRefCache) )
+		{ oOptions.poGeoRefCache = &oGeoRefCache; }
 
-					}
-				else
-					{
+	//each archive is rewritten once with all its entries renamed
+	if ( bArchive )
+		{
+		bool bSuccess = true;
 
-					if ( pszCoordPadding && pszCoordLenght != "") //if real padding is made with %0n where n is a digit or %0* with extra param
-						{ sCoordPrintfStx = sCoordPrintfStx + "." + pszCoordLenght + "d"; }
+		for( size_t i = 0; i < aosInputPaths.size(); i++ )
+			{
+			int nRenamed = 0, nFailures = 0;
 
-					int baseDigits = std::max(nDigits(Coord0), nDigits(Coord1));
-					int formatDigits = atoi(pszCoordLenght);
+			bSuccess = renameArchive(aosInputPaths[i].c_str(), papszExtensions, oOptions, nRenamed, nFailures) && bSuccess;
+			fprintf(stderr, "Archive \"%s\" : %d dataset(s) renamed, %d failure(s)\n", aosInputPaths[i].c_str(), nRenamed, nFailures);
+			}
 
-					iCoord0 = (int) Coord0;
-					iCoord1 = (int) Coord1;
+		bSuccess = oGeoRefCache.Save() && bSuccess;
+		::CSLDestroy(papszExtensions);
+		return ( ( pszStats == NULL || oRunStats.WriteJSON(pszStats) ) && bSuccess ) ? 0 : 1;
+		}
 
-					if (baseDigits > formatDigits )
-						{
-						int exp = baseDigits-formatDigits;
-						iCoord0 = Coord0 / pow(10.,exp);
-						iCoord1 = Coord1 / pow(10.,exp);
-						}
-					}
+	//the targets are recorded by the batch mode rename stage instead of renamed
+	DuplicateCheck oDuplicateCheck;
 
-				sMainPrintfStx = pszPrefix + sCoordPrintfStx + pszCoordSep + sCoordPrintfStx + pszSuffix;
-				}
-			else
-				{ sMainPrintfStx = pszPrintf;}
+	if ( bCheckDuplicates )
+		{
+		oDuplicateCheck.SetMemoryBudget( (size_t)( dfCheckMemory * 1024 * 1024 ) );
+		oOptions.poDuplicateCheck = &oDuplicateCheck;
+		}
 
-			char NewFileNameBuff [256] = "\0";
-			char* pszNewFileName = (char*)&NewFileNameBuff;
+	//the commands printed instead of the renames are buffered for the whole run
+	CommandWriter oCommandWriter;
 
-			try
-				{
-				if ( EQUAL(pszCoordType , "real") )
-					{
-					if ( EQUAL(pszCoordSignType , "geo") )
-						{::CPLsnprintf(pszNewFileName, 256, sMainPrintfStx.c_str(), Sign0 ,Coord0, Sign1 , Coord1);}
-					else
-						{::CPLsnprintf(pszNewFileName, 256, sMainPrintfStx.c_str(), Coord0 , Coord1);}
-					}
-				else
-					{
-					if ( EQUAL(pszCoordSignType , "geo") )
-						{::CPLsnprintf(pszNewFileName, 256, sMainPrintfStx.c_str(), Sign0 ,iCoord0, Sign1 , iCoord1);}
-					else
-						{::CPLsnprintf(pszNewFileName, 256, sMainPrintfStx.c_str(), iCoord0 , iCoord1);}
-					}
-				}
-			catch (...)
-				{
-				::CPLprintf( "/!\\ printf issue while building new file name \"%s\"\nIf you used --printf-syntax|-f check it is right\notherwise please submit the bugg at https://github.com/MattLatt/gdal_rename\n", pszFilePath);
-				::GDALClose((GDALDatasetH)poDataset);
-				return 1;
-				}
+	if ( !EQUAL(oOptions.pszOutputConsole, "") )
+		{
+		oCommandWriter.Open(oOptions.pszOutputConsole, stdout);
+		oOptions.poCommandWriter = &oCommandWriter;
+		}
 
+	//the tile index is written by the batch mode rename stage
+	TileIndex oTileIndex;
 
-			::GDALClose((GDALDatasetH)poDataset);
+	if ( pszTileIndex != NULL )
+		{
+		if ( !EQUAL(pszTileIndexFormat, "GPKG") && !EQUAL(pszTileIndexFormat, "FlatGeobuf") )
+			{ Usage(CPLSPrintf("Unsupported tile index format '%s'", pszTileIndexFormat)); }
 
-			std::string sNewFilePath = sDirName + sDirSep + pszNewFileName + "." + sExt ;
+		if ( !oTileIndex.Open(pszTileIndex, pszTileIndexFormat) )
+			{ return 1; }
 
-			if ( EQUAL(pszOutputConsole, "") )
-				{
-				bool Success =  renameFileNoOverWrite(pszFilePath, sNewFilePath) ;
-				if (!Success)
-					{ ::CPLprintf( "/!\\ printf issue while renaming file \"%s\"\nCheck the file is not locked or still exist !!!\n", pszFilePath); }
-				}
-			else
-				{ std::cout << formatRenameCmdLine( pszOutputConsole, pszFilePath, sNewFilePath.c_str()).c_str() << std::endl;}
+		oOptions.poTileIndex = &oTileIndex;
+		}
 
-			std::vector<std::string> SiblingFilesExts = getSiblingFilesExt(pszFilePath);
-			std::vector<std::string>::iterator it = SiblingFilesExts.begin();
+	//the journal of a resumed run is continued
+	RenameJournal oJournal;
+	std::unordered_set<std::string> oDonePaths;
 
-			while ( it != SiblingFilesExts.end() )
-				{
-				std::string sCurSiblingFileName = sSiblingFileName;
+	if ( pszJournal != NULL )
+		{
+		::VSIStatBufL psJournalStat;
+		if ( !bResume && ::VSIStatExL(pszJournal, &psJournalStat, VSI_STAT_EXISTS_FLAG) == 0 )
+			{ Usage(CPLSPrintf("Journal '%s' already exists, use --resume or --rollback", pszJournal)); }
 
-				sCurSiblingFileName += (*it).c_str();
-				std::string sNewSiblingFilePath = sDirName + sDirSep + pszNewFileName + "." + (*it).c_str() ;
+		if ( !oJournal.Open(pszJournal, bResume) )
+			{ return 1; }
 
-				if ( EQUAL(pszOutputConsole, "") )
-					{ renameFileNoOverWrite(sCurSiblingFileName, sNewSiblingFilePath) ; }
-				else
-					{ std::cout << formatRenameCmdLine( pszOutputConsole, sCurSiblingFileName.c_str(), sNewSiblingFilePath.c_str()).c_str() << std::endl ;}
+		setRenameJournal(&oJournal);
 
-				++it;
-				}
+		if ( bResume && !resumeJournal(pszJournal, oDonePaths) )
+			{ return 1; }
+		}
 
-			}
-		else
-			{
-			::CPLprintf( "/!\\ No GeoRef information found by GDAL in the file \"%s\", Exiting...\n", pszFilePath);
-			::GDALClose((GDALDatasetH)poDataset);
-			return 1;
-			}
+	//historical one file per process mode, no thread nor summary
+	::VSIStatBufL psStatBuf;
+	if ( aosInputPaths.size() == 1 && !bFromStdin && !bResume && !bWatch && pszTileIndex == NULL && !bCheckDuplicates &&
+		 ( ::VSIStatExL ( aosInputPaths[0].c_str(), &psStatBuf, VSI_STAT_EXISTS_FLAG | VSI_STAT_NATURE_FLAG) != 0 ||
+		   !VSI_ISDIR(psStatBuf.st_mode) ) )
+		{
+		bool bSuccess = renameDataset(aosInputPaths[0].c_str(), oOptions);
+		if ( !bSuccess )
+			{ countRunStats(COUNTER_DATASETS_FAILED); }
+
+		bSuccess = oCommandWriter.Flush() && bSuccess;
 
+		bSuccess = oGeoRefCache.Save() && bSuccess;
+		::CSLDestroy(papszExtensions);
+		return ( ( pszStats == NULL || oRunStats.WriteJSON(pszStats) ) && bSuccess ) ? 0 : 1;
 		}
 
+	//batch mode
+	BatchContext oContext;
+	runBatch(aosInputPaths, bFromStdin, bNulDelimited, bWatch, dfWatchSettle, nThreads, papszExtensions, oOptions,
+			 bResume ? &oDonePaths : NULL, oContext);
 
-	return 0;
-	}
+	::CSLDestroy(papszExtensions);
+
+	bool bCached = oGeoRefCache.Save();
+	bool bIndexed = oTileIndex.Close();
+	bool bPrinted = oCommandWriter.Flush();
+	int nDuplicateTargets = 0, nDuplicateDatasets = 0, nExistingTargets = 0;
+	bool bChecked = !bCheckDuplicates || oDuplicateCheck.Report(nDuplicateTargets, nDuplicateDatasets, nExistingTargets);
 
+	oRunStats.Progress(true);
+	if ( pszStats != NULL )
+		{ oRunStats.WriteJSON(pszStats); }
+
+	//the datasets of a duplicate or existing target are the failures of the check
+	int nConflicts = nDuplicateDatasets + nExistingTargets;
+	int nFailures = (int) oContext.aosFailures.size() + nConflicts;
+
+	if ( bCheckDuplicates )
+		{ fprintf(stderr, "Check : %d duplicate target(s) of %d dataset(s), %d existing target(s)\n", nDuplicateTargets, nDuplicateDatasets, nExistingTargets); }
+	fprintf(stderr, "%d dataset(s) processed, %d failure(s)\n", oContext.nSuccess - nConflicts, nFailures);
+	if ( bResume )
+		{ fprintf(stderr, "%d dataset(s) already renamed by the resumed run\n", oContext.nSkipped); }
+	for( size_t i = 0; i < oContext.aosFailures.size(); i++ )
+		{ fprintf(stderr, "  failed: %s\n", oContext.aosFailures[i].c_str()); }
+
+	return ( nFailures == 0 && bCached && bIndexed && bPrinted && bChecked ) ? 0 : 1;
+	}
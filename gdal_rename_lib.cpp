@@ -0,0 +1,7669 @@
+//##################################################################################//
+//									gdal_rename_lib									//
+//**********************************************************************************//
+// Desc: Rename library of gdal_rename : names computed from the datasets			//
+//		 georeferencing, sibling files discovery, rename planning and execution,	//
+//		 journal, caches and batch pipeline. Used in process through the			//
+//		 gdal_rename_lib.h API, the gdal_rename command line is a wrapper over it.	//
+//		 																			//
+// Author: 	Mathieu Lattes (mathieu dot lattes at yahoo dot fr)						//
+//																					//
+// Version:	see gdal_rename.cpp														//
+//##################################################################################//
+
+#include "gdal_rename_priv.h"
+#include "gdal_rename_lib.h"
+
+#ifdef _WIN32
+std::string  sDirSep = "\\";
+#else //Linux or MacOsX
+std::string  sDirSep = "/";
+#endif
+
+//***********************************************************************//
+//!Separator of the paths of a directory : always '/' in the GDAL virtual
+//!file systems (ie: the members of /vsizip/ and /vsitar/ archives)
+//***********************************************************************//
+static const std::string& getDirSep(const std::string& sDirName)
+	{
+	static const std::string sVSIDirSep = "/";
+
+	return STARTS_WITH(sDirName.c_str(), "/vsi") ? sVSIDirSep : sDirSep;
+	}
+
+//!Worker thread of the batch mode, compute the new names of the datasets popped from the queue
+static void computeWorker(void* pData);
+
+//!Rename stage of the batch mode, apply the jobs computed by the workers
+static void renameStage(void* pData);
+
+//***********************************************************************//
+//!Run statistics names, in the RunPhase and RunCounter order (JSON keys)
+//***********************************************************************//
+static const char * const apszRunPhaseNames[PHASE_COUNT] =
+	{
+	"driver_registration", "directory_walk", "directory_read", "stat", "cache_lookup", "header_read",
+	"open", "geotransform", "close", "reproject", "name_format", "rename", "rename_batch", "journal_sync",
+	"tile_index", "transfer", "archive_write", "duplicate_check"
+	};
+
+static const char * const apszRunCounterNames[COUNTER_COUNT] =
+	{
+	"datasets", "datasets_renamed", "datasets_failed", "datasets_skipped", "siblings_renamed", "backups",
+	"cache_hits", "fast_georef", "gdal_open", "header_opens", "stat_calls", "directory_reads", "rename_calls",
+	"uring_submits", "fsync_calls", "transforms", "reproject_calls", "offgrid", "indexed", "transfers", "reflinks", "archive_entries",
+	"duplicate_targets", "existing_targets", "check_spills", "open", "no_georef", "no_srs", "reprojection",
+	"target_conflict", "target_exists", "backup", "rename", "transfer", "archive"
+	};
+
+//failures are written apart, by cause
+#define GDAL_RENAME_FIRST_FAILURE_COUNTER	COUNTER_FAILED_OPEN
+
+static RunStats *poRunStats = NULL;
+
+//***********************************************************************//
+//!Run statistics, the run duration starts at their construction
+//***********************************************************************//
+RunStats::RunStats()
+	{
+	hMutex = NULL;
+	dfStart = GetTime();
+	dfProgressInterval = 0.0;
+	dfLastProgress = dfStart;
+
+	for( int i = 0; i < COUNTER_COUNT; i++ )
+		{ anCounters[i] = 0; }
+
+	for( int i = 0; i < PHASE_COUNT; i++ )
+		{
+		aoPhases[i].nCount = 0;
+		aoPhases[i].dfTotal = 0.0;
+		aoPhases[i].dfMin = 0.0;
+		aoPhases[i].dfMax = 0.0;
+		for( int j = 0; j < HISTOGRAM_BUCKETS; j++ )
+			{ aoPhases[i].anBuckets[j] = 0; }
+		}
+	}
+
+RunStats::~RunStats()
+	{
+	if ( hMutex != NULL )
+		{ ::CPLDestroyMutex(hMutex); }
+	}
+
+//***********************************************************************//
+//!Monotonic time in seconds
+//***********************************************************************//
+double RunStats::GetTime()
+	{
+	return std::chrono::duration<double>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+	}
+
+//***********************************************************************//
+//!Seconds elapsed since the start of the run
+//***********************************************************************//
+double RunStats::GetElapsed() const
+	{
+	return GetTime() - dfStart;
+	}
+
+//***********************************************************************//
+//!Add the duration of a phase to its histogram
+//***********************************************************************//
+void RunStats::Record(RunPhase ePhase, double dfSeconds)
+	{
+	int nBucket = 0;
+	double dfMicroSeconds = dfSeconds * 1e6;
+
+	while ( nBucket < HISTOGRAM_BUCKETS - 1 && dfMicroSeconds >= (double)((GIntBig)1 << nBucket) )
+		{ nBucket++; }
+
+	CPLMutexHolderD(&hMutex);
+	PhaseHistogram& oPhase = aoPhases[ePhase];
+
+	if ( oPhase.nCount == 0 || dfSeconds < oPhase.dfMin )
+		{ oPhase.dfMin = dfSeconds; }
+	if ( dfSeconds > oPhase.dfMax )
+		{ oPhase.dfMax = dfSeconds; }
+
+	oPhase.nCount++;
+	oPhase.dfTotal += dfSeconds;
+	oPhase.anBuckets[nBucket]++;
+	}
+
+//***********************************************************************//
+//!Count an event (lock free, called for each file by the workers)
+//***********************************************************************//
+void RunStats::Count(RunCounter eCounter, int nValue)
+	{
+	::CPLAtomicAdd(&anCounters[eCounter], nValue);
+	}
+
+int RunStats::GetCount(RunCounter eCounter) const
+	{
+	return anCounters[eCounter];
+	}
+
+//***********************************************************************//
+//!File system calls of the run : stat, directory reads, datasets and
+//!headers opened, renames, io_uring submissions and fsync
+//***********************************************************************//
+int RunStats::GetSyscalls() const
+	{
+	return anCounters[COUNTER_STAT_CALLS] + anCounters[COUNTER_DIRECTORY_READS] + anCounters[COUNTER_GDAL_OPEN] +
+		   anCounters[COUNTER_HEADER_OPENS] + anCounters[COUNTER_RENAME_CALLS] + anCounters[COUNTER_URING_SUBMITS] +
+		   anCounters[COUNTER_FSYNC_CALLS];
+	}
+
+//***********************************************************************//
+//!Print a progress line on stderr every dfSeconds (0 for none)
+//***********************************************************************//
+void RunStats::SetProgressInterval(double dfSeconds)
+	{
+	dfProgressInterval = dfSeconds;
+	}
+
+//***********************************************************************//
+//!Print a progress line on stderr if the progress interval has elapsed
+//!since the last one (or if bForce)
+//***********************************************************************//
+void RunStats::Progress(bool bForce)
+	{
+	if ( dfProgressInterval <= 0.0 )
+		{ return; }
+
+	double dfNow = GetTime();
+	CPLMutexHolderD(&hMutex);
+
+	if ( !bForce && dfNow - dfLastProgress < dfProgressInterval )
+		{ return; }
+
+	dfLastProgress = dfNow;
+	double dfElapsed = dfNow - dfStart;
+	int nDatasets = anCounters[COUNTER_DATASETS];
+
+	fprintf(stderr, "[%.1fs] %d dataset(s) processed, %d renamed, %d failure(s), %.0f dataset(s)/s\n",
+			dfElapsed, nDatasets, anCounters[COUNTER_DATASETS_RENAMED], anCounters[COUNTER_DATASETS_FAILED],
+			dfElapsed > 0.0 ? nDatasets / dfElapsed : 0.0);
+	}
+
+//***********************************************************************//
+//!Duration (in seconds) below which dfRatio of the phase durations are,
+//!the upper bound of the histogram bucket holding it
+//***********************************************************************//
+double RunStats::GetPercentile(const PhaseHistogram& oHistogram, double dfRatio) const
+	{
+	GIntBig nRank = (GIntBig) ceil(oHistogram.nCount * dfRatio);
+	GIntBig nSeen = 0;
+
+	for( int i = 0; i < HISTOGRAM_BUCKETS; i++ )
+		{
+		nSeen += oHistogram.anBuckets[i];
+		if ( nSeen >= nRank && nSeen > 0 )
+			{ return std::min( (double)((GIntBig)1 << i) * 1e-6, oHistogram.dfMax ); }
+		}
+
+	return oHistogram.dfMax;
+	}
+
+//***********************************************************************//
+//!Write the statistics of the run as JSON ("-" for stdout) : duration,
+//!throughput, counters, failures by cause and for each phase its count,
+//!total/min/max/mean, percentiles and histogram (bucket upper bounds in
+//!microseconds)
+//***********************************************************************//
+bool RunStats::WriteJSON(const char* pszPath)
+	{
+	FILE *fpStats = EQUAL(pszPath, "-") ? stdout : fopen(pszPath, "wb");
+
+	if ( fpStats == NULL )
+		{
+		::CPLError(CE_Failure, CPLE_OpenFailed, "Unable to create the statistics file \"%s\"", pszPath);
+		return false;
+		}
+
+	CPLMutexHolderD(&hMutex);
+	double dfElapsed = GetElapsed();
+	int nDatasets = anCounters[COUNTER_DATASETS];
+	int nSyscalls = GetSyscalls();
+
+	fprintf(fpStats, "{\n  \"elapsed_seconds\": %.6f,\n", dfElapsed);
+	fprintf(fpStats, "  \"datasets_per_second\": %.3f,\n", dfElapsed > 0.0 ? nDatasets / dfElapsed : 0.0);
+	fprintf(fpStats, "  \"syscalls_per_dataset\": %.3f,\n", nDatasets > 0 ? (double) nSyscalls / nDatasets : 0.0);
+
+	fprintf(fpStats, "  \"counters\": {");
+	for( int i = 0; i < GDAL_RENAME_FIRST_FAILURE_COUNTER; i++ )
+		{ fprintf(fpStats, "%s\n    \"%s\": %d", i > 0 ? "," : "", apszRunCounterNames[i], anCounters[i]); }
+
+	fprintf(fpStats, "\n  },\n  \"failures\": {");
+	for( int i = GDAL_RENAME_FIRST_FAILURE_COUNTER; i < COUNTER_COUNT; i++ )
+		{ fprintf(fpStats, "%s\n    \"%s\": %d", i > GDAL_RENAME_FIRST_FAILURE_COUNTER ? "," : "", apszRunCounterNames[i], anCounters[i]); }
+
+	fprintf(fpStats, "\n  },\n  \"phases\": {");
+	for( int i = 0; i < PHASE_COUNT; i++ )
+		{
+		const PhaseHistogram& oPhase = aoPhases[i];
+
+		fprintf(fpStats, "%s\n    \"%s\": {\"count\": " CPL_FRMT_GIB ", \"total_seconds\": %.6f, \"min_us\": %.1f, \"mean_us\": %.1f, \"max_us\": %.1f, "
+				"\"p50_us\": %.1f, \"p90_us\": %.1f, \"p99_us\": %.1f, \"histogram_us\": [",
+				i > 0 ? "," : "", apszRunPhaseNames[i], oPhase.nCount, oPhase.dfTotal, oPhase.dfMin * 1e6,
+				oPhase.nCount > 0 ? oPhase.dfTotal * 1e6 / oPhase.nCount : 0.0, oPhase.dfMax * 1e6,
+				GetPercentile(oPhase, 0.5) * 1e6, GetPercentile(oPhase, 0.9) * 1e6, GetPercentile(oPhase, 0.99) * 1e6);
+
+		//only the buckets in use : [upper bound, count]
+		bool bFirst = true;
+		for( int j = 0; j < HISTOGRAM_BUCKETS; j++ )
+			{
+			if ( oPhase.anBuckets[j] == 0 )
+				{ continue; }
+
+			fprintf(fpStats, "%s[" CPL_FRMT_GIB ", " CPL_FRMT_GIB "]", bFirst ? "" : ", ", (GIntBig)1 << j, oPhase.anBuckets[j]);
+			bFirst = false;
+			}
+
+		fprintf(fpStats, "]}");
+		}
+
+	fprintf(fpStats, "\n  }\n}\n");
+
+	bool bSuccess = ( fflush(fpStats) == 0 );
+	if ( fpStats != stdout && fclose(fpStats) != 0 )
+		{ bSuccess = false; }
+
+	if ( !bSuccess )
+		{ ::CPLError(CE_Failure, CPLE_FileIO, "Unable to write the statistics file \"%s\"", pszPath); }
+
+	return bSuccess;
+	}
+
+//***********************************************************************//
+//!Phase timer, the clock is read only when statistics are collected
+//***********************************************************************//
+PhaseTimer::PhaseTimer(RunPhase ePhaseIn)
+	{
+	ePhase = ePhaseIn;
+	dfStart = ( poRunStats != NULL ) ? RunStats::GetTime() : 0.0;
+	}
+
+PhaseTimer::~PhaseTimer()
+	{
+	if ( poRunStats != NULL )
+		{ poRunStats->Record(ePhase, RunStats::GetTime() - dfStart); }
+	}
+
+//***********************************************************************//
+//!Select the statistics of the run (NULL for none)
+//***********************************************************************//
+void setRunStats(RunStats* poStats)
+	{
+	poRunStats = poStats;
+	}
+
+//***********************************************************************//
+//!Count an event of the run statistics, if any
+//***********************************************************************//
+void countRunStats(RunCounter eCounter, int nValue)
+	{
+	if ( poRunStats != NULL )
+		{ poRunStats->Count(eCounter, nValue); }
+	}
+
+//***********************************************************************//
+//!SiblingIndex constructor. If bReadDirectories the directories are read
+//!once and kept in memory, otherwise the files are looked for with stat
+//!calls (cheaper when only one dataset of a directory is renamed)
+//***********************************************************************//
+SiblingIndex::SiblingIndex(bool bReadDirectoriesIn)
+	{
+	bReadDirectories = bReadDirectoriesIn;
+	bTrackRenames = false;
+	hMutex = NULL;
+	}
+
+SiblingIndex::~SiblingIndex()
+	{
+	std::map<std::string, DirectoryContent*>::iterator it = oDirectories.begin();
+
+	while ( it != oDirectories.end() )
+		{
+		delete it->second;
+		++it;
+		}
+
+	if ( hMutex != NULL )
+		{ ::CPLDestroyMutex(hMutex); }
+	}
+
+//***********************************************************************//
+//!Key used to look for a file name, case insensitive on windows as the
+//!file system is
+//***********************************************************************//
+std::string SiblingIndex::GetKey(const std::string& sFileName)
+	{
+#ifdef _WIN32
+	std::string sKey = sFileName;
+	for( size_t i = 0; i < sKey.size(); i++ )
+		{ sKey[i] = (char) tolower(sKey[i]); }
+	return sKey;
+#else
+	return sFileName;
+#endif
+	}
+
+//***********************************************************************//
+//!Get the content of a directory, reading it the first time (hMutex must
+//!be held). The number of directories kept in memory is bounded
+//***********************************************************************//
+SiblingIndex::DirectoryContent* SiblingIndex::GetDirectory(const std::string& sDirName)
+	{
+	std::map<std::string, DirectoryContent*>::iterator it = oDirectories.find(sDirName);
+
+	if ( it != oDirectories.end() )
+		{ return it->second; }
+
+	while ( oDirectoriesOrder.size() >= 256 )
+		{
+		delete oDirectories[oDirectoriesOrder.front()];
+		oDirectories.erase(oDirectoriesOrder.front());
+		oDirectoriesOrder.pop_front();
+		}
+
+	DirectoryContent *poContent = new DirectoryContent();
+	char **papszFiles = NULL;
+		{
+		PhaseTimer oTimer(PHASE_DIRECTORY_READ);
+		papszFiles = ::VSIReadDir( sDirName.c_str() );
+		}
+	countRunStats(COUNTER_DIRECTORY_READS);
+
+	//not listable (ie: some /vsi file systems), stat calls are used instead
+	poContent->bIndexed = ( papszFiles != NULL );
+
+	for( int i = 0; papszFiles != NULL && papszFiles[i] != NULL; i++ )
+		{
+		std::string sKey = GetKey(papszFiles[i]);
+		poContent->oFiles.insert(sKey);
+		poContent->oFilesByBasename.insert( std::make_pair( std::string(::CPLGetBasename(sKey.c_str())), std::string(papszFiles[i]) ) );
+		}
+
+	::CSLDestroy(papszFiles);
+
+	oDirectories[sDirName] = poContent;
+	oDirectoriesOrder.push_back(sDirName);
+
+	return poContent;
+	}
+
+//***********************************************************************//
+//!Check whether or not a file exists
+//***********************************************************************//
+bool SiblingIndex::Exists(const std::string& sFilePath)
+	{
+	if ( bReadDirectories )
+		{
+		CPLMutexHolderD(&hMutex);
+		DirectoryContent *poContent = GetDirectory( ::CPLGetDirname(sFilePath.c_str()) );
+
+		if ( poContent->bIndexed )
+			{ return poContent->oFiles.count( GetKey(::CPLGetFilename(sFilePath.c_str())) ) > 0; }
+		}
+
+	::VSIStatBufL psStatBuf;
+	PhaseTimer oTimer(PHASE_STAT);
+	countRunStats(COUNTER_STAT_CALLS);
+
+	return ::VSIStatExL( sFilePath.c_str(), &psStatBuf, VSI_STAT_EXISTS_FLAG) == 0;
+	}
+
+//***********************************************************************//
+//!Look for the sibling file of a dataset with the given extension, the
+//!extension is matched case insensitively (ie: tfw or TFW). Return the
+//!path of the sibling with its actual case
+//***********************************************************************//
+bool SiblingIndex::FindSibling(const char* pszFilePath, const char* pszExt, std::string& sSiblingPath)
+	{
+	std::string sDirName = ::CPLGetDirname(pszFilePath);
+	std::string sBasename = ::CPLGetBasename(pszFilePath);
+
+	if ( bReadDirectories )
+		{
+		CPLMutexHolderD(&hMutex);
+		DirectoryContent *poContent = GetDirectory(sDirName);
+
+		if ( poContent->bIndexed )
+			{
+			std::string sFileName = ::CPLGetFilename(pszFilePath);
+			typedef std::unordered_multimap<std::string, std::string>::iterator SiblingIterator;
+			std::pair<SiblingIterator, SiblingIterator> oRange = poContent->oFilesByBasename.equal_range( GetKey(sBasename) );
+
+			for( SiblingIterator it = oRange.first; it != oRange.second; ++it )
+				{
+				if ( it->second != sFileName && EQUAL(::CPLGetExtension(it->second.c_str()), pszExt) )
+					{
+					sSiblingPath = sDirName + getDirSep(sDirName) + it->second;
+					return true;
+					}
+				}
+
+			return false;
+			}
+		}
+
+	std::string sLower = pszExt, sUpper = pszExt;
+	for( size_t i = 0; i < sLower.size(); i++ )
+		{
+		sLower[i] = (char) tolower(sLower[i]);
+		sUpper[i] = (char) toupper(sUpper[i]);
+		}
+
+	::VSIStatBufL psStatBuf;
+	const char *apszCandidates[2] = { sLower.c_str(), sUpper.c_str() };
+
+	for( int i = 0; i < 2; i++ )
+		{
+		std::string sCandidate = sDirName + getDirSep(sDirName) + sBasename + "." + apszCandidates[i];
+
+		if ( sCandidate == pszFilePath )
+			{ continue; }
+
+		PhaseTimer oTimer(PHASE_STAT);
+		countRunStats(COUNTER_STAT_CALLS);
+
+		if ( ::VSIStatExL( sCandidate.c_str(), &psStatBuf, VSI_STAT_EXISTS_FLAG) == 0 )
+			{
+			sSiblingPath = sCandidate;
+			return true;
+			}
+		}
+
+	return false;
+	}
+
+//***********************************************************************//
+//!Update the index after a file has been renamed
+//***********************************************************************//
+void SiblingIndex::Renamed(const std::string& sSourcePath, const std::string& sNewPath)
+	{
+	if ( !bReadDirectories && !bTrackRenames )
+		{ return; }
+
+	CPLMutexHolderD(&hMutex);
+
+	if ( bTrackRenames )
+		{
+		//the oldest renames are forgotten, their events are long gone
+		if ( oRenamedPaths.size() >= GDAL_RENAME_WATCH_RENAMES )
+			{ oRenamedPaths.clear(); }
+		oRenamedPaths.erase(sSourcePath);
+		oRenamedPaths.insert(sNewPath);
+		}
+
+	if ( !bReadDirectories )
+		{ return; }
+
+	std::map<std::string, DirectoryContent*>::iterator it = oDirectories.find( ::CPLGetDirname(sSourcePath.c_str()) );
+	if ( it != oDirectories.end() )
+		{
+		std::string sKey = GetKey(::CPLGetFilename(sSourcePath.c_str()));
+		typedef std::unordered_multimap<std::string, std::string>::iterator SiblingIterator;
+		std::pair<SiblingIterator, SiblingIterator> oRange = it->second->oFilesByBasename.equal_range( ::CPLGetBasename(sKey.c_str()) );
+
+		it->second->oFiles.erase(sKey);
+		for( SiblingIterator itFile = oRange.first; itFile != oRange.second; ++itFile )
+			{
+			if ( GetKey(itFile->second) == sKey )
+				{
+				it->second->oFilesByBasename.erase(itFile);
+				break;
+				}
+			}
+		}
+
+	it = oDirectories.find( ::CPLGetDirname(sNewPath.c_str()) );
+	if ( it != oDirectories.end() )
+		{
+		std::string sFileName = ::CPLGetFilename(sNewPath.c_str());
+		std::string sKey = GetKey(sFileName);
+
+		it->second->oFiles.insert(sKey);
+		it->second->oFilesByBasename.insert( std::make_pair( std::string(::CPLGetBasename(sKey.c_str())), sFileName ) );
+		}
+	}
+
+//***********************************************************************//
+//!Record the new paths of the renames (watch mode), so the events of the
+//!renames of this process are not taken for new datasets
+//***********************************************************************//
+void SiblingIndex::TrackRenames()
+	{
+	bTrackRenames = true;
+	}
+
+//***********************************************************************//
+//!Whether a path is the new path of a rename of this process
+//***********************************************************************//
+bool SiblingIndex::IsRenamedPath(const std::string& sFilePath)
+	{
+	CPLMutexHolderD(&hMutex);
+
+	return oRenamedPaths.count(sFilePath) > 0;
+	}
+
+//***********************************************************************//
+//!Powers of ten exactly represented as doubles (and as 64 bits integers)
+//***********************************************************************//
+#define GDAL_RENAME_DOUBLE_POWERS_OF_10	23
+#define GDAL_RENAME_INTEGER_POWERS_OF_10	20
+
+static const double adfPowersOf10[GDAL_RENAME_DOUBLE_POWERS_OF_10] =
+	{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+static const GUIntBig anPowersOf10[GDAL_RENAME_INTEGER_POWERS_OF_10] =
+	{
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL,
+	1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+	100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+	1000000000000000000ULL, 10000000000000000000ULL
+	};
+
+//***********************************************************************//
+//!Return number of digits from integer part of double : the powers of
+//!ten lower or equal to its absolute value, so 1000 has 4 digits (not
+//!ceil(log10) = 3), negative values count as positive ones, 0 below 1
+//***********************************************************************//
+int nDigits (double dValue)
+	{
+	double dAbsValue = fabs(dValue);
+
+	if ( dAbsValue >= adfPowersOf10[GDAL_RENAME_DOUBLE_POWERS_OF_10 - 1] )
+		{ return int(floor(log10(dAbsValue))) + 1; }
+
+	int nCount = 0;
+	while ( nCount < GDAL_RENAME_DOUBLE_POWERS_OF_10 && dAbsValue >= adfPowersOf10[nCount] )
+		{ nCount++; }
+
+	return nCount;
+	}
+
+//***********************************************************************//
+//!Add the georeferencing of a dataset to the arrays
+//***********************************************************************//
+void TileExtents::Add(const DatasetGeoRef& oGeoRef)
+	{
+	adfOriginX.push_back(oGeoRef.adfGeoTransform[0]);
+	adfPixelSizeX.push_back(oGeoRef.adfGeoTransform[1]);
+	adfOriginY.push_back(oGeoRef.adfGeoTransform[3]);
+	adfPixelSizeY.push_back(oGeoRef.adfGeoTransform[5]);
+	adfRasterSizeX.push_back(oGeoRef.nRasterXSize);
+	adfRasterSizeY.push_back(oGeoRef.nRasterYSize);
+	}
+
+void TileExtents::Clear()
+	{
+	adfOriginX.clear();
+	adfPixelSizeX.clear();
+	adfOriginY.clear();
+	adfPixelSizeY.clear();
+	adfRasterSizeX.clear();
+	adfRasterSizeY.clear();
+	}
+
+//***********************************************************************//
+//!Coordinates of one corner of a batch of tiles, the origin or (far
+//!corner) the origin + raster size * pixel size, as getCoord does
+//***********************************************************************//
+void computeTileCorners(size_t nTiles, const double* padfOrigin, const double* padfPixelSize, const double* padfRasterSize,
+						bool bFarCorner, double* padfCoords)
+	{
+	size_t i = 0;
+
+	if ( !bFarCorner )
+		{
+		memcpy(padfCoords, padfOrigin, nTiles * sizeof(double));
+		return;
+		}
+
+#if defined(GDAL_RENAME_HAVE_AVX2)
+	for( ; i + 4 <= nTiles; i += 4 )
+		{
+		__m256d vSize = _mm256_mul_pd(_mm256_loadu_pd(padfRasterSize + i), _mm256_loadu_pd(padfPixelSize + i));
+		_mm256_storeu_pd(padfCoords + i, _mm256_add_pd(_mm256_loadu_pd(padfOrigin + i), vSize));
+		}
+#elif defined(GDAL_RENAME_HAVE_SSE2)
+	for( ; i + 2 <= nTiles; i += 2 )
+		{
+		__m128d vSize = _mm_mul_pd(_mm_loadu_pd(padfRasterSize + i), _mm_loadu_pd(padfPixelSize + i));
+		_mm_storeu_pd(padfCoords + i, _mm_add_pd(_mm_loadu_pd(padfOrigin + i), vSize));
+		}
+#endif
+
+	for( ; i < nTiles; i++ )
+		{ padfCoords[i] = padfOrigin[i] + padfRasterSize[i] * padfPixelSize[i]; }
+	}
+
+//***********************************************************************//
+//!Digit counts of the reference points of a batch of tiles, the max of
+//!the nDigits of both coordinates. The vector kernels count the powers of
+//!ten lower or equal to the largest absolute value (a compare mask is -1
+//!as an integer), the scalar code handles the tail and the huge values
+//***********************************************************************//
+void computeDigitCounts(size_t nTiles, const double* padfCoordsX, const double* padfCoordsY, int* panDigits)
+	{
+	size_t i = 0;
+
+#if defined(GDAL_RENAME_HAVE_AVX2)
+	const __m256d vAbsMask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+
+	for( ; i + 4 <= nTiles; i += 4 )
+		{
+		__m256d vMax = _mm256_max_pd(_mm256_and_pd(_mm256_loadu_pd(padfCoordsX + i), vAbsMask),
+									 _mm256_and_pd(_mm256_loadu_pd(padfCoordsY + i), vAbsMask));
+		__m256i vCount = _mm256_setzero_si256();
+		GIntBig anCount[4];
+
+		for( int k = 0; k < GDAL_RENAME_DOUBLE_POWERS_OF_10; k++ )
+			{ vCount = _mm256_sub_epi64(vCount, _mm256_castpd_si256(_mm256_cmp_pd(vMax, _mm256_set1_pd(adfPowersOf10[k]), _CMP_GE_OQ))); }
+
+		_mm256_storeu_si256((__m256i *) anCount, vCount);
+		for( int j = 0; j < 4; j++ )
+			{ panDigits[i + j] = (int) anCount[j]; }
+		}
+#elif defined(GDAL_RENAME_HAVE_SSE2)
+	const __m128d vAbsMask = _mm_castsi128_pd(_mm_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+
+	for( ; i + 2 <= nTiles; i += 2 )
+		{
+		__m128d vMax = _mm_max_pd(_mm_and_pd(_mm_loadu_pd(padfCoordsX + i), vAbsMask),
+								  _mm_and_pd(_mm_loadu_pd(padfCoordsY + i), vAbsMask));
+		__m128i vCount = _mm_setzero_si128();
+		GIntBig anCount[2];
+
+		for( int k = 0; k < GDAL_RENAME_DOUBLE_POWERS_OF_10; k++ )
+			{ vCount = _mm_sub_epi64(vCount, _mm_castpd_si128(_mm_cmpge_pd(vMax, _mm_set1_pd(adfPowersOf10[k])))); }
+
+		_mm_storeu_si128((__m128i *) anCount, vCount);
+		panDigits[i] = (int) anCount[0];
+		panDigits[i + 1] = (int) anCount[1];
+		}
+#endif
+
+	//values beyond the exact powers of ten (not projected coordinates) by nDigits
+	for( size_t j = 0; j < i; j++ )
+		{
+		if ( panDigits[j] == GDAL_RENAME_DOUBLE_POWERS_OF_10 )
+			{ panDigits[j] = std::max(nDigits(padfCoordsX[j]), nDigits(padfCoordsY[j])); }
+		}
+
+	for( ; i < nTiles; i++ )
+		{ panDigits[i] = std::max(nDigits(padfCoordsX[i]), nDigits(padfCoordsY[i])); }
+	}
+
+//***********************************************************************//
+//!Get integer coordinate from dataset georeferencing
+//***********************************************************************//
+double getCoord (char refPointPart, const DatasetGeoRef& oGeoRef)
+	{
+	const double *adfGeoTransform = oGeoRef.adfGeoTransform;
+	double Coord = 0.;
+
+	switch ( refPointPart )
+		{
+		case 'W' : Coord = adfGeoTransform[0]; break;
+		case 'E' : Coord = (adfGeoTransform[0]+(oGeoRef.nRasterXSize*adfGeoTransform[1])); break;
+		case 'S' : Coord = (adfGeoTransform[3]+(oGeoRef.nRasterYSize*adfGeoTransform[5])); break;
+		case 'N' : Coord = adfGeoTransform[3]; break;
+		default	 : Coord = adfGeoTransform[0];
+		}
+
+	return Coord;
+	}
+
+//***********************************************************************//
+//!Get char of coordinate hemisphere from dataset georeferencing
+//***********************************************************************//
+char getCoordHemi (char refPointPart, const DatasetGeoRef& oGeoRef)
+	{
+	return getHemi(refPointPart, getCoord(refPointPart, oGeoRef));
+	}
+
+//***********************************************************************//
+//!Get char of coordinate hemisphere from a (possibly reprojected) coordinate
+//***********************************************************************//
+char getHemi (char refPointPart, double Coord)
+	{
+	char Hemi = 'N';
+
+	if ( Coord >= 0 )
+		{
+		if (refPointPart == 'W' || refPointPart == 'E')
+			{ Hemi = 'E'; }
+		else
+			{ Hemi = 'N'; }
+		}
+	else
+		{
+		if (refPointPart == 'W' || refPointPart == 'E')
+			{ Hemi = 'W'; }
+		else
+			{ Hemi = 'S'; }
+		}
+
+	return Hemi;
+	}
+
+//***********************************************************************//
+//!Parse the format spec of a coordinate field of a name template or of
+//!a printf conversion : [-+0 #][width][.precision]. Return the position
+//!after it
+//***********************************************************************//
+static size_t parseNameFieldSpec(const std::string& sSpec, size_t nPos, NameToken& oToken)
+	{
+	for( ; nPos < sSpec.size(); nPos++ )
+		{
+		if ( sSpec[nPos] == '-' )
+			{ oToken.bLeft = true; }
+		else if ( sSpec[nPos] == '+' )
+			{ oToken.bPlus = true; }
+		else if ( sSpec[nPos] == '0' )
+			{ oToken.bZero = true; }
+		else if ( sSpec[nPos] == ' ' )
+			{ oToken.bSpace = true; }
+		else if ( sSpec[nPos] == '#' )
+			{ oToken.bAlternate = true; }
+		else
+			{ break; }
+		}
+
+	for( ; nPos < sSpec.size() && isdigit((unsigned char) sSpec[nPos]) && oToken.nWidth < 256; nPos++ )
+		{ oToken.nWidth = oToken.nWidth * 10 + (sSpec[nPos] - '0'); }
+
+	if ( nPos < sSpec.size() && sSpec[nPos] == '.' )
+		{
+		oToken.nPrecision = 0;
+		for( nPos++; nPos < sSpec.size() && isdigit((unsigned char) sSpec[nPos]) && oToken.nPrecision < 256; nPos++ )
+			{ oToken.nPrecision = oToken.nPrecision * 10 + (sSpec[nPos] - '0'); }
+		}
+
+	return nPos;
+	}
+
+//***********************************************************************//
+//!Name template constructor, nothing compiled yet
+//***********************************************************************//
+NameTemplate::NameTemplate()
+	{
+	chRefPointX = 'W';
+	chRefPointY = 'N';
+	poTileGrid = NULL;
+	}
+
+//***********************************************************************//
+//!Add a literal text token, the names can't contain directories
+//***********************************************************************//
+bool NameTemplate::AddLiteral(const std::string& sText, std::string& sError)
+	{
+	if ( sText.find_first_of("/\\") != std::string::npos )
+		{
+		sError = "'" + sText + "' : the new names can't contain a directory separator";
+		return false;
+		}
+
+	if ( sText.empty() )
+		{ return true; }
+
+	if ( !aoTokens.empty() && aoTokens.back().eType == NAME_TOKEN_LITERAL )
+		{ aoTokens.back().sText += sText; }
+	else
+		{
+		NameToken oToken;
+		oToken.eType = NAME_TOKEN_LITERAL;
+		oToken.sText = sText;
+		aoTokens.push_back(oToken);
+		}
+
+	return true;
+	}
+
+//***********************************************************************//
+//!Compile the naming of a run : the --name-template, the --printf-syntax
+//!or the coordinates options (prefix, length, type, sign, separator,
+//!suffix). Done once before any dataset is opened, a malformed template
+//!is reported in sError
+//***********************************************************************//
+bool NameTemplate::Compile(const RenameOptions& oOptions, std::string& sError)
+	{
+	aoTokens.clear();
+	poTileGrid = oOptions.poTileGrid;
+	sOffGridSuffix = oOptions.pszOffGridSuffix;
+
+	if ( sOffGridSuffix.find_first_of("/\\") != std::string::npos )
+		{
+		sError = "'" + sOffGridSuffix + "' : the new names can't contain a directory separator";
+		return false;
+		}
+
+	for( int i = 0; i < 2; i++ )
+		{
+		char chRefPoint = (char) toupper((unsigned char) oOptions.pszCoordRefPoint[i]);
+
+		if ( chRefPoint == 'W' || chRefPoint == 'E' )
+			{ chRefPointX = chRefPoint; }
+		else
+			{ chRefPointY = chRefPoint; }
+		}
+
+	if ( !EQUAL(oOptions.pszNameTemplate, "") )
+		{ return CompileTemplate(oOptions.pszNameTemplate, oOptions, sError); }
+	if ( !EQUAL(oOptions.pszPrintf, "") )
+		{ return CompilePrintf(oOptions.pszPrintf, oOptions, sError); }
+
+	//coordinates options, the same names as the historical printf formats
+	bool bReal = EQUAL(oOptions.pszCoordType, "real");
+	bool bGrid = EQUAL(oOptions.pszCoordType, "grid");
+	bool bGeo = EQUAL(oOptions.pszCoordSignType, "geo") && !bGrid;
+	int nLength = atoi(oOptions.pszCoordLenght);
+	int nDecLength = atoi(oOptions.pszCoordDecLenght);
+
+	if ( nLength <= 0 || nDecLength < 0 )
+		{
+		sError = CPLSPrintf("Invalid coordinates length '%s' or decimal length '%s'", oOptions.pszCoordLenght, oOptions.pszCoordDecLenght);
+		return false;
+		}
+
+	NameToken oCoord;
+	oCoord.eType = NAME_TOKEN_COORD;
+	oCoord.bPlus = !bGeo && EQUALN(oOptions.pszCoordSignType, "force", 4);
+	oCoord.bZero = bReal;
+	oCoord.nWidth = bReal ? nLength : 0;
+	oCoord.nPrecision = bReal ? nDecLength : nLength;
+	oCoord.chConversion = bReal ? 'f' : 't';
+
+	//grid indices : at least --coord-length digits
+	if ( bGrid )
+		{
+		oCoord.nPrecision = nLength;
+		oCoord.chConversion = 'd';
+		}
+
+	if ( !AddLiteral(oOptions.pszPrefix, sError) )
+		{ return false; }
+
+	for( int i = 0; i < 2; i++ )
+		{
+		char chRefPoint = (char) toupper((unsigned char) oOptions.pszCoordRefPoint[i]);
+
+		if ( i == 1 && !AddLiteral(oOptions.pszCoordSep, sError) )
+			{ return false; }
+
+		if ( bGeo )
+			{
+			NameToken oHemi;
+			oHemi.eType = NAME_TOKEN_HEMI;
+			oHemi.chRefPoint = chRefPoint;
+			aoTokens.push_back(oHemi);
+			}
+
+		oCoord.chRefPoint = chRefPoint;
+		if ( bGrid )
+			{ oCoord.eType = ( chRefPoint == 'W' || chRefPoint == 'E' ) ? NAME_TOKEN_COL : NAME_TOKEN_ROW; }
+		aoTokens.push_back(oCoord);
+		}
+
+	return AddLiteral(oOptions.pszSuffix, sError);
+	}
+
+//***********************************************************************//
+//!Compile a name template : literal text and {field} or {field:spec}
+//!with {{ and }} for literal braces. Fields : x, y (coordinates of the
+//!reference point, spec [-+0 #][width][.precision]d|f|t), hemi_x,
+//!hemi_y, hemi (hemisphere letters), col, row (indices in the tiles grid,
+//!spec [-+0 #][width][.precision]d), prefix, suffix and sep (options)
+//***********************************************************************//
+bool NameTemplate::CompileTemplate(const std::string& sTemplate, const RenameOptions& oOptions, std::string& sError)
+	{
+	std::string sText;
+
+	for( size_t nPos = 0; nPos < sTemplate.size(); nPos++ )
+		{
+		char ch = sTemplate[nPos];
+
+		if ( (ch == '{' || ch == '}') && nPos + 1 < sTemplate.size() && sTemplate[nPos + 1] == ch )
+			{
+			sText += ch;
+			nPos++;
+			continue;
+			}
+		if ( ch == '}' )
+			{
+			sError = CPLSPrintf("Unmatched '}' at position %d of the name template", (int) nPos);
+			return false;
+			}
+		if ( ch != '{' )
+			{
+			sText += ch;
+			continue;
+			}
+
+		size_t nEnd = sTemplate.find('}', nPos);
+		if ( nEnd == std::string::npos )
+			{
+			sError = CPLSPrintf("Unmatched '{' at position %d of the name template", (int) nPos);
+			return false;
+			}
+
+		std::string sField = sTemplate.substr(nPos + 1, nEnd - nPos - 1);
+		std::string sSpec;
+		size_t nColon = sField.find(':');
+
+		if ( nColon != std::string::npos )
+			{
+			sSpec = sField.substr(nColon + 1);
+			sField.resize(nColon);
+			}
+		nPos = nEnd;
+
+		//options values are literal text
+		if ( sField == "prefix" || sField == "suffix" || sField == "sep" )
+			{
+			if ( !sSpec.empty() )
+				{
+				sError = "The field {" + sField + "} has no format spec";
+				return false;
+				}
+
+			sText += ( sField == "prefix" ) ? oOptions.pszPrefix : ( sField == "suffix" ) ? oOptions.pszSuffix : oOptions.pszCoordSep;
+			continue;
+			}
+
+		if ( !AddLiteral(sText, sError) )
+			{ return false; }
+		sText.clear();
+
+		NameToken oToken;
+
+		if ( sField == "hemi_x" || sField == "hemi_y" || sField == "hemi" )
+			{
+			if ( !sSpec.empty() )
+				{
+				sError = "The field {" + sField + "} has no format spec";
+				return false;
+				}
+
+			oToken.eType = NAME_TOKEN_HEMI;
+			for( int i = 0; i < 2; i++ )
+				{
+				char chRefPoint = (char) toupper((unsigned char) oOptions.pszCoordRefPoint[i]);
+				bool bX = ( chRefPoint == 'W' || chRefPoint == 'E' );
+
+				if ( sField == "hemi" || (sField == "hemi_x") == bX )
+					{
+					oToken.chRefPoint = chRefPoint;
+					aoTokens.push_back(oToken);
+					}
+				}
+			}
+		else if ( sField == "x" || sField == "y" )
+			{
+			oToken.eType = NAME_TOKEN_COORD;
+			oToken.chRefPoint = ( sField == "x" ) ? chRefPointX : chRefPointY;
+
+			size_t nSpecEnd = parseNameFieldSpec(sSpec, 0, oToken);
+
+			if ( nSpecEnd < sSpec.size() )
+				{ oToken.chConversion = sSpec[nSpecEnd++]; }
+
+			if ( nSpecEnd != sSpec.size() || (oToken.chConversion != 'd' && oToken.chConversion != 'f' && oToken.chConversion != 't') ||
+				 (oToken.chConversion == 't' && oToken.nPrecision <= 0) )
+				{
+				sError = "Invalid format spec '" + sSpec + "' of the field {" + sField + "}, expected [-+0 #][width][.precision]d|f|t";
+				return false;
+				}
+
+			aoTokens.push_back(oToken);
+			}
+		else if ( sField == "col" || sField == "row" )
+			{
+			oToken.eType = ( sField == "col" ) ? NAME_TOKEN_COL : NAME_TOKEN_ROW;
+
+			size_t nSpecEnd = parseNameFieldSpec(sSpec, 0, oToken);
+
+			if ( nSpecEnd < sSpec.size() )
+				{ oToken.chConversion = sSpec[nSpecEnd++]; }
+
+			if ( nSpecEnd != sSpec.size() || oToken.chConversion != 'd' )
+				{
+				sError = "Invalid format spec '" + sSpec + "' of the field {" + sField + "}, expected [-+0 #][width][.precision]d";
+				return false;
+				}
+
+			aoTokens.push_back(oToken);
+			}
+		else
+			{
+			sError = "Unknown field {" + sField + "} in the name template";
+			return false;
+			}
+		}
+
+	return AddLiteral(sText, sError);
+	}
+
+//***********************************************************************//
+//!Compile a --printf-syntax format, checked against the arguments it was
+//!given historically : the two coordinates (int, or double with
+//!--coord-type real), each preceded by its hemisphere (char) with
+//!--coord-sign geo
+//***********************************************************************//
+bool NameTemplate::CompilePrintf(const std::string& sFormat, const RenameOptions& oOptions, std::string& sError)
+	{
+	bool bReal = EQUAL(oOptions.pszCoordType, "real");
+	bool bGeo = EQUAL(oOptions.pszCoordSignType, "geo");
+	int nArgs = bGeo ? 4 : 2, nArg = 0;
+	std::string sText;
+
+	for( size_t nPos = 0; nPos < sFormat.size(); nPos++ )
+		{
+		if ( sFormat[nPos] != '%' )
+			{
+			sText += sFormat[nPos];
+			continue;
+			}
+		if ( nPos + 1 < sFormat.size() && sFormat[nPos + 1] == '%' )
+			{
+			sText += '%';
+			nPos++;
+			continue;
+			}
+
+		NameToken oToken;
+		size_t nConversion = parseNameFieldSpec(sFormat, nPos + 1, oToken);
+
+		//the length modifiers (ie: %ld, %lf) don't change the formatting of the coordinates
+		while ( nConversion < sFormat.size() && strchr("hlLqjz", sFormat[nConversion]) != NULL )
+			{ nConversion++; }
+
+		char chConversion = nConversion < sFormat.size() ? sFormat[nConversion] : '\0';
+		bool bHemiArg = bGeo && (nArg % 2) == 0;
+		char chExpected = bHemiArg ? 'c' : bReal ? 'f' : 'd';
+
+		if ( chConversion == 'i' )
+			{ chConversion = 'd'; }
+		else if ( chConversion == 'F' )
+			{ chConversion = 'f'; }
+
+		if ( chConversion == '\0' || strchr("dfc", chConversion) == NULL )
+			{
+			sError = CPLSPrintf("Invalid --printf-syntax '%s' : unsupported conversion '%s' (%%d, %%i, %%f or %%c)",
+								sFormat.c_str(), sFormat.substr(nPos, nConversion - nPos + 1).c_str());
+			return false;
+			}
+
+		if ( nArg >= nArgs || chConversion != chExpected )
+			{
+			sError = CPLSPrintf("Invalid --printf-syntax '%s' : expected %d conversions (%s), found '%s'",
+								sFormat.c_str(), nArgs,
+								bGeo ? ( bReal ? "%c %f %c %f" : "%c %d %c %d" ) : ( bReal ? "%f %f" : "%d %d" ),
+								sFormat.substr(nPos, nConversion - nPos + 1).c_str());
+			return false;
+			}
+
+		if ( !AddLiteral(sText, sError) )
+			{ return false; }
+		sText.clear();
+
+		oToken.eType = bHemiArg ? NAME_TOKEN_HEMI : NAME_TOKEN_COORD;
+		oToken.chRefPoint = (char) toupper((unsigned char) oOptions.pszCoordRefPoint[bGeo ? nArg / 2 : nArg]);
+		oToken.chConversion = chConversion;
+		aoTokens.push_back(oToken);
+
+		nArg++;
+		nPos = nConversion;
+		}
+
+	if ( nArg != nArgs )
+		{
+		sError = CPLSPrintf("Invalid --printf-syntax '%s' : %d conversion(s) found, %d expected", sFormat.c_str(), nArg, nArgs);
+		return false;
+		}
+
+	return AddLiteral(sText, sError);
+	}
+
+//***********************************************************************//
+//!Write the nDigits last decimal digits of a number backward before
+//!pszEnd, two digits at a time from a table. Return the first digit
+//***********************************************************************//
+static char* writeDigitsBackward(char* pszEnd, GUIntBig nValue, int nDigits)
+	{
+	static const char szDigitPairs[] =
+		"0001020304050607080910111213141516171819"
+		"2021222324252627282930313233343536373839"
+		"4041424344454647484950515253545556575859"
+		"6061626364656667686970717273747576777879"
+		"8081828384858687888990919293949596979899";
+
+	while ( nDigits >= 2 )
+		{
+		const char *pszPair = szDigitPairs + 2 * (nValue % 100);
+		*--pszEnd = pszPair[1];
+		*--pszEnd = pszPair[0];
+		nValue /= 100;
+		nDigits -= 2;
+		}
+
+	if ( nDigits == 1 )
+		{ *--pszEnd = (char)('0' + nValue % 10); }
+
+	return pszEnd;
+	}
+
+//***********************************************************************//
+//!Append a formatted number to a name : sign, the digits of the integer
+//!part (at least nMinDigits) then the decimals, padded to the token
+//!width as printf does. No allocation but the one of the name itself
+//***********************************************************************//
+static void appendNumber(std::string& sName, const NameToken& oToken, bool bNegative, GUIntBig nInteger,
+						 int nMinDigits, GUIntBig nDecimals, int nDecimalDigits)
+	{
+	char szDigits[64];
+	char *pszEnd = szDigits + sizeof(szDigits);
+	char *pszStart = pszEnd;
+
+	//decimals then integer part, backward
+	if ( nDecimalDigits > 0 )
+		{
+		pszStart = writeDigitsBackward(pszStart, nDecimals, nDecimalDigits);
+		*--pszStart = '.';
+		}
+	else if ( oToken.bAlternate && oToken.chConversion == 'f' )
+		{ *--pszStart = '.'; }
+
+	int nIntegerDigits = 1;
+	while ( nIntegerDigits < GDAL_RENAME_INTEGER_POWERS_OF_10 && nInteger >= anPowersOf10[nIntegerDigits] )
+		{ nIntegerDigits++; }
+	if ( nInteger == 0 )
+		{ nIntegerDigits = 0; }
+
+	nIntegerDigits = std::min( std::max(nIntegerDigits, nMinDigits), (int)(pszStart - szDigits) );
+	pszStart = writeDigitsBackward(pszStart, nInteger, nIntegerDigits);
+
+	int nDigitsCount = (int)(pszEnd - pszStart);
+
+	char chSign = bNegative ? '-' : oToken.bPlus ? '+' : oToken.bSpace ? ' ' : '\0';
+	int nLength = nDigitsCount + ( chSign != '\0' ? 1 : 0 );
+	int nPadding = oToken.nWidth > nLength ? oToken.nWidth - nLength : 0;
+	//as printf, the 0 flag is ignored for integers with a precision
+	bool bZeroPadding = oToken.bZero && !oToken.bLeft && ( oToken.chConversion == 'f' || oToken.nPrecision < 0 );
+
+	if ( !oToken.bLeft && !bZeroPadding )
+		{ sName.append(nPadding, ' '); }
+	if ( chSign != '\0' )
+		{ sName += chSign; }
+	if ( bZeroPadding )
+		{ sName.append(nPadding, '0'); }
+
+	sName.append(pszStart, nDigitsCount);
+
+	if ( oToken.bLeft )
+		{ sName.append(nPadding, ' '); }
+	}
+
+//***********************************************************************//
+//!Append a coordinate formatted by a token
+//***********************************************************************//
+static void appendCoord(std::string& sName, const NameToken& oToken, double dCoord, int nCoordsDigits)
+	{
+	if ( oToken.chConversion == 'f' )
+		{
+		int nDecimals = oToken.nPrecision < 0 ? 6 : oToken.nPrecision;
+		double dScaled = nDecimals <= 12 ? fabs(dCoord) * adfPowersOf10[nDecimals] : 0;
+		double dFraction = dScaled - floor(dScaled);
+
+		//fixed point, unless the rounding could differ from printf's one
+		if ( nDecimals <= 12 && dScaled < 4e15 && fabs(dFraction - 0.5) > 1e-6 )
+			{
+			GUIntBig nScaled = (GUIntBig)( dScaled + 0.5 );
+			GUIntBig nPower = anPowersOf10[nDecimals];
+			appendNumber(sName, oToken, dCoord < 0, nScaled / nPower, 1, nScaled % nPower, nDecimals);
+			}
+		else
+			{
+			char szFormat[32], szNumber[512];
+			snprintf(szFormat, sizeof(szFormat), "%%%s%s%s%s%s%d.%df", oToken.bLeft ? "-" : "", oToken.bPlus ? "+" : "",
+					 oToken.bSpace ? " " : "", oToken.bAlternate ? "#" : "", oToken.bZero ? "0" : "", oToken.nWidth, nDecimals);
+			::CPLsnprintf(szNumber, sizeof(szNumber), szFormat, dCoord);
+			sName += szNumber;
+			}
+		return;
+		}
+
+	//'t' keeps the nPrecision high weight digits of the coordinates
+	if ( oToken.chConversion == 't' && nCoordsDigits > oToken.nPrecision )
+		{
+		int nShift = nCoordsDigits - oToken.nPrecision;
+		dCoord = dCoord / ( nShift < GDAL_RENAME_DOUBLE_POWERS_OF_10 ? adfPowersOf10[nShift] : pow(10., nShift) );
+		}
+
+	GIntBig nCoord = (GIntBig) dCoord;
+	GUIntBig nAbsCoord = nCoord < 0 ? (GUIntBig)(-(nCoord + 1)) + 1 : (GUIntBig) nCoord;
+
+	appendNumber(sName, oToken, nCoord < 0, nAbsCoord, oToken.nPrecision < 0 ? 1 : oToken.nPrecision, 0, 0);
+	}
+
+//***********************************************************************//
+//!Append a hemisphere letter, padded to the token width as %c does
+//***********************************************************************//
+static void appendHemi(std::string& sName, const NameToken& oToken, char chHemi)
+	{
+	int nPadding = oToken.nWidth > 1 ? oToken.nWidth - 1 : 0;
+
+	if ( !oToken.bLeft )
+		{ sName.append(nPadding, ' '); }
+	sName += chHemi;
+	if ( oToken.bLeft )
+		{ sName.append(nPadding, ' '); }
+	}
+
+//***********************************************************************//
+//!Append a grid index formatted by a token
+//***********************************************************************//
+static void appendIndex(std::string& sName, const NameToken& oToken, GIntBig nIndex)
+	{
+	GUIntBig nAbsIndex = nIndex < 0 ? (GUIntBig)(-(nIndex + 1)) + 1 : (GUIntBig) nIndex;
+
+	appendNumber(sName, oToken, nIndex < 0, nAbsIndex, oToken.nPrecision < 0 ? 1 : oToken.nPrecision, 0, 0);
+	}
+
+//***********************************************************************//
+//!Render the new name of a dataset, appended to sName
+//***********************************************************************//
+void NameTemplate::Render(const DatasetGeoRef& oGeoRef, std::string& sName) const
+	{
+	double dCoordX, dCoordY;
+
+	GetCoords(oGeoRef, dCoordX, dCoordY);
+	RenderCoords(dCoordX, dCoordY, sName);
+	}
+
+//***********************************************************************//
+//!Coordinates of the reference point of a dataset, used for its name
+//***********************************************************************//
+void NameTemplate::GetCoords(const DatasetGeoRef& oGeoRef, double& dCoordX, double& dCoordY) const
+	{
+	dCoordX = getCoord(chRefPointX, oGeoRef);
+	dCoordY = getCoord(chRefPointY, oGeoRef);
+	}
+
+//***********************************************************************//
+//!Render a new name from the coordinates of the reference point (in the
+//!target SRS with --target-srs), appended to sName
+//***********************************************************************//
+void NameTemplate::RenderCoords(double dCoordX, double dCoordY, std::string& sName) const
+	{
+	RenderCoords(dCoordX, dCoordY, std::max(nDigits(dCoordX), nDigits(dCoordY)), sName);
+	}
+
+//***********************************************************************//
+//!Coordinates of the reference points of a batch of datasets, computed
+//!by the vector kernels
+//***********************************************************************//
+void NameTemplate::GetCoordsBatch(const TileExtents& oExtents, std::vector<double>& adfCoordsX, std::vector<double>& adfCoordsY) const
+	{
+	size_t nTiles = oExtents.Size();
+
+	adfCoordsX.resize(nTiles);
+	adfCoordsY.resize(nTiles);
+	if ( nTiles == 0 )
+		{ return; }
+
+	computeTileCorners(nTiles, &oExtents.adfOriginX[0], &oExtents.adfPixelSizeX[0], &oExtents.adfRasterSizeX[0],
+					   chRefPointX == 'E', &adfCoordsX[0]);
+	computeTileCorners(nTiles, &oExtents.adfOriginY[0], &oExtents.adfPixelSizeY[0], &oExtents.adfRasterSizeY[0],
+					   chRefPointY == 'S', &adfCoordsY[0]);
+	}
+
+//***********************************************************************//
+//!Render the new names of a batch of datasets from the coordinates of
+//!their reference points, the digit counts are computed for the whole
+//!batch first. Same names as RenderCoords
+//***********************************************************************//
+void NameTemplate::RenderBatch(const std::vector<double>& adfCoordsX, const std::vector<double>& adfCoordsY, std::vector<std::string>& asNames) const
+	{
+	size_t nTiles = adfCoordsX.size();
+	std::vector<int> anDigits(nTiles);
+
+	asNames.resize(nTiles);
+	if ( nTiles == 0 )
+		{ return; }
+
+	computeDigitCounts(nTiles, &adfCoordsX[0], &adfCoordsY[0], &anDigits[0]);
+
+	for( size_t i = 0; i < nTiles; i++ )
+		{
+		asNames[i].clear();
+		RenderCoords(adfCoordsX[i], adfCoordsY[i], anDigits[i], asNames[i]);
+		}
+	}
+
+//***********************************************************************//
+//!Render a new name from the coordinates of the reference point and
+//!their digit count, appended to sName
+//***********************************************************************//
+void NameTemplate::RenderCoords(double dCoordX, double dCoordY, int nCoordsDigits, std::string& sName) const
+	{
+	GIntBig nCol = 0, nRow = 0;
+	bool bOnGrid = true;
+
+	if ( HasGridFields() )
+		{ bOnGrid = GetGridIndex(dCoordX, dCoordY, nCol, nRow); }
+
+	for( size_t i = 0; i < aoTokens.size(); i++ )
+		{
+		const NameToken& oToken = aoTokens[i];
+
+		switch ( oToken.eType )
+			{
+			case NAME_TOKEN_LITERAL : sName += oToken.sText; break;
+			case NAME_TOKEN_HEMI	: appendHemi(sName, oToken, getHemi(oToken.chRefPoint, oToken.chRefPoint == chRefPointX ? dCoordX : dCoordY)); break;
+			case NAME_TOKEN_COL		: appendIndex(sName, oToken, nCol); break;
+			case NAME_TOKEN_ROW		: appendIndex(sName, oToken, nRow); break;
+			case NAME_TOKEN_COORD	: appendCoord(sName, oToken, oToken.chRefPoint == chRefPointX ? dCoordX : dCoordY, nCoordsDigits); break;
+			}
+		}
+
+	if ( !bOnGrid )
+		{ sName += sOffGridSuffix; }
+	}
+
+//***********************************************************************//
+//!Whether the names use the tiles grid ({col}, {row} or --coord-type grid)
+//***********************************************************************//
+bool NameTemplate::HasGridFields() const
+	{
+	for( size_t i = 0; i < aoTokens.size(); i++ )
+		{
+		if ( aoTokens[i].eType == NAME_TOKEN_COL || aoTokens[i].eType == NAME_TOKEN_ROW )
+			{ return true; }
+		}
+
+	return false;
+	}
+
+//***********************************************************************//
+//!Column and row of the grid node of a reference point. The rows go
+//!south from the grid origin (north to south with a S reference point).
+//!The nearest node is taken then checked, so 2.9999999 tiles is the node
+//!3 and not 2 as a truncation would give. Return false if the point is
+//!off the grid, the indices are then the ones of the cell holding it
+//***********************************************************************//
+bool NameTemplate::GetGridIndex(double dCoordX, double dCoordY, GIntBig& nCol, GIntBig& nRow) const
+	{
+	nCol = 0;
+	nRow = 0;
+
+	//not inferred yet (names rendered outside of the batch, ie: the benchmark)
+	if ( poTileGrid == NULL || !poTileGrid->bValid )
+		{ return true; }
+
+	double dOffsetX = ( dCoordX - poTileGrid->dOriginX ) / poTileGrid->dTileSizeX;
+	double dOffsetY = ( chRefPointY == 'S' ? dCoordY - poTileGrid->dOriginY : poTileGrid->dOriginY - dCoordY ) / poTileGrid->dTileSizeY;
+
+	if ( !( fabs(dOffsetX) < 1e15 && fabs(dOffsetY) < 1e15 ) )
+		{ return false; }
+
+	double dCol = floor(dOffsetX + 0.5);
+	double dRow = floor(dOffsetY + 0.5);
+
+	if ( fabs(dOffsetX - dCol) <= GDAL_RENAME_GRID_TOLERANCE && fabs(dOffsetY - dRow) <= GDAL_RENAME_GRID_TOLERANCE )
+		{
+		nCol = (GIntBig) dCol;
+		nRow = (GIntBig) dRow;
+		return true;
+		}
+
+	nCol = (GIntBig) floor(dOffsetX);
+	nRow = (GIntBig) floor(dOffsetY);
+	return false;
+	}
+
+//***********************************************************************//
+//!Parse a --grid value : "auto" (inferred from the batch) or the origin
+//!and the (positive) tiles size, comma separated
+//***********************************************************************//
+bool parseTileGrid(const char* pszGrid, TileGrid& oGrid)
+	{
+	if ( EQUAL(pszGrid, "auto") )
+		{
+		oGrid.bInfer = true;
+		oGrid.bValid = false;
+		return true;
+		}
+
+	char **papszValues = ::CSLTokenizeString2( pszGrid, ",", 0 );
+	bool bSuccess = ( ::CSLCount(papszValues) == 4 );
+
+	if ( bSuccess )
+		{
+		oGrid.dOriginX = ::CPLAtof(papszValues[0]);
+		oGrid.dOriginY = ::CPLAtof(papszValues[1]);
+		oGrid.dTileSizeX = ::CPLAtof(papszValues[2]);
+		oGrid.dTileSizeY = ::CPLAtof(papszValues[3]);
+		bSuccess = oGrid.dTileSizeX > 0.0 && oGrid.dTileSizeY > 0.0;
+		}
+
+	::CSLDestroy(papszValues);
+
+	oGrid.bInfer = false;
+	oGrid.bValid = bSuccess;
+	return bSuccess;
+	}
+
+//***********************************************************************//
+//!Bin of the phase of a coordinate in the tiles size (position in its
+//!tile, from 0 to 1) by steps of the grid tolerance, 0 and 1 are merged
+//***********************************************************************//
+static GIntBig getGridPhaseBin(double dCoord, double dTileSize)
+	{
+	const GIntBig nBins = (GIntBig)( 1.0 / GDAL_RENAME_GRID_TOLERANCE );
+	double dTiles = dCoord / dTileSize;
+	GIntBig nBin = (GIntBig) floor( (dTiles - floor(dTiles)) * nBins + 0.5 );
+
+	return nBin >= nBins ? 0 : nBin;
+	}
+
+//***********************************************************************//
+//!Infer the tiles grid of a batch in linear time : the most common tiles
+//!size, then the most common phase of the reference points in it (hashed
+//!by bins of the grid tolerance) and the origin at the first column and
+//!row of the tiles on this phase. The other tiles are off the grid
+//***********************************************************************//
+bool inferTileGrid(const std::vector<RenameJob>& aoJobs, bool bRowsNorthward, TileGrid& oGrid)
+	{
+	//a batch has a few distinct tiles sizes
+	std::map< std::pair<double, double>, size_t > oSizes;
+	std::pair<double, double> oSize(0.0, 0.0);
+	size_t nSizeCount = 0;
+
+	for( size_t i = 0; i < aoJobs.size(); i++ )
+		{
+		if ( aoJobs[i].bSuccess && aoJobs[i].dTileSizeX > 0.0 && aoJobs[i].dTileSizeY > 0.0 )
+			{ oSizes[ std::make_pair(aoJobs[i].dTileSizeX, aoJobs[i].dTileSizeY) ]++; }
+		}
+
+	for( std::map< std::pair<double, double>, size_t >::iterator it = oSizes.begin(); it != oSizes.end(); ++it )
+		{
+		if ( it->second > nSizeCount )
+			{
+			oSize = it->first;
+			nSizeCount = it->second;
+			}
+		}
+
+	if ( nSizeCount == 0 )
+		{ return false; }
+
+	std::unordered_map<GIntBig, size_t> oPhasesX, oPhasesY;
+	GIntBig nPhaseX = 0, nPhaseY = 0;
+
+	for( size_t i = 0; i < aoJobs.size(); i++ )
+		{
+		if ( aoJobs[i].bSuccess && aoJobs[i].dTileSizeX == oSize.first && aoJobs[i].dTileSizeY == oSize.second )
+			{
+			size_t nCountX = ++oPhasesX[ getGridPhaseBin(aoJobs[i].dCoordX, oSize.first) ];
+			size_t nCountY = ++oPhasesY[ getGridPhaseBin(aoJobs[i].dCoordY, oSize.second) ];
+
+			if ( nCountX > oPhasesX[nPhaseX] )
+				{ nPhaseX = getGridPhaseBin(aoJobs[i].dCoordX, oSize.first); }
+			if ( nCountY > oPhasesY[nPhaseY] )
+				{ nPhaseY = getGridPhaseBin(aoJobs[i].dCoordY, oSize.second); }
+			}
+		}
+
+	bool bFirst = true;
+
+	for( size_t i = 0; i < aoJobs.size(); i++ )
+		{
+		const RenameJob& oJob = aoJobs[i];
+
+		if ( !oJob.bSuccess || oJob.dTileSizeX != oSize.first || oJob.dTileSizeY != oSize.second ||
+			 getGridPhaseBin(oJob.dCoordX, oSize.first) != nPhaseX || getGridPhaseBin(oJob.dCoordY, oSize.second) != nPhaseY )
+			{ continue; }
+
+		if ( bFirst || oJob.dCoordX < oGrid.dOriginX )
+			{ oGrid.dOriginX = oJob.dCoordX; }
+		if ( bFirst || ( bRowsNorthward ? oJob.dCoordY < oGrid.dOriginY : oJob.dCoordY > oGrid.dOriginY ) )
+			{ oGrid.dOriginY = oJob.dCoordY; }
+		bFirst = false;
+		}
+
+	oGrid.dTileSizeX = oSize.first;
+	oGrid.dTileSizeY = oSize.second;
+	oGrid.bValid = true;
+
+	return true;
+	}
+
+//***********************************************************************//
+//!Warn about a dataset whose reference point is not on a node of the
+//!tiles grid, it is named after the cell holding it with the off grid
+//!suffix
+//***********************************************************************//
+void reportOffGridDataset(const NameTemplate& oNameTemplate, const std::string& sFilePath, double dCoordX, double dCoordY)
+	{
+	GIntBig nCol, nRow;
+
+	if ( !oNameTemplate.HasGridFields() || oNameTemplate.GetGridIndex(dCoordX, dCoordY, nCol, nRow) )
+		{ return; }
+
+	countRunStats(COUNTER_OFFGRID);
+	::CPLError(CE_Warning, CPLE_AppDefined, "\"%s\" is not aligned on the tiles grid (cell " CPL_FRMT_GIB ", " CPL_FRMT_GIB ")",
+			   sFilePath.c_str(), nCol, nRow);
+	}
+
+//***********************************************************************//
+//!Check whether or not a file exists now (not from the sibling index,
+//!whose directory listings may be older than the file)
+//***********************************************************************//
+static bool fileExists(const std::string& sFilePath)
+	{
+	::VSIStatBufL psStatBuf;
+	PhaseTimer oTimer(PHASE_STAT);
+	countRunStats(COUNTER_STAT_CALLS);
+
+	return ::VSIStatExL( sFilePath.c_str(), &psStatBuf, VSI_STAT_EXISTS_FLAG) == 0;
+	}
+
+//***********************************************************************//
+//!Rename backend state : selected backend, journal and io_uring rings
+//!(Linux only)
+//***********************************************************************//
+static RenameBackendType eRenameBackend = RENAME_BACKEND_VSI;
+static CPLMutex *hRenameBackendMutex = NULL;
+static RenameJournal *poRenameJournal = NULL;
+
+#ifdef GDAL_RENAME_HAVE_RENAMEAT2
+//***********************************************************************//
+//!renameat2() of the paths themselves (one system call, counted by the
+//!caller), return 0 or the errno value
+//***********************************************************************//
+static int renameAt2(const std::string& sSourcePath, const std::string& sTargetPath, unsigned int nFlags)
+	{
+	if ( syscall(SYS_renameat2, AT_FDCWD, sSourcePath.c_str(), AT_FDCWD, sTargetPath.c_str(), nFlags) == 0 )
+		{ return 0; }
+
+	return errno;
+	}
+#endif
+
+#ifdef GDAL_RENAME_HAVE_IO_URING
+#define GDAL_RENAME_IORING_OP_RENAMEAT	35		//IORING_OP_RENAMEAT, Linux 5.11
+#define GDAL_RENAME_IORING_ENTRIES		256
+
+static int				nUringFd = -1;
+static unsigned int		*pnUringSqTail = NULL, *pnUringSqMask = NULL, *panUringSqArray = NULL;
+static unsigned int		*pnUringCqHead = NULL, *pnUringCqTail = NULL, *pnUringCqMask = NULL;
+static struct io_uring_sqe	*pasUringSqes = NULL;
+static struct io_uring_cqe	*pasUringCqes = NULL;
+static unsigned int		nUringEntries = 0;
+
+//***********************************************************************//
+//!Create the io_uring submission and completion rings
+//***********************************************************************//
+static bool initUring()
+	{
+	struct io_uring_params sParams;
+	memset(&sParams, 0, sizeof(sParams));
+
+	int nFd = (int) syscall(__NR_io_uring_setup, GDAL_RENAME_IORING_ENTRIES, &sParams);
+	if ( nFd < 0 )
+		{ return false; }
+
+	size_t nSqSize = sParams.sq_off.array + sParams.sq_entries * sizeof(unsigned int);
+	size_t nCqSize = sParams.cq_off.cqes + sParams.cq_entries * sizeof(struct io_uring_cqe);
+	bool bSingleMmap = ( sParams.features & IORING_FEAT_SINGLE_MMAP ) != 0;
+
+	if ( bSingleMmap )
+		{ nSqSize = nCqSize = std::max(nSqSize, nCqSize); }
+
+	GByte *pabySq = (GByte *) mmap(NULL, nSqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, nFd, IORING_OFF_SQ_RING);
+	GByte *pabyCq = bSingleMmap ? pabySq :
+					(GByte *) mmap(NULL, nCqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, nFd, IORING_OFF_CQ_RING);
+	void *pSqes = mmap(NULL, sParams.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+					   MAP_SHARED | MAP_POPULATE, nFd, IORING_OFF_SQES);
+
+	if ( pabySq == MAP_FAILED || pabyCq == MAP_FAILED || pSqes == MAP_FAILED )
+		{
+		close(nFd);
+		return false;
+		}
+
+	pnUringSqTail = (unsigned int *)(pabySq + sParams.sq_off.tail);
+	pnUringSqMask = (unsigned int *)(pabySq + sParams.sq_off.ring_mask);
+	panUringSqArray = (unsigned int *)(pabySq + sParams.sq_off.array);
+	pnUringCqHead = (unsigned int *)(pabyCq + sParams.cq_off.head);
+	pnUringCqTail = (unsigned int *)(pabyCq + sParams.cq_off.tail);
+	pnUringCqMask = (unsigned int *)(pabyCq + sParams.cq_off.ring_mask);
+	pasUringCqes = (struct io_uring_cqe *)(pabyCq + sParams.cq_off.cqes);
+	pasUringSqes = (struct io_uring_sqe *) pSqes;
+	nUringEntries = sParams.sq_entries;
+	nUringFd = nFd;
+
+	return true;
+	}
+
+//***********************************************************************//
+//!Reap the completions already posted, anErrors receives the result of
+//!their renames. Return the number of completions reaped
+//***********************************************************************//
+static unsigned int reapUringCompletions(unsigned int nOps, std::vector<int>& anErrors)
+	{
+	unsigned int nReaped = 0;
+	unsigned int nHead = *pnUringCqHead;
+
+	while ( nHead != __atomic_load_n(pnUringCqTail, __ATOMIC_ACQUIRE) )
+		{
+		struct io_uring_cqe *psCqe = &pasUringCqes[nHead & *pnUringCqMask];
+		if ( psCqe->user_data < nOps )
+			{ anErrors[(size_t) psCqe->user_data] = -psCqe->res; }
+
+		nHead++;
+		__atomic_store_n(pnUringCqHead, nHead, __ATOMIC_RELEASE);
+		nReaped++;
+		}
+
+	return nReaped;
+	}
+
+//***********************************************************************//
+//!Submit up to nUringEntries renames in one io_uring_enter() call. They
+//!are hard linked so the kernel runs them in order, as the synchronous
+//!renames would be. anErrors receives 0 or the errno value of each rename,
+//!-1 for the renames whose completion was not received : on a failure of
+//!io_uring_enter() the completions already posted are reaped first
+//***********************************************************************//
+static bool submitUringRenames(const std::vector<const RenameOperation*>& apoOps, std::vector<int>& anErrors)
+	{
+	unsigned int nOps = (unsigned int) apoOps.size();
+	unsigned int nTail = *pnUringSqTail;
+
+	for( unsigned int i = 0; i < nOps; i++ )
+		{
+		unsigned int nIndex = nTail & *pnUringSqMask;
+		struct io_uring_sqe *psSqe = &pasUringSqes[nIndex];
+
+		memset(psSqe, 0, sizeof(*psSqe));
+		psSqe->opcode = GDAL_RENAME_IORING_OP_RENAMEAT;
+		psSqe->fd = AT_FDCWD;
+		psSqe->addr = (GUIntBig)(size_t) apoOps[i]->sSourcePath.c_str();
+		psSqe->len = (GUInt32) AT_FDCWD;
+		psSqe->off = (GUIntBig)(size_t) apoOps[i]->sTargetPath.c_str(); //addr2
+		psSqe->rw_flags = RENAME_NOREPLACE;							 //rename_flags
+		psSqe->user_data = i;
+		if ( i + 1 < nOps )
+			{ psSqe->flags = IOSQE_IO_HARDLINK; }
+
+		panUringSqArray[nIndex] = nIndex;
+		nTail++;
+		}
+
+	__atomic_store_n(pnUringSqTail, nTail, __ATOMIC_RELEASE);
+
+	anErrors.assign(nOps, -1);
+	unsigned int nSubmitted = 0, nReaped = 0;
+
+	while ( nReaped < nOps )
+		{
+		countRunStats(COUNTER_URING_SUBMITS);
+		int nResult = (int) syscall(__NR_io_uring_enter, nUringFd, nOps - nSubmitted, nOps - nReaped, IORING_ENTER_GETEVENTS, NULL, 0);
+
+		if ( nResult < 0 && errno != EINTR )
+			{
+			nReaped += reapUringCompletions(nOps, anErrors);
+			return false;
+			}
+		if ( nResult > 0 )
+			{ nSubmitted += (unsigned int) nResult; }
+
+		nReaped += reapUringCompletions(nOps, anErrors);
+		}
+
+	return true;
+	}
+
+//***********************************************************************//
+//!Result of a rename whose completion was not received, from the files
+//!(the source gone and the target there : done)
+//***********************************************************************//
+static bool isRenameDone(const RenameOperation& oOp)
+	{
+	return !fileExists(oOp.sSourcePath) && fileExists(oOp.sTargetPath);
+	}
+#endif
+
+//***********************************************************************//
+//!Select the rename backend : "vsi" (VSIRename, portable), "renameat2"
+//!(atomic no overwrite renames, Linux), "io_uring" (renameat2 + batched
+//!submission, Linux 5.11) or "auto" (renameat2 when available)
+//***********************************************************************//
+bool setRenameBackend(const char* pszBackend)
+	{
+	if ( EQUAL(pszBackend, "vsi") )
+		{
+		eRenameBackend = RENAME_BACKEND_VSI;
+		return true;
+		}
+
+#ifdef GDAL_RENAME_HAVE_RENAMEAT2
+	if ( EQUAL(pszBackend, "auto") || EQUAL(pszBackend, "renameat2") )
+		{
+		eRenameBackend = RENAME_BACKEND_RENAMEAT2;
+		return true;
+		}
+#else
+	if ( EQUAL(pszBackend, "auto") )
+		{
+		eRenameBackend = RENAME_BACKEND_VSI;
+		return true;
+		}
+#endif
+
+#ifdef GDAL_RENAME_HAVE_IO_URING
+	if ( EQUAL(pszBackend, "io_uring") )
+		{
+		eRenameBackend = initUring() ? RENAME_BACKEND_IO_URING : RENAME_BACKEND_RENAMEAT2;
+		if ( eRenameBackend != RENAME_BACKEND_IO_URING )
+			{ ::CPLError(CE_Warning, CPLE_NotSupported, "io_uring not available, using renameat2 instead"); }
+		return true;
+		}
+#endif
+
+	return false;
+	}
+
+#ifdef GDAL_RENAME_HAVE_RENAMEAT2
+//***********************************************************************//
+//!Warn once that RENAME_NOREPLACE is not supported, the renames are then
+//!done by VSIRename after a check of the target (not atomic)
+//***********************************************************************//
+static void warnNoReplaceFallback(const std::string& sTargetPath)
+	{
+	static volatile int nWarned = 0;
+
+	if ( CPLAtomicCompareAndExchange(&nWarned, 0, 1) )
+		{
+		::CPLError(CE_Warning, CPLE_NotSupported, "No replace renames not supported for \"%s\", "
+				   "the targets are checked before the renames instead (not atomic)", sTargetPath.c_str());
+		}
+	}
+#endif
+
+//***********************************************************************//
+//!Rename a file only if the target does not exist, without journal.
+//!pnError receives the errno value of a failed rename (ie: EXDEV). When
+//!RENAME_NOREPLACE is not used (vsi backend, /vsi paths, file systems
+//!without it) the target is checked just before VSIRename
+//***********************************************************************//
+static RenameResult renameNoReplaceFile(const std::string& sSourcePath, const std::string& sTargetPath, int* pnError)
+	{
+	RenameResult nResult = RENAME_NOT_DONE;
+	PhaseTimer oTimer(PHASE_RENAME);
+
+	*pnError = 0;
+	countRunStats(COUNTER_RENAME_CALLS);
+
+#ifdef GDAL_RENAME_HAVE_RENAMEAT2
+	if ( eRenameBackend != RENAME_BACKEND_VSI && !STARTS_WITH(sSourcePath.c_str(), "/vsi") )
+		{
+		int nError = renameAt2(sSourcePath, sTargetPath, RENAME_NOREPLACE);
+
+		if ( nError == 0 )
+			{ nResult = RENAME_DONE; }
+		else if ( nError == EEXIST )
+			{ return RENAME_TARGET_EXISTS; }
+		//file system without RENAME_NOREPLACE support (ie: old NFS), use VSIRename
+		else if ( nError != EINVAL && nError != ENOSYS )
+			{
+			*pnError = nError;
+			return RENAME_FAILED;
+			}
+		else
+			{ warnNoReplaceFallback(sTargetPath); }
+		}
+#endif
+
+	if ( nResult == RENAME_NOT_DONE )
+		{
+#ifdef GDAL_RENAME_HAVE_RENAMEAT2
+		if ( eRenameBackend != RENAME_BACKEND_VSI && !STARTS_WITH(sSourcePath.c_str(), "/vsi") )
+			{ countRunStats(COUNTER_RENAME_CALLS); }
+#endif
+		if ( fileExists(sTargetPath) )
+			{ return RENAME_TARGET_EXISTS; }
+
+		errno = 0;
+		nResult = ::VSIRename( sSourcePath.c_str(), sTargetPath.c_str() ) == 0 ? RENAME_DONE : RENAME_FAILED;
+		if ( nResult == RENAME_FAILED )
+			{ *pnError = errno; }
+		}
+
+	return nResult;
+	}
+
+//***********************************************************************//
+//!Rename a file only if the target does not exist. Atomic with the
+//!renameat2 backends, with the vsi backend the caller must have checked
+//!the target does not exist. A file renamed to another file system (ie:
+//!--output-dir on another volume) is moved by a copy
+//***********************************************************************//
+RenameResult renameNoReplace(const std::string& sSourcePath, const std::string& sTargetPath)
+	{
+	int nError = 0;
+	RenameResult nResult = renameNoReplaceFile(sSourcePath, sTargetPath, &nError);
+
+	if ( nResult == RENAME_FAILED && nError == EXDEV )
+		{ nResult = moveFileAcrossDevices(sSourcePath, sTargetPath); }
+
+	if ( nResult == RENAME_DONE && poRenameJournal != NULL )
+		{ poRenameJournal->Done(sSourcePath, sTargetPath); }
+
+	return nResult;
+	}
+
+//***********************************************************************//
+//!Atomically exchange two files, return false if not supported. Not used
+//!with a journal : unlike a rename, whether an exchange was done or not
+//!can't be told from the files after a failure
+//***********************************************************************//
+bool renameExchange(const std::string& sPath1, const std::string& sPath2)
+	{
+#ifdef GDAL_RENAME_HAVE_RENAMEAT2
+	if ( eRenameBackend != RENAME_BACKEND_VSI && poRenameJournal == NULL && !STARTS_WITH(sPath1.c_str(), "/vsi") )
+		{
+		PhaseTimer oTimer(PHASE_RENAME);
+		countRunStats(COUNTER_RENAME_CALLS);
+
+		return renameAt2(sPath1, sPath2, RENAME_EXCHANGE) == 0;
+		}
+#endif
+
+	return false;
+	}
+
+//***********************************************************************//
+//!Copy a file to a new file (never written over) and sync it, with no
+//!userspace buffer when possible : a reflink (FICLONE, copy on write file
+//!systems sharing the extents), then copy_file_range() (in kernel, server
+//!side on NFS 4.2 and SMB), then sendfile(). The mode and times are kept
+//***********************************************************************//
+static bool copyFileForMove(const std::string& sSourcePath, const std::string& sCopyPath)
+	{
+	PhaseTimer oTimer(PHASE_TRANSFER);
+
+#ifdef GDAL_RENAME_HAVE_KERNEL_COPY
+	if ( !STARTS_WITH(sSourcePath.c_str(), "/vsi") && !STARTS_WITH(sCopyPath.c_str(), "/vsi") )
+		{
+		struct stat sStat;
+		int nSourceFd = open(sSourcePath.c_str(), O_RDONLY | O_CLOEXEC);
+
+		if ( nSourceFd < 0 || fstat(nSourceFd, &sStat) != 0 )
+			{
+			if ( nSourceFd >= 0 )
+				{ close(nSourceFd); }
+			return false;
+			}
+
+		int nCopyFd = open(sCopyPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, sStat.st_mode & 07777);
+		if ( nCopyFd < 0 )
+			{
+			close(nSourceFd);
+			return false;
+			}
+
+		bool bSuccess = ( ioctl(nCopyFd, FICLONE, nSourceFd) == 0 );
+		off_t nCopied = 0;
+
+		if ( bSuccess )
+			{ countRunStats(COUNTER_REFLINKS); }
+
+#ifdef SYS_copy_file_range
+		//the file offsets of both files move on, sendfile() goes on from there if it stops
+		while ( !bSuccess && nCopied < sStat.st_size )
+			{
+			ssize_t nBytes = syscall(SYS_copy_file_range, nSourceFd, NULL, nCopyFd, NULL,
+									 (size_t) std::min<off_t>(sStat.st_size - nCopied, GDAL_RENAME_COPY_CHUNK), 0);
+			if ( nBytes <= 0 )
+				{ break; }
+			nCopied += nBytes;
+			}
+#endif
+
+		while ( !bSuccess && nCopied < sStat.st_size )
+			{
+			off_t nOffset = nCopied;
+			ssize_t nBytes = sendfile(nCopyFd, nSourceFd, &nOffset, (size_t) std::min<off_t>(sStat.st_size - nCopied, GDAL_RENAME_COPY_CHUNK));
+			if ( nBytes <= 0 )
+				{ break; }
+			nCopied += nBytes;
+			}
+
+		bSuccess = bSuccess || nCopied == sStat.st_size;
+
+		if ( bSuccess )
+			{
+			struct timespec asTimes[2] = { sStat.st_atim, sStat.st_mtim };
+
+			futimens(nCopyFd, asTimes);
+			countRunStats(COUNTER_FSYNC_CALLS);
+			bSuccess = ( fsync(nCopyFd) == 0 );
+			}
+
+		bSuccess = ( close(nCopyFd) == 0 ) && bSuccess;
+		close(nSourceFd);
+
+		if ( !bSuccess )
+			{ unlink(sCopyPath.c_str()); }
+
+		return bSuccess;
+		}
+#endif
+
+	//portable copy through GDAL buffers (ie: /vsi paths, other systems)
+	::VSIStatBufL psStatBuf;
+	if ( ::VSIStatExL(sCopyPath.c_str(), &psStatBuf, VSI_STAT_EXISTS_FLAG) == 0 )
+		{ return false; }
+
+	if ( ::CPLCopyFile(sCopyPath.c_str(), sSourcePath.c_str()) != 0 )
+		{
+		::VSIUnlink(sCopyPath.c_str());
+		return false;
+		}
+
+	return true;
+	}
+
+//***********************************************************************//
+//!Sync a file, or a directory so the files created or removed there are
+//!durable
+//***********************************************************************//
+static void syncPath(const std::string& sPath)
+	{
+#ifndef _WIN32
+	int nFd = open(sPath.c_str(), O_RDONLY);
+
+	if ( nFd >= 0 )
+		{
+		countRunStats(COUNTER_FSYNC_CALLS);
+		fsync(nFd);
+		close(nFd);
+		}
+#else
+	(void) sPath;
+#endif
+	}
+
+//***********************************************************************//
+//!Temporary path of a file copied next to its target, never a dataset
+//!extension so the directory walks and watches ignore it
+//***********************************************************************//
+static std::string getTransferPath(const std::string& sTargetPath)
+	{
+	return sTargetPath + CPLSPrintf(".%d.gdal_rename_part", ::CPLGetPID());
+	}
+
+//***********************************************************************//
+//!Move a file to another file system : copied next to its target, synced,
+//!renamed to its target (never written over) and the directory synced
+//!before the source is unlinked, so a crash never loses the file
+//***********************************************************************//
+RenameResult moveFileAcrossDevices(const std::string& sSourcePath, const std::string& sTargetPath)
+	{
+	std::string sTransferPath = getTransferPath(sTargetPath);
+	int nError = 0;
+
+	if ( !copyFileForMove(sSourcePath, sTransferPath) )
+		{
+		countRunStats(COUNTER_FAILED_TRANSFER);
+		return RENAME_FAILED;
+		}
+
+	RenameResult nResult = renameNoReplaceFile(sTransferPath, sTargetPath, &nError);
+
+	if ( nResult != RENAME_DONE )
+		{
+		::VSIUnlink(sTransferPath.c_str());
+		return nResult;
+		}
+
+	syncPath(::CPLGetDirname(sTargetPath.c_str()));
+
+	if ( ::VSIUnlink(sSourcePath.c_str()) != 0 )
+		{
+		//the source is kept, not the copy
+		::VSIUnlink(sTargetPath.c_str());
+		countRunStats(COUNTER_FAILED_TRANSFER);
+		return RENAME_FAILED;
+		}
+
+	countRunStats(COUNTER_TRANSFERS);
+	return RENAME_DONE;
+	}
+
+//***********************************************************************//
+//!Rename a list of files with no overwrite in batches (io_uring backend
+//!only). Only the renames whose target is not in the sibling index (or
+//!is moved by a previous rename of the list) are submitted, the nResult
+//!of the others is left to RENAME_NOT_DONE. The index only selects the
+//!submitted renames : they are done with RENAME_NOREPLACE, the failed
+//!ones (target created since, EINVAL) are done again synchronously
+//***********************************************************************//
+void renameNoReplaceBatch(std::vector<RenameOperation>& aoOps, SiblingIndex& oSiblingIndex)
+	{
+	for( size_t i = 0; i < aoOps.size(); i++ )
+		{ aoOps[i].nResult = RENAME_NOT_DONE; }
+
+#ifdef GDAL_RENAME_HAVE_IO_URING
+	if ( eRenameBackend != RENAME_BACKEND_IO_URING )
+		{ return; }
+
+	CPLMutexHolderD(&hRenameBackendMutex);
+
+	std::vector<RenameOperation*> apoBatch;
+	std::vector<const RenameOperation*> apoSubmitted;
+	std::vector<int> anErrors;
+	std::unordered_set<std::string> oMovedSources; //targets freed by a previous rename of the batch
+
+	for( size_t i = 0; i < aoOps.size(); i++ )
+		{
+		if ( aoOps[i].sSourcePath != aoOps[i].sTargetPath && !STARTS_WITH(aoOps[i].sSourcePath.c_str(), "/vsi") &&
+			 ( oMovedSources.count(aoOps[i].sTargetPath) > 0 || !oSiblingIndex.Exists(aoOps[i].sTargetPath) ) )
+			{
+			apoBatch.push_back(&aoOps[i]);
+			oMovedSources.insert(aoOps[i].sSourcePath);
+			}
+		}
+
+	for( size_t iStart = 0; iStart < apoBatch.size(); iStart += nUringEntries )
+		{
+		size_t iEnd = std::min(apoBatch.size(), iStart + nUringEntries);
+		apoSubmitted.assign(apoBatch.begin() + iStart, apoBatch.begin() + iEnd);
+		bool bSubmitted = false;
+			{
+			PhaseTimer oTimer(PHASE_RENAME_BATCH);
+			bSubmitted = submitUringRenames(apoSubmitted, anErrors);
+			}
+
+		//the ring may hold renames not submitted yet : not used anymore, the
+		//renames of the batch not known as done are done synchronously
+		if ( !bSubmitted )
+			{
+			eRenameBackend = RENAME_BACKEND_RENAMEAT2;
+			::CPLError(CE_Warning, CPLE_AppDefined, "io_uring submission failed (%s), using renameat2 instead", strerror(errno));
+			}
+
+		for( size_t i = 0; i < apoSubmitted.size(); i++ )
+			{
+			//target created by someone else or unsupported : done again synchronously
+			if ( anErrors[i] == 0 || ( anErrors[i] == -1 && isRenameDone(*apoSubmitted[i]) ) )
+				{
+				apoBatch[iStart + i]->nResult = RENAME_DONE;
+				if ( poRenameJournal != NULL )
+					{ poRenameJournal->Done(apoBatch[iStart + i]->sSourcePath, apoBatch[iStart + i]->sTargetPath); }
+				}
+			}
+
+		if ( !bSubmitted )
+			{ return; }
+		}
+#else
+	(void) oSiblingIndex;
+#endif
+	}
+
+//***********************************************************************//
+//!Escape the paths written in the journal (tab, new line and backslash)
+//***********************************************************************//
+static std::string escapeJournalPath(const std::string& sPath)
+	{
+	std::string sEscaped;
+
+	for( size_t i = 0; i < sPath.size(); i++ )
+		{
+		if ( sPath[i] == '\\' )
+			{ sEscaped += "\\\\"; }
+		else if ( sPath[i] == '\t' )
+			{ sEscaped += "\\t"; }
+		else if ( sPath[i] == '\n' )
+			{ sEscaped += "\\n"; }
+		else
+			{ sEscaped += sPath[i]; }
+		}
+
+	return sEscaped;
+	}
+
+//***********************************************************************//
+//!Unescape a path read from the journal
+//***********************************************************************//
+static std::string unescapeJournalPath(const std::string& sEscaped)
+	{
+	std::string sPath;
+
+	for( size_t i = 0; i < sEscaped.size(); i++ )
+		{
+		if ( sEscaped[i] == '\\' && i + 1 < sEscaped.size() )
+			{
+			i++;
+			sPath += ( sEscaped[i] == 't' ) ? '\t' : ( sEscaped[i] == 'n' ) ? '\n' : sEscaped[i];
+			}
+		else
+			{ sPath += sEscaped[i]; }
+		}
+
+	return sPath;
+	}
+
+//***********************************************************************//
+//!Rename journal, the records are buffered and made durable by Sync()
+//***********************************************************************//
+RenameJournal::RenameJournal()
+	{
+	fp = NULL;
+	hMutex = NULL;
+	nUnsynced = 0;
+	}
+
+RenameJournal::~RenameJournal()
+	{
+	if ( fp != NULL )
+		{
+		Sync();
+		fclose(fp);
+		}
+
+	if ( hMutex != NULL )
+		{ ::CPLDestroyMutex(hMutex); }
+	}
+
+//***********************************************************************//
+//!Create a new journal, or open an existing one to append records to it
+//!(the journal of a resumed run). The current directory is recorded, the
+//!paths of the journal are relative to it
+//***********************************************************************//
+bool RenameJournal::Open(const char* pszPath, bool bAppend)
+	{
+	fp = fopen(pszPath, bAppend ? "ab" : "wb");
+
+	if ( fp == NULL )
+		{
+		::CPLError(CE_Failure, CPLE_OpenFailed, "Unable to open the journal \"%s\"", pszPath);
+		return false;
+		}
+
+	if ( !bAppend )
+		{
+		char *pszCurrentDir = ::CPLGetCurrentDir();
+		fprintf(fp, "# gdal_rename journal\nC\t%s\n", escapeJournalPath(pszCurrentDir != NULL ? pszCurrentDir : "").c_str());
+		::CPLFree(pszCurrentDir);
+		nUnsynced++;
+		}
+
+	return Sync();
+	}
+
+//***********************************************************************//
+//!Append a record to the journal
+//***********************************************************************//
+void RenameJournal::Write(char chType, const std::string& sSourcePath, const std::string& sTargetPath)
+	{
+	CPLMutexHolderD(&hMutex);
+
+	fprintf(fp, "%c\t%s\t%s\n", chType, escapeJournalPath(sSourcePath).c_str(), escapeJournalPath(sTargetPath).c_str());
+	nUnsynced++;
+
+	if ( chType != 'P' )
+		{
+		oTouchedDirs.insert(::CPLGetDirname(sSourcePath.c_str()));
+		oTouchedDirs.insert(::CPLGetDirname(sTargetPath.c_str()));
+		}
+	}
+
+//***********************************************************************//
+//!Record a rename about to be done, it must be made durable with Sync()
+//!before the rename
+//***********************************************************************//
+void RenameJournal::Planned(const std::string& sSourcePath, const std::string& sTargetPath)
+	{ Write('P', sSourcePath, sTargetPath); }
+
+//***********************************************************************//
+//!Record a rename done. The records are synced in groups, a sync is
+//!forced every 65536 records so a huge batch is not left unsynced
+//***********************************************************************//
+void RenameJournal::Done(const std::string& sSourcePath, const std::string& sTargetPath)
+	{
+	Write('D', sSourcePath, sTargetPath);
+
+	if ( nUnsynced >= 65536 )
+		{ Sync(); }
+	}
+
+//***********************************************************************//
+//!Record a rename undone by a rollback
+//***********************************************************************//
+void RenameJournal::Undone(const std::string& sSourcePath, const std::string& sTargetPath)
+	{ Write('U', sSourcePath, sTargetPath); }
+
+//***********************************************************************//
+//!Make the renames and the records written so far durable : the
+//!directories of the renames are synced, then a sync point (S) is
+//!written and the journal is synced. The records before the last sync
+//!point can be trusted, the state of the renames after it is checked on
+//!the files when the journal is read
+//***********************************************************************//
+bool RenameJournal::Sync()
+	{
+	CPLMutexHolderD(&hMutex);
+	bool bSuccess = true;
+
+	if ( nUnsynced == 0 )
+		{ return true; }
+
+	PhaseTimer oTimer(PHASE_JOURNAL_SYNC);
+	countRunStats(COUNTER_FSYNC_CALLS, (int) oTouchedDirs.size() + 1);
+
+#ifndef _WIN32
+	std::unordered_set<std::string>::iterator it = oTouchedDirs.begin();
+
+	while ( it != oTouchedDirs.end() )
+		{
+		int nFd = open(it->c_str(), O_RDONLY);
+		if ( nFd >= 0 )
+			{
+			fsync(nFd);
+			close(nFd);
+			}
+		++it;
+		}
+#endif
+
+	oTouchedDirs.clear();
+	nUnsynced = 0;
+
+	fputs("S\n", fp);
+	if ( fflush(fp) != 0 )
+		{ bSuccess = false; }
+#ifdef _WIN32
+	else if ( _commit(_fileno(fp)) != 0 )
+		{ bSuccess = false; }
+#else
+	else if ( fsync(fileno(fp)) != 0 )
+		{ bSuccess = false; }
+#endif
+
+	if ( !bSuccess )
+		{ ::CPLError(CE_Failure, CPLE_FileIO, "Unable to sync the rename journal"); }
+
+	return bSuccess;
+	}
+
+//***********************************************************************//
+//!Read a journal and work out which planned renames are done. The done
+//!records before the last sync point are trusted, the other renames are
+//!checked against the files from the last one to the first (a rename is
+//!done if its source is missing and its target exists, once the later
+//!renames are undone)
+//***********************************************************************//
+bool RenameJournal::Read(const char* pszPath, std::vector<JournalRename>& aoRenames)
+	{
+	VSILFILE *fpJournal = ::VSIFOpenL(pszPath, "rb");
+
+	if ( fpJournal == NULL )
+		{
+		::CPLError(CE_Failure, CPLE_OpenFailed, "Unable to open the journal \"%s\"", pszPath);
+		return false;
+		}
+
+	std::map< std::pair<std::string, std::string>, std::deque<size_t> > oPending, oDone;
+	std::vector<bool> abTrusted;
+	std::vector<size_t> anUnsyncedDone;
+	bool bSuccess = true;
+	const char *pszLine;
+
+	aoRenames.clear();
+
+	while ( (pszLine = ::CPLReadLineL(fpJournal)) != NULL )
+		{
+		char **papszFields = ::CSLTokenizeString2(pszLine, "\t", CSLT_ALLOWEMPTYTOKENS);
+		int nFields = ::CSLCount(papszFields);
+
+		if ( nFields == 2 && EQUAL(papszFields[0], "C") )
+			{
+			char *pszCurrentDir = ::CPLGetCurrentDir();
+			if ( pszCurrentDir == NULL || unescapeJournalPath(papszFields[1]) != pszCurrentDir )
+				{
+				::CPLError(CE_Failure, CPLE_AppDefined, "The journal \"%s\" must be used from \"%s\"", pszPath, papszFields[1]);
+				bSuccess = false;
+				}
+			::CPLFree(pszCurrentDir);
+			}
+		else if ( nFields == 1 && EQUAL(papszFields[0], "S") )
+			{
+			for( size_t i = 0; i < anUnsyncedDone.size(); i++ )
+				{ abTrusted[anUnsyncedDone[i]] = true; }
+			anUnsyncedDone.clear();
+			}
+		else if ( nFields == 3 )
+			{
+			std::pair<std::string, std::string> oKey(unescapeJournalPath(papszFields[1]), unescapeJournalPath(papszFields[2]));
+
+			if ( EQUAL(papszFields[0], "P") )
+				{
+				JournalRename oRename;
+				oRename.sSourcePath = oKey.first;
+				oRename.sTargetPath = oKey.second;
+				oRename.bDone = false;
+
+				oPending[oKey].push_back(aoRenames.size());
+				aoRenames.push_back(oRename);
+				abTrusted.push_back(false);
+				}
+			else if ( EQUAL(papszFields[0], "D") && !oPending[oKey].empty() )
+				{
+				size_t nRename = oPending[oKey].front();
+				oPending[oKey].pop_front();
+				oDone[oKey].push_back(nRename);
+
+				aoRenames[nRename].bDone = true;
+				anUnsyncedDone.push_back(nRename);
+				}
+			else if ( EQUAL(papszFields[0], "U") && !oDone[oKey].empty() )
+				{
+				size_t nRename = oDone[oKey].back();
+				oDone[oKey].pop_back();
+
+				aoRenames[nRename].bDone = false;
+				anUnsyncedDone.push_back(nRename);
+				}
+			}
+
+		::CSLDestroy(papszFields);
+		}
+
+	::VSIFCloseL(fpJournal);
+
+	//files state once the renames after the current one are undone
+	std::unordered_map<std::string, bool> oExists;
+	::VSIStatBufL psStatBuf;
+
+	for( size_t i = aoRenames.size(); i-- > 0; )
+		{
+		JournalRename& oRename = aoRenames[i];
+		const std::string* apsPaths[2] = { &oRename.sSourcePath, &oRename.sTargetPath };
+
+		if ( !abTrusted[i] )
+			{
+			for( int j = 0; j < 2; j++ )
+				{
+				if ( oExists.find(*apsPaths[j]) == oExists.end() )
+					{ oExists[*apsPaths[j]] = ::VSIStatExL( apsPaths[j]->c_str(), &psStatBuf, VSI_STAT_EXISTS_FLAG) == 0; }
+				}
+
+			oRename.bDone = !oExists[oRename.sSourcePath] && oExists[oRename.sTargetPath];
+			}
+
+		if ( oRename.bDone )
+			{
+			oExists[oRename.sSourcePath] = true;
+			oExists[oRename.sTargetPath] = false;
+			}
+		}
+
+	return bSuccess;
+	}
+
+//***********************************************************************//
+//!Select the journal recording the renames (NULL for none)
+//***********************************************************************//
+void setRenameJournal(RenameJournal* poJournal)
+	{ poRenameJournal = poJournal; }
+
+//***********************************************************************//
+//!Resume an interrupted run from its journal : the renames planned but
+//!not done whose source still exists (ie: the sibling files of a dataset
+//!renamed just before the failure) are replayed in order, the paths of
+//!the renamed files are returned so they are neither opened nor renamed
+//!again by the resumed run
+//***********************************************************************//
+bool resumeJournal(const char* pszPath, std::unordered_set<std::string>& oDonePaths)
+	{
+	std::vector<JournalRename> aoRenames;
+	int nReplayed = 0, nDone = 0;
+
+	if ( !RenameJournal::Read(pszPath, aoRenames) )
+		{ return false; }
+
+	for( size_t i = 0; i < aoRenames.size(); i++ )
+		{
+		const JournalRename& oRename = aoRenames[i];
+		::VSIStatBufL psStatBuf;
+
+		if ( oRename.bDone )
+			{ nDone++; }
+		else if ( ::VSIStatExL( oRename.sSourcePath.c_str(), &psStatBuf, VSI_STAT_EXISTS_FLAG) == 0 &&
+				  ::VSIStatExL( oRename.sTargetPath.c_str(), &psStatBuf, VSI_STAT_EXISTS_FLAG) != 0 )
+			{
+			if ( renameNoReplace(oRename.sSourcePath, oRename.sTargetPath) != RENAME_DONE )
+				{
+				::CPLError(CE_Failure, CPLE_FileIO, "Unable to rename \"%s\" to \"%s\"", oRename.sSourcePath.c_str(), oRename.sTargetPath.c_str());
+				continue;
+				}
+			nReplayed++;
+			}
+		else
+			{ continue; }
+
+		oDonePaths.insert(oRename.sSourcePath);
+		oDonePaths.insert(oRename.sTargetPath);
+		}
+
+	if ( poRenameJournal != NULL )
+		{ poRenameJournal->Sync(); }
+
+	fprintf(stderr, "Resuming \"%s\" : %d rename(s) already done, %d replayed\n", pszPath, nDone, nReplayed);
+
+	return true;
+	}
+
+//***********************************************************************//
+//!Undo the renames done by a run, from the last one to the first
+//***********************************************************************//
+bool rollbackJournal(const char* pszPath)
+	{
+	std::vector<JournalRename> aoRenames;
+	RenameJournal oJournal;
+	int nUndone = 0, nFailures = 0;
+
+	if ( !RenameJournal::Read(pszPath, aoRenames) || !oJournal.Open(pszPath, true) )
+		{ return false; }
+
+	for( size_t i = aoRenames.size(); i-- > 0; )
+		{
+		const JournalRename& oRename = aoRenames[i];
+
+		if ( !oRename.bDone )
+			{ continue; }
+
+		if ( renameNoReplace(oRename.sTargetPath, oRename.sSourcePath) == RENAME_DONE )
+			{
+			oJournal.Undone(oRename.sSourcePath, oRename.sTargetPath);
+			nUndone++;
+			}
+		else
+			{
+			::CPLError(CE_Failure, CPLE_FileIO, "Unable to rename \"%s\" back to \"%s\"", oRename.sTargetPath.c_str(), oRename.sSourcePath.c_str());
+			nFailures++;
+			}
+		}
+
+	fprintf(stderr, "Rollback of \"%s\" : %d rename(s) undone, %d failure(s)\n", pszPath, nUndone, nFailures);
+
+	return oJournal.Sync() && nFailures == 0;
+	}
+
+//***********************************************************************//
+//!Backup name of an existing file replaced by a renamed one (_OldOne)
+//***********************************************************************//
+static std::string getBackupPath(const std::string& sPath)
+	{
+	return sPath.substr(0, sPath.length()-4) + "_OldOne" + sPath.substr(sPath.length()-4, 4);
+	}
+
+//***********************************************************************//
+//!Call VSIL rename function and rename old file if already existing
+//***********************************************************************//
+bool renameFileNoOverWrite (std::string sourcePath, std::string newPath, SiblingIndex& oSiblingIndex)
+	{
+	RenameResult renameSuccess = RENAME_TARGET_EXISTS, renameBackupSuccess = RENAME_FAILED;
+
+	//already named this way (ie: dataset renamed by a previous run)
+	if ( sourcePath == newPath )
+		{ return true; }
+
+	//the target existence is checked by the rename itself (atomically with
+	//the renameat2 backends, by a stat just before it otherwise)
+	renameSuccess = renameNoReplace(sourcePath, newPath);
+
+    if ( renameSuccess == RENAME_TARGET_EXISTS )
+        {
+		std::string sNewFilePathTmp = getBackupPath(newPath);
+
+        if ( fileExists(sNewFilePathTmp) )
+			{
+			countRunStats(COUNTER_FAILED_TARGET_EXISTS);
+			::CPLError(CE_Failure, CPLE_FileIO, "Unable to rename \"%s\" to \"%s\" : both the new name and its backup name already exist",
+					   sourcePath.c_str(), newPath.c_str());
+			return false;
+            }
+        //swap the files so the new name never disappears, then move the old one to the backup name
+        else if ( renameExchange(sourcePath, newPath) )
+            {
+            renameBackupSuccess = renameNoReplace(sourcePath, sNewFilePathTmp);
+            if ( renameBackupSuccess == RENAME_DONE )
+                {
+                countRunStats(COUNTER_BACKUPS);
+                oSiblingIndex.Renamed(newPath, sNewFilePathTmp);
+                renameSuccess = RENAME_DONE;
+                }
+            else
+                {
+                countRunStats(COUNTER_FAILED_BACKUP);
+                renameExchange(sourcePath, newPath);
+                ::CPLError(CE_Failure, CPLE_FileIO, "Unable to back up \"%s\" to \"%s\", \"%s\" not renamed",
+                           newPath.c_str(), sNewFilePathTmp.c_str(), sourcePath.c_str());
+                return false;
+                }
+            }
+        else
+            {
+            if ( poRenameJournal != NULL )
+                {
+                poRenameJournal->Planned(newPath, sNewFilePathTmp);
+                poRenameJournal->Planned(sourcePath, newPath);
+                poRenameJournal->Sync();
+                }
+
+            //backuping the file already existing with the new naming convention
+            renameBackupSuccess = renameNoReplace( newPath, sNewFilePathTmp );
+            if ( renameBackupSuccess == RENAME_DONE )
+                {
+                countRunStats(COUNTER_BACKUPS);
+                oSiblingIndex.Renamed(newPath, sNewFilePathTmp);
+                //do the inital rename if success
+                renameSuccess = renameNoReplace( sourcePath, newPath );
+                }
+            else
+                {
+                countRunStats(COUNTER_FAILED_BACKUP);
+                ::CPLError(CE_Failure, CPLE_FileIO, "Unable to back up \"%s\" to \"%s\", \"%s\" not renamed",
+                           newPath.c_str(), sNewFilePathTmp.c_str(), sourcePath.c_str());
+                return false;
+                }
+            }
+        }
+
+	if ( renameSuccess == RENAME_DONE )
+		{
+		oSiblingIndex.Renamed(sourcePath, newPath);
+		return true;
+		}
+    else
+        {
+        countRunStats(COUNTER_FAILED_RENAME);
+        ::CPLError(CE_Failure, CPLE_FileIO, "Unable to rename \"%s\" to \"%s\"", sourcePath.c_str(), newPath.c_str());
+        }
+
+	return false;
+	}
+
+//***********************************************************************//
+//!Get world file extension of a GDALDataset
+//***********************************************************************//
+std::string getWorldFileExt (std::string inputFile)
+	{
+	std::vector<std::string> siblingFilesExt;
+
+	std::string inputExt = ::CPLGetExtension(inputFile.c_str());
+
+	std::string wfExt = inputExt.substr(0,1) + inputExt.substr(2,1) + 'w';
+
+	return wfExt;
+	}
+
+
+//***********************************************************************//
+//!Get an array of sibling files extensions of a dataset (ie: tfw, prj
+//!for a tif file). Need to be populated for other datasets !!!
+//***********************************************************************//
+std::vector<std::string> getSiblingFilesExt (std::string inputFile)
+	{
+	std::vector<std::string> siblingFilesExt;
+	std::string inputExt = ::CPLGetExtension(inputFile.c_str());
+
+	siblingFilesExt.push_back(getWorldFileExt(inputFile));
+
+	if ( EQUAL(inputExt.c_str(), "tif"))
+		{ siblingFilesExt.push_back("prj"); }
+
+	if ( EQUAL(inputExt.c_str(), "ecw"))
+		{ siblingFilesExt.push_back("ers"); }
+
+	if ( EQUAL(inputExt.c_str(), "img"))
+		{
+		siblingFilesExt.push_back("led");
+		siblingFilesExt.push_back("nul");
+		siblingFilesExt.push_back("trl");
+		siblingFilesExt.push_back("vol");
+		}
+
+	if ( EQUAL(inputExt.c_str(), "jp2") || EQUAL(inputExt.c_str(), "j2k"))
+		{ siblingFilesExt.push_back("prj"); }
+
+	return siblingFilesExt;
+	}
+
+
+
+//***********************************************************************//
+//!Read an unsigned integer of nBytes stored with the given byte order
+//***********************************************************************//
+static GUIntBig readUIntFromBuffer(const GByte *pabyData, int nBytes, bool bBigEndian)
+	{
+	GUIntBig nValue = 0;
+
+	for( int i = 0; i < nBytes; i++ )
+		{
+		int iByte = bBigEndian ? i : nBytes - 1 - i;
+		nValue = (nValue << 8) | pabyData[iByte];
+		}
+
+	return nValue;
+	}
+
+//***********************************************************************//
+//!Read the values of a TIFF tag (SHORT, LONG, LONG8 or DOUBLE types) from
+//!its IFD entry, seeking to the out of line data if needed
+//***********************************************************************//
+static bool readTiffTagValues(VSILFILE *fp, const GByte *pabyEntry, bool bBigEndian, bool bBigTiff, std::vector<double>& adfValues)
+	{
+	int nType = (int) readUIntFromBuffer(pabyEntry + 2, 2, bBigEndian);
+	GUIntBig nCount = readUIntFromBuffer(pabyEntry + 4, bBigTiff ? 8 : 4, bBigEndian);
+	const GByte *pabyValue = pabyEntry + (bBigTiff ? 12 : 8);
+	int nInlineSize = bBigTiff ? 8 : 4;
+	int nTypeSize = 0;
+
+	switch ( nType )
+		{
+		case 3  : nTypeSize = 2; break; //SHORT
+		case 4  : nTypeSize = 4; break; //LONG
+		case 12 : nTypeSize = 8; break; //DOUBLE
+		case 16 : nTypeSize = 8; break; //LONG8
+		default : return false;
+		}
+
+	//ModelTransformation is the largest tag we need (16 doubles) but keep
+	//some room for tiepoints lists
+	if ( nCount == 0 || nCount > 1024 )
+		{ return false; }
+
+	std::vector<GByte> abyData( (size_t)(nCount * nTypeSize) );
+
+	if ( abyData.size() <= (size_t) nInlineSize )
+		{ memcpy(&abyData[0], pabyValue, abyData.size()); }
+	else
+		{
+		vsi_l_offset nOffset = readUIntFromBuffer(pabyValue, nInlineSize, bBigEndian);
+		if ( ::VSIFSeekL(fp, nOffset, SEEK_SET) != 0 ||
+			 ::VSIFReadL(&abyData[0], 1, abyData.size(), fp) != abyData.size() )
+			{ return false; }
+		}
+
+	adfValues.resize( (size_t) nCount );
+	for( size_t i = 0; i < adfValues.size(); i++ )
+		{
+		GUIntBig nValue = readUIntFromBuffer(&abyData[i * nTypeSize], nTypeSize, bBigEndian);
+
+		if ( nType == 12 )
+			{ memcpy(&adfValues[i], &nValue, sizeof(double)); }
+		else
+			{ adfValues[i] = (double) nValue; }
+		}
+
+	return true;
+	}
+
+//***********************************************************************//
+//!Read the raster size and the GeoTIFF georeferencing tags (tiepoint +
+//!pixel scale or model transformation) from the first IFD of a TIFF file.
+//!bHasGeoTransform is false if the file has no usable internal georef.
+//!nEPSG is the projected or geographic CS code of the GeoKeys, 0 without
+//!CS key and 32767 (user defined) if the SRS is not an EPSG code
+//***********************************************************************//
+bool readTiffGeoRef(const char* pszFilePath, DatasetGeoRef& oGeoRef, bool& bHasGeoTransform, int& nEPSG)
+	{
+	bHasGeoTransform = false;
+	nEPSG = 0;
+
+	VSILFILE *fp = ::VSIFOpenL(pszFilePath, "rb");
+	countRunStats(COUNTER_HEADER_OPENS);
+	if ( fp == NULL )
+		{ return false; }
+
+	GByte abyHeader[16];
+	if ( ::VSIFReadL(abyHeader, 1, 16, fp) != 16 ||
+		 !( (abyHeader[0] == 'I' && abyHeader[1] == 'I') || (abyHeader[0] == 'M' && abyHeader[1] == 'M') ) )
+		{
+		::VSIFCloseL(fp);
+		return false;
+		}
+
+	bool bBigEndian = ( abyHeader[0] == 'M' );
+	int nVersion = (int) readUIntFromBuffer(abyHeader + 2, 2, bBigEndian);
+	bool bBigTiff = ( nVersion == 43 );
+
+	if ( nVersion != 42 && nVersion != 43 )
+		{
+		::VSIFCloseL(fp);
+		return false;
+		}
+
+	vsi_l_offset nIFDOffset = bBigTiff ? readUIntFromBuffer(abyHeader + 8, 8, bBigEndian)
+									   : readUIntFromBuffer(abyHeader + 4, 4, bBigEndian);
+	int nCountSize = bBigTiff ? 8 : 2;
+	int nEntrySize = bBigTiff ? 20 : 12;
+	GByte abyCount[8];
+
+	if ( ::VSIFSeekL(fp, nIFDOffset, SEEK_SET) != 0 ||
+		 ::VSIFReadL(abyCount, 1, nCountSize, fp) != (size_t) nCountSize )
+		{
+		::VSIFCloseL(fp);
+		return false;
+		}
+
+	GUIntBig nEntries = readUIntFromBuffer(abyCount, nCountSize, bBigEndian);
+	if ( nEntries == 0 || nEntries > 4096 )
+		{
+		::VSIFCloseL(fp);
+		return false;
+		}
+
+	std::vector<GByte> abyIFD( (size_t)(nEntries * nEntrySize) );
+	if ( ::VSIFReadL(&abyIFD[0], 1, abyIFD.size(), fp) != abyIFD.size() )
+		{
+		::VSIFCloseL(fp);
+		return false;
+		}
+
+	std::vector<double> adfWidth, adfHeight, adfScale, adfTiePoints, adfTransform, adfGeoKeys;
+
+	for( GUIntBig i = 0; i < nEntries; i++ )
+		{
+		const GByte *pabyEntry = &abyIFD[ (size_t)(i * nEntrySize) ];
+
+		switch ( readUIntFromBuffer(pabyEntry, 2, bBigEndian) )
+			{
+			case 256   : readTiffTagValues(fp, pabyEntry, bBigEndian, bBigTiff, adfWidth); break;		//ImageWidth
+			case 257   : readTiffTagValues(fp, pabyEntry, bBigEndian, bBigTiff, adfHeight); break;		//ImageLength
+			case 33550 : readTiffTagValues(fp, pabyEntry, bBigEndian, bBigTiff, adfScale); break;		//ModelPixelScale
+			case 33922 : readTiffTagValues(fp, pabyEntry, bBigEndian, bBigTiff, adfTiePoints); break;	//ModelTiepoint
+			case 34264 : readTiffTagValues(fp, pabyEntry, bBigEndian, bBigTiff, adfTransform); break;	//ModelTransformation
+			case 34735 : readTiffTagValues(fp, pabyEntry, bBigEndian, bBigTiff, adfGeoKeys); break;		//GeoKeyDirectory
+			default	   : break;
+			}
+		}
+
+	::VSIFCloseL(fp);
+
+	if ( adfWidth.size() != 1 || adfHeight.size() != 1 )
+		{ return false; }
+
+	oGeoRef.nRasterXSize = (int) adfWidth[0];
+	oGeoRef.nRasterYSize = (int) adfHeight[0];
+
+	double *adfGeoTransform = oGeoRef.adfGeoTransform;
+
+	if ( adfTransform.size() == 16 )
+		{
+		adfGeoTransform[0] = adfTransform[3];
+		adfGeoTransform[1] = adfTransform[0];
+		adfGeoTransform[2] = adfTransform[1];
+		adfGeoTransform[3] = adfTransform[7];
+		adfGeoTransform[4] = adfTransform[4];
+		adfGeoTransform[5] = adfTransform[5];
+		bHasGeoTransform = true;
+		}
+	//several tiepoints are GCPs, GDAL does not report a geotransform for them
+	else if ( adfTiePoints.size() == 6 && adfScale.size() >= 2 )
+		{
+		adfGeoTransform[1] = adfScale[0];
+		adfGeoTransform[2] = 0.0;
+		adfGeoTransform[4] = 0.0;
+		adfGeoTransform[5] = -adfScale[1];
+		adfGeoTransform[0] = adfTiePoints[3] - adfTiePoints[0] * adfGeoTransform[1];
+		adfGeoTransform[3] = adfTiePoints[4] - adfTiePoints[1] * adfGeoTransform[5];
+		bHasGeoTransform = true;
+		}
+	else if ( !adfTiePoints.empty() || !adfTransform.empty() )
+		{ return false; }
+
+	//GTRasterTypeGeoKey == RasterPixelIsPoint, shifted by half a pixel as GDAL does
+	if ( bHasGeoTransform && !::CPLTestBool(::CPLGetConfigOption("GTIFF_POINT_GEO_IGNORE", "FALSE")) )
+		{
+		for( size_t i = 4; i + 3 < adfGeoKeys.size(); i += 4 )
+			{
+			if ( adfGeoKeys[i] == 1025 && adfGeoKeys[i+1] == 0 && adfGeoKeys[i+3] == 2 )
+				{
+				adfGeoTransform[0] -= adfGeoTransform[1] * 0.5 + adfGeoTransform[2] * 0.5;
+				adfGeoTransform[3] -= adfGeoTransform[4] * 0.5 + adfGeoTransform[5] * 0.5;
+				}
+			}
+		}
+
+	//ProjectedCSTypeGeoKey, else GeographicTypeGeoKey, stored in the key itself
+	int nGeographicEPSG = 0;
+
+	for( size_t i = 4; i + 3 < adfGeoKeys.size(); i += 4 )
+		{
+		int nKey = (int) adfGeoKeys[i];
+
+		if ( nKey != 3072 && nKey != 2048 )
+			{ continue; }
+
+		int nCode = adfGeoKeys[i+1] == 0 ? (int) adfGeoKeys[i+3] : 32767;
+
+		if ( nKey == 3072 )
+			{ nEPSG = nCode; }
+		else
+			{ nGeographicEPSG = nCode; }
+		}
+
+	if ( nEPSG == 0 )
+		{ nEPSG = nGeographicEPSG; }
+
+	return true;
+	}
+
+//***********************************************************************//
+//!Read the raster size of a JPEG2000 file (JP2 boxes or raw codestream).
+//!Return false if the file holds GeoJP2 or GMLJP2 boxes, as only GDAL is
+//!able to read this internal georeferencing
+//***********************************************************************//
+bool readJP2Size(const char* pszFilePath, DatasetGeoRef& oGeoRef)
+	{
+	VSILFILE *fp = ::VSIFOpenL(pszFilePath, "rb");
+	countRunStats(COUNTER_HEADER_OPENS);
+	if ( fp == NULL )
+		{ return false; }
+
+	bool Success = false;
+	GByte abyHeader[16];
+
+	if ( ::VSIFReadL(abyHeader, 1, 16, fp) != 16 )
+		{
+		::VSIFCloseL(fp);
+		return false;
+		}
+
+	//raw codestream : SOC + SIZ markers, no internal georeferencing
+	if ( abyHeader[0] == 0xFF && abyHeader[1] == 0x4F && abyHeader[2] == 0xFF && abyHeader[3] == 0x51 )
+		{
+		GByte abySiz[16];
+		if ( ::VSIFSeekL(fp, 8, SEEK_SET) == 0 && ::VSIFReadL(abySiz, 1, 16, fp) == 16 )
+			{
+			oGeoRef.nRasterXSize = (int)( readUIntFromBuffer(abySiz, 4, true) - readUIntFromBuffer(abySiz + 8, 4, true) );
+			oGeoRef.nRasterYSize = (int)( readUIntFromBuffer(abySiz + 4, 4, true) - readUIntFromBuffer(abySiz + 12, 4, true) );
+			Success = true;
+			}
+		::VSIFCloseL(fp);
+		return Success;
+		}
+
+	//JP2 boxes : only the top level boxes headers are read (and the ihdr box)
+	vsi_l_offset nOffset = 0;
+	bool bInternalGeoRef = false;
+
+	for( int iBox = 0; iBox < 64; iBox++ )
+		{
+		GByte abyBox[16];
+		if ( ::VSIFSeekL(fp, nOffset, SEEK_SET) != 0 || ::VSIFReadL(abyBox, 1, 8, fp) != 8 )
+			{ break; }
+
+		GUIntBig nLength = readUIntFromBuffer(abyBox, 4, true);
+		int nHeaderSize = 8;
+
+		if ( nLength == 1 )
+			{
+			if ( ::VSIFReadL(abyBox + 8, 1, 8, fp) != 8 )
+				{ break; }
+			nLength = readUIntFromBuffer(abyBox + 8, 8, true);
+			nHeaderSize = 16;
+			}
+
+		if ( memcmp(abyBox + 4, "uuid", 4) == 0 || memcmp(abyBox + 4, "asoc", 4) == 0 )
+			{ bInternalGeoRef = true; }
+
+		//jp2h superbox, its first child is the image header box
+		if ( memcmp(abyBox + 4, "jp2h", 4) == 0 )
+			{
+			GByte abyIhdr[16];
+			if ( ::VSIFReadL(abyIhdr, 1, 16, fp) == 16 && memcmp(abyIhdr + 4, "ihdr", 4) == 0 )
+				{
+				oGeoRef.nRasterYSize = (int) readUIntFromBuffer(abyIhdr + 8, 4, true);
+				oGeoRef.nRasterXSize = (int) readUIntFromBuffer(abyIhdr + 12, 4, true);
+				Success = true;
+				}
+			}
+
+		//a zero length box extends up to the end of the file
+		if ( nLength == 0 || nLength < (GUIntBig) nHeaderSize )
+			{ break; }
+
+		nOffset += nLength;
+		}
+
+	::VSIFCloseL(fp);
+
+	return Success && !bInternalGeoRef;
+	}
+
+//***********************************************************************//
+//!Read a world file (6 lines : pixel sizes, rotations and center of the
+//!top left pixel) as a geotransform, the same way GDALReadWorldFile does
+//***********************************************************************//
+bool readWorldFile(const char* pszWorldFilePath, double *adfGeoTransform)
+	{
+	VSILFILE *fp = ::VSIFOpenL(pszWorldFilePath, "rb");
+	countRunStats(COUNTER_HEADER_OPENS);
+	if ( fp == NULL )
+		{ return false; }
+
+	double adfValues[6];
+	int nValues = 0;
+	const char *pszLine = NULL;
+
+	while ( nValues < 6 && (pszLine = ::CPLReadLineL(fp)) != NULL )
+		{
+		while ( *pszLine == ' ' || *pszLine == '\t' )
+			{ pszLine++; }
+
+		if ( *pszLine != '\0' )
+			{ adfValues[nValues++] = ::CPLAtof(pszLine); }
+		}
+
+	::VSIFCloseL(fp);
+
+	if ( nValues != 6 || adfValues[0] == 0.0 || adfValues[3] == 0.0 )
+		{ return false; }
+
+	adfGeoTransform[1] = adfValues[0];
+	adfGeoTransform[4] = adfValues[1];
+	adfGeoTransform[2] = adfValues[2];
+	adfGeoTransform[5] = adfValues[3];
+	adfGeoTransform[0] = adfValues[4] - 0.5 * adfValues[0] - 0.5 * adfValues[2];
+	adfGeoTransform[3] = adfValues[5] - 0.5 * adfValues[1] - 0.5 * adfValues[3];
+
+	return true;
+	}
+
+//***********************************************************************//
+//!Look for the world file of a dataset with the extensions GDAL tries
+//!(ie: tfw, tifw and wld for a tif file, lower and upper case)
+//***********************************************************************//
+bool readDatasetWorldFile(const char* pszFilePath, double *adfGeoTransform, SiblingIndex& oSiblingIndex)
+	{
+	std::string sExt = ::CPLGetExtension(pszFilePath);
+	const char *apszWorldFileExts[3] = { NULL, NULL, "wld" };
+	std::string sWorldFileExt = getWorldFileExt(pszFilePath);
+	std::string sLongWorldFileExt = sExt + "w";
+
+	apszWorldFileExts[0] = sWorldFileExt.c_str();
+	apszWorldFileExts[1] = sLongWorldFileExt.c_str();
+
+	for( int i = 0; i < 3; i++ )
+		{
+		std::string sWorldFilePath;
+
+		if ( oSiblingIndex.FindSibling(pszFilePath, apszWorldFileExts[i], sWorldFilePath) &&
+			 readWorldFile(sWorldFilePath.c_str(), adfGeoTransform) )
+			{ return true; }
+		}
+
+	return false;
+	}
+
+//***********************************************************************//
+//!Look for the .prj file of a dataset and read its content (ESRI WKT,
+//!PROJ string... anything OSRSetFromUserInput accepts)
+//***********************************************************************//
+bool readDatasetPrjFile(const char* pszFilePath, std::string& sSRS, SiblingIndex& oSiblingIndex)
+	{
+	std::string sPrjPath;
+	GByte *pabyContent = NULL;
+
+	if ( !oSiblingIndex.FindSibling(pszFilePath, "prj", sPrjPath) )
+		{ return false; }
+
+	countRunStats(COUNTER_HEADER_OPENS);
+	if ( !::VSIIngestFile(NULL, sPrjPath.c_str(), &pabyContent, NULL, 1024 * 1024) )
+		{ return false; }
+
+	sSRS = (const char *) pabyContent;
+	::VSIFree(pabyContent);
+
+	//trailing end of lines
+	while ( !sSRS.empty() && isspace((unsigned char) sSRS[sSRS.size() - 1]) )
+		{ sSRS.erase(sSRS.size() - 1); }
+
+	return !sSRS.empty();
+	}
+
+//***********************************************************************//
+//!Read the georeferencing of an ER Mapper .ers header (RegistrationCoord
+//!in easting/northing, cell sizes and raster size)
+//***********************************************************************//
+bool readERSGeoRef(const char* pszERSPath, DatasetGeoRef& oGeoRef)
+	{
+	VSILFILE *fp = ::VSIFOpenL(pszERSPath, "rb");
+	countRunStats(COUNTER_HEADER_OPENS);
+	if ( fp == NULL )
+		{ return false; }
+
+	double dfEastings = 0.0, dfNorthings = 0.0, dfCellX = 0.0, dfCellY = 0.0;
+	double dfXDim = 0.0, dfYDim = 0.0;
+	bool bHasEastings = false, bHasNorthings = false, bEN = false, bRotated = false;
+	int nLines = 0, nCells = 0;
+	const char *pszLine = NULL;
+
+	for( int iLine = 0; iLine < 1000 && (pszLine = ::CPLReadLineL(fp)) != NULL; iLine++ )
+		{
+		char **papszTokens = ::CSLTokenizeString2( pszLine, "= \t", CSLT_HONOURSTRINGS );
+
+		if ( ::CSLCount(papszTokens) == 2 )
+			{
+			const char *pszKey = papszTokens[0];
+			const char *pszValue = papszTokens[1];
+
+			if ( EQUAL(pszKey, "CoordinateType") )
+				{ bEN = EQUAL(pszValue, "EN"); }
+			else if ( EQUAL(pszKey, "Rotation") )
+				{
+				//degrees:minutes:seconds
+				char **papszDMS = ::CSLTokenizeString2( pszValue, ":", 0 );
+				for( int i = 0; papszDMS != NULL && papszDMS[i] != NULL; i++ )
+					{ bRotated = bRotated || ::CPLAtof(papszDMS[i]) != 0.0; }
+				::CSLDestroy(papszDMS);
+				}
+			else if ( EQUAL(pszKey, "NrOfLines") )
+				{ nLines = atoi(pszValue); }
+			else if ( EQUAL(pszKey, "NrOfCellsPerLine") )
+				{ nCells = atoi(pszValue); }
+			else if ( EQUAL(pszKey, "Xdimension") )
+				{ dfXDim = ::CPLAtof(pszValue); }
+			else if ( EQUAL(pszKey, "Ydimension") )
+				{ dfYDim = ::CPLAtof(pszValue); }
+			else if ( EQUAL(pszKey, "Eastings") )
+				{ dfEastings = ::CPLAtof(pszValue); bHasEastings = true; }
+			else if ( EQUAL(pszKey, "Northings") )
+				{ dfNorthings = ::CPLAtof(pszValue); bHasNorthings = true; }
+			else if ( EQUAL(pszKey, "RegistrationCellX") )
+				{ dfCellX = ::CPLAtof(pszValue); }
+			else if ( EQUAL(pszKey, "RegistrationCellY") )
+				{ dfCellY = ::CPLAtof(pszValue); }
+			}
+
+		::CSLDestroy(papszTokens);
+		}
+
+	::VSIFCloseL(fp);
+
+	if ( !bEN || bRotated || !bHasEastings || !bHasNorthings || nLines <= 0 || nCells <= 0 || dfXDim == 0.0 || dfYDim == 0.0 )
+		{ return false; }
+
+	oGeoRef.nRasterXSize = nCells;
+	oGeoRef.nRasterYSize = nLines;
+	oGeoRef.adfGeoTransform[1] = dfXDim;
+	oGeoRef.adfGeoTransform[2] = 0.0;
+	oGeoRef.adfGeoTransform[4] = 0.0;
+	oGeoRef.adfGeoTransform[5] = -dfYDim;
+	oGeoRef.adfGeoTransform[0] = dfEastings - dfCellX * dfXDim;
+	oGeoRef.adfGeoTransform[3] = dfNorthings + dfCellY * dfYDim;
+
+	return true;
+	}
+
+//***********************************************************************//
+//!Read the georeferencing of a dataset from its headers only (GeoTIFF
+//!tags, JPEG2000 size + world file, ER Mapper header), without GDALOpen.
+//!If psSRS, the SRS is read too (EPSG code of the GeoKeys or .prj file).
+//!Return false when it can't be resolved this way so GDAL is used instead
+//***********************************************************************//
+bool readGeoRefFast(const char* pszFilePath, DatasetGeoRef& oGeoRef, SiblingIndex& oSiblingIndex, std::string* psSRS)
+	{
+	//georef sources order changed by the user or overridden by a PAM .aux.xml
+	if ( ::CPLGetConfigOption("GDAL_GEOREF_SOURCES", NULL) != NULL ||
+		 oSiblingIndex.Exists( std::string(pszFilePath) + ".aux.xml" ) )
+		{ return false; }
+
+	std::string sSiblingPath;
+
+	std::string sExt = ::CPLGetExtension(pszFilePath);
+
+	if ( EQUAL(sExt.c_str(), "tif") || EQUAL(sExt.c_str(), "tiff") )
+		{
+		bool bHasGeoTransform = false;
+		int nEPSG = 0;
+
+		if ( !readTiffGeoRef(pszFilePath, oGeoRef, bHasGeoTransform, nEPSG) )
+			{ return false; }
+
+		//a MapInfo .tab file comes before the world file in GDAL georef sources
+		if ( !bHasGeoTransform && !oSiblingIndex.FindSibling(pszFilePath, "tab", sSiblingPath) )
+			{ bHasGeoTransform = readDatasetWorldFile(pszFilePath, oGeoRef.adfGeoTransform, oSiblingIndex); }
+
+		if ( !bHasGeoTransform || psSRS == NULL )
+			{ return bHasGeoTransform; }
+
+		//user defined GeoKeys are left to GDAL
+		if ( nEPSG == 0 )
+			{ return readDatasetPrjFile(pszFilePath, *psSRS, oSiblingIndex); }
+		if ( nEPSG == 32767 )
+			{ return false; }
+
+		*psSRS = CPLSPrintf("EPSG:%d", nEPSG);
+		return true;
+		}
+
+	if ( EQUAL(sExt.c_str(), "jp2") || EQUAL(sExt.c_str(), "j2k") )
+		{
+		return readJP2Size(pszFilePath, oGeoRef) && readDatasetWorldFile(pszFilePath, oGeoRef.adfGeoTransform, oSiblingIndex) &&
+			   ( psSRS == NULL || readDatasetPrjFile(pszFilePath, *psSRS, oSiblingIndex) );
+		}
+
+	//the ER Mapper projection names are left to GDAL
+	if ( psSRS != NULL )
+		{ return false; }
+
+	if ( EQUAL(sExt.c_str(), "ers") )
+		{ return readERSGeoRef(pszFilePath, oGeoRef); }
+
+	//ECW datasets delivered with their ER Mapper header (see getSiblingFilesExt)
+	if ( EQUAL(sExt.c_str(), "ecw") )
+		{ return oSiblingIndex.FindSibling(pszFilePath, "ers", sSiblingPath) && readERSGeoRef(sSiblingPath.c_str(), oGeoRef); }
+
+	return false;
+	}
+
+//***********************************************************************//
+//!Drivers of the datasets formats (--drivers auto) : driver, extensions,
+//!registration function when always built in, otherwise its symbol is
+//!looked up in GDAL then in the plugin (gdal_<plugin>) of GDAL_DRIVER_PATH
+//***********************************************************************//
+struct DriverRegistration
+	{
+	const char	*pszDriver;
+	const char	*pszExtensions;		//comma separated, lower case
+	void		(*pfnRegister)(void);
+	const char	*pszSymbol;			//registration function name
+	const char	*pszPlugin;			//plugin name, NULL if never built as a plugin
+	};
+
+static const DriverRegistration asDriverRegistrations[] =
+	{
+	{ "GTiff",			"tif,tiff",		GDALRegister_GTiff,	"GDALRegister_GTiff",			NULL },
+	{ "HFA",			"img",			GDALRegister_HFA,	"GDALRegister_HFA",				NULL },
+	{ "ENVI",			"img",			NULL,				"GDALRegister_ENVI",			NULL },
+	{ "ERS",			"ers",			NULL,				"GDALRegister_ERS",				NULL },
+	{ "JP2OpenJPEG",	"jp2,j2k",		NULL,				"GDALRegister_JP2OpenJPEG",		"JP2OpenJPEG" },
+	{ "JP2ECW",			"jp2,j2k",		NULL,				"GDALRegister_JP2ECW",			"ECW_JP2ECW" },
+	{ "JP2KAK",			"jp2,j2k",		NULL,				"GDALRegister_JP2KAK",			"JP2KAK" },
+	{ "JP2MrSID",		"jp2,j2k",		NULL,				"GDALRegister_JP2MrSID",		"MrSID" },
+	{ "ECW",			"ecw",			NULL,				"GDALRegister_ECW",				"ECW_JP2ECW" },
+	{ "GPKG",			"gpkg",			NULL,				"RegisterOGRGeoPackage",		NULL },
+	{ "FlatGeobuf",		"fgb",			NULL,				"RegisterOGRFlatGeobuf",		NULL },
+	{ NULL,				NULL,			NULL,				NULL,							NULL }
+	};
+
+//***********************************************************************//
+//!Find a registration function in the GDAL library itself (built in
+//!driver), NULL if not found
+//***********************************************************************//
+static void* getBuiltInSymbol(const char* pszSymbol)
+	{
+#ifdef _WIN32
+	HMODULE hGDAL = NULL;
+
+	//the module (dll) holding GDALAllRegister
+	if ( !::GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+							   (LPCSTR) &GDALAllRegister, &hGDAL) )
+		{ return NULL; }
+
+	return (void*) ::GetProcAddress(hGDAL, pszSymbol);
+#else
+	//global symbols of the process, GDAL included
+	return ::CPLGetSymbol(NULL, pszSymbol);
+#endif
+	}
+
+//***********************************************************************//
+//!Find a registration function in a plugin of the GDAL_DRIVER_PATH
+//!directories, NULL if not found
+//***********************************************************************//
+static void* getPluginSymbol(const char* pszPlugin, const char* pszSymbol)
+	{
+	const char *pszDriverPath = ::CPLGetConfigOption("GDAL_DRIVER_PATH", NULL);
+#ifdef _WIN32
+	char **papszPaths = ::CSLTokenizeString2(pszDriverPath != NULL ? pszDriverPath : "", ";", 0);
+	const char *pszLibExt = "dll";
+#elif defined(__APPLE__)
+	char **papszPaths = ::CSLTokenizeString2(pszDriverPath != NULL ? pszDriverPath : "", ":", 0);
+	const char *pszLibExt = "dylib";
+#else
+	char **papszPaths = ::CSLTokenizeString2(pszDriverPath != NULL ? pszDriverPath : "", ":", 0);
+	const char *pszLibExt = "so";
+#endif
+	void *pSymbol = NULL;
+
+	for( int i = 0; papszPaths != NULL && papszPaths[i] != NULL && pSymbol == NULL; i++ )
+		{
+		::VSIStatBufL psStatBuf;
+		std::string sPlugin = ::CPLFormFilename(papszPaths[i], CPLSPrintf("gdal_%s", pszPlugin), pszLibExt);
+
+		if ( ::VSIStatExL(sPlugin.c_str(), &psStatBuf, VSI_STAT_EXISTS_FLAG) == 0 )
+			{ pSymbol = ::CPLGetSymbol(sPlugin.c_str(), pszSymbol); }
+		}
+
+	::CSLDestroy(papszPaths);
+	return pSymbol;
+	}
+
+//***********************************************************************//
+//!Register a GDAL driver by name : always built in drivers directly,
+//!others from GDAL or from their plugin (without loading the other
+//!plugins as GDALAllRegister does). False if not found
+//***********************************************************************//
+bool registerDriver(const char* pszDriver)
+	{
+	const DriverRegistration *psRegistration = NULL;
+
+	if ( GetGDALDriverManager()->GetDriverByName(pszDriver) != NULL )
+		{ return true; }
+
+	for( int i = 0; asDriverRegistrations[i].pszDriver != NULL && psRegistration == NULL; i++ )
+		{
+		if ( EQUAL(asDriverRegistrations[i].pszDriver, pszDriver) )
+			{ psRegistration = &asDriverRegistrations[i]; }
+		}
+
+	void (*pfnRegister)(void) = psRegistration != NULL ? psRegistration->pfnRegister : NULL;
+	std::string sSymbol = psRegistration != NULL ? psRegistration->pszSymbol : CPLSPrintf("GDALRegister_%s", pszDriver);
+	std::string sPlugin = psRegistration != NULL ? ( psRegistration->pszPlugin != NULL ? psRegistration->pszPlugin : "" ) : pszDriver;
+
+	if ( pfnRegister == NULL )
+		{ pfnRegister = (void (*)(void)) getBuiltInSymbol(sSymbol.c_str()); }
+
+	//the plugin registration function is named after the plugin (ie: GDALRegister_ECW_JP2ECW)
+	if ( pfnRegister == NULL && !sPlugin.empty() )
+		{ pfnRegister = (void (*)(void)) getPluginSymbol(sPlugin.c_str(), CPLSPrintf("GDALRegister_%s", sPlugin.c_str())); }
+
+	if ( pfnRegister == NULL )
+		{ return false; }
+
+	pfnRegister();
+
+	return GetGDALDriverManager()->GetDriverByName(pszDriver) != NULL;
+	}
+
+//***********************************************************************//
+//!DriverAllowList constructor, no driver allowed until built
+//***********************************************************************//
+DriverAllowList::DriverAllowList() : papszDrivers(NULL)
+	{
+	}
+
+//***********************************************************************//
+//!DriverAllowList destructor
+//***********************************************************************//
+DriverAllowList::~DriverAllowList()
+	{
+	for( std::map<std::string, char**>::iterator it = oDriversByExt.begin(); it != oDriversByExt.end(); ++it )
+		{ ::CSLDestroy(it->second); }
+
+	::CSLDestroy(papszDrivers);
+	}
+
+//***********************************************************************//
+//!Build the allowed drivers from --drivers : "auto" for the drivers of
+//!the datasets extensions (false if an extension has no known driver,
+//!all the drivers are needed then) or a comma separated list of drivers.
+//!The drivers of each known extension are the allowed ones of its format
+//***********************************************************************//
+bool DriverAllowList::Build(const char* pszDrivers, char** papszExtensions)
+	{
+	bool bAuto = EQUAL(pszDrivers, "auto");
+
+	if ( !bAuto )
+		{ papszDrivers = ::CSLTokenizeString2(pszDrivers, ",", CSLT_STRIPLEADSPACES | CSLT_STRIPENDSPACES); }
+
+	for( int i = 0; papszExtensions != NULL && papszExtensions[i] != NULL; i++ )
+		{
+		std::string sExt = papszExtensions[i];
+		bool bKnown = false;
+
+		std::transform(sExt.begin(), sExt.end(), sExt.begin(), ::tolower);
+
+		for( int j = 0; asDriverRegistrations[j].pszDriver != NULL; j++ )
+			{
+			const DriverRegistration& oRegistration = asDriverRegistrations[j];
+			char **papszDriverExts = ::CSLTokenizeString2(oRegistration.pszExtensions, ",", 0);
+			bool bMatch = ::CSLFindString(papszDriverExts, sExt.c_str()) >= 0;
+
+			::CSLDestroy(papszDriverExts);
+			if ( !bMatch )
+				{ continue; }
+			bKnown = true;
+
+			if ( !bAuto && ::CSLFindString(papszDrivers, oRegistration.pszDriver) < 0 )
+				{ continue; }
+
+			char **&papszExtDrivers = oDriversByExt[sExt];
+			if ( ::CSLFindString(papszExtDrivers, oRegistration.pszDriver) < 0 )
+				{ papszExtDrivers = ::CSLAddString(papszExtDrivers, oRegistration.pszDriver); }
+			if ( bAuto )
+				{ AddDriver(oRegistration.pszDriver); }
+			}
+
+		if ( bAuto && !bKnown )
+			{
+			::CPLDebug("GDAL_RENAME", "No known driver for the extension '%s', all the drivers registered", sExt.c_str());
+			return false;
+			}
+		}
+
+	return true;
+	}
+
+//***********************************************************************//
+//!Allow and register one more driver (ie: the tile index driver)
+//***********************************************************************//
+void DriverAllowList::AddDriver(const char* pszDriver)
+	{
+	if ( ::CSLFindString(papszDrivers, pszDriver) < 0 )
+		{ papszDrivers = ::CSLAddString(papszDrivers, pszDriver); }
+	}
+
+//***********************************************************************//
+//!Register the allowed drivers only, then the GDAL_SKIP ones are removed
+//!as GDALAllRegister does. The drivers not found (not built nor in the
+//!GDAL_DRIVER_PATH plugins) are reported if bReportMissing
+//***********************************************************************//
+void DriverAllowList::Register(bool bReportMissing) const
+	{
+	for( int i = 0; papszDrivers != NULL && papszDrivers[i] != NULL; i++ )
+		{
+		if ( registerDriver(papszDrivers[i]) )
+			{ continue; }
+
+		if ( bReportMissing )
+			{ ::CPLError(CE_Warning, CPLE_AppDefined, "Driver '%s' not found (built in GDAL or plugin of GDAL_DRIVER_PATH)", papszDrivers[i]); }
+		else
+			{ ::CPLDebug("GDAL_RENAME", "Driver '%s' not available", papszDrivers[i]); }
+		}
+
+	GetGDALDriverManager()->AutoSkipDrivers();
+	}
+
+//***********************************************************************//
+//!Drivers allowed to open a dataset : the ones of its extension if known,
+//!otherwise all the allowed drivers
+//***********************************************************************//
+char** DriverAllowList::GetDrivers(const char* pszFilePath) const
+	{
+	std::string sExt = ::CPLGetExtension(pszFilePath);
+
+	std::transform(sExt.begin(), sExt.end(), sExt.begin(), ::tolower);
+
+	std::map<std::string, char**>::const_iterator it = oDriversByExt.find(sExt);
+	return it != oDriversByExt.end() ? it->second : papszDrivers;
+	}
+
+//***********************************************************************//
+//!Read the georeferencing of a dataset, from its headers if bFastGeoRef
+//!and possible, otherwise with GDALOpenEx probing only the allowed drivers
+//!(all if papszAllowedDrivers is NULL)
+//***********************************************************************//
+bool readGeoRef(const char* pszFilePath, DatasetGeoRef& oGeoRef, bool bFastGeoRef, char** papszAllowedDrivers, SiblingIndex& oSiblingIndex, std::string* psSRS)
+	{
+	if ( bFastGeoRef )
+		{
+		PhaseTimer oTimer(PHASE_HEADER_READ);
+
+		if ( readGeoRefFast(pszFilePath, oGeoRef, oSiblingIndex, psSRS) )
+			{
+			countRunStats(COUNTER_FAST_GEOREF);
+			return true;
+			}
+		}
+
+	::GDALDataset *poDataset = NULL;
+	bool Success = false;
+
+	countRunStats(COUNTER_GDAL_OPEN);
+		{
+		PhaseTimer oTimer(PHASE_OPEN);
+		poDataset = (GDALDataset *) ::GDALOpenEx( pszFilePath, GDAL_OF_RASTER | GDAL_OF_READONLY | GDAL_OF_VERBOSE_ERROR,
+												  papszAllowedDrivers, NULL, NULL );
+		}
+
+	if( poDataset == NULL )
+		{
+		countRunStats(COUNTER_FAILED_OPEN);
+		return false;
+		}
+
+		{
+		PhaseTimer oTimer(PHASE_GEOTRANSFORM);
+		Success = ( poDataset->GetGeoTransform( oGeoRef.adfGeoTransform ) == CE_None );
+		oGeoRef.nRasterXSize = poDataset->GetRasterXSize();
+		oGeoRef.nRasterYSize = poDataset->GetRasterYSize();
+
+		if ( psSRS != NULL && poDataset->GetProjectionRef() != NULL )
+			{ *psSRS = poDataset->GetProjectionRef(); }
+		}
+
+		{
+		PhaseTimer oTimer(PHASE_CLOSE);
+		::GDALClose((GDALDatasetH)poDataset);
+		}
+
+	if ( !Success )
+		{
+		countRunStats(COUNTER_FAILED_NO_GEOREF);
+		::CPLError(CE_Failure, CPLE_AppDefined, "No GeoRef information found by GDAL in the file \"%s\"", pszFilePath);
+		return false;
+		}
+
+	//GDAL drivers ignoring the .prj files, left empty if none
+	if ( psSRS != NULL && psSRS->empty() )
+		{ readDatasetPrjFile(pszFilePath, *psSRS, oSiblingIndex); }
+
+	return true;
+	}
+
+//***********************************************************************//
+//!Georeferencing cache file layout : header, records sorted by path hash
+//!and the pool of the (absolute) paths of the records
+//***********************************************************************//
+#define GDAL_RENAME_CACHE_MAGIC		"GRCACHE2"
+#define GDAL_RENAME_CACHE_BYTE_ORDER	0x01020304
+
+struct GeoRefCacheHeader
+	{
+	char		szMagic[8];
+	GUInt32		nByteOrder;		//files written on another byte order are ignored
+	GUInt32		nRecords;
+	GUIntBig	nPathsSize;
+	};
+
+//***********************************************************************//
+//!FNV-1a hash of a path
+//***********************************************************************//
+static GUIntBig hashCachePath(const std::string& sPath)
+	{
+	GUIntBig nHash = 14695981039346656037ULL;
+
+	for( size_t i = 0; i < sPath.size(); i++ )
+		{
+		nHash ^= (GByte) sPath[i];
+		nHash *= 1099511628211ULL;
+		}
+
+	return nHash;
+	}
+
+static bool compareCacheRecords(const GeoRefCacheRecord& oRecord1, const GeoRefCacheRecord& oRecord2)
+	{ return oRecord1.nPathHash < oRecord2.nPathHash; }
+
+//***********************************************************************//
+//!Georeferencing cache, the cache file is mapped read only and the new
+//!records are kept in memory until Save()
+//***********************************************************************//
+GeoRefCache::GeoRefCache()
+	{
+	pabyData = NULL;
+	nDataSize = 0;
+	bMapped = false;
+	psRecords = NULL;
+	nRecords = 0;
+	pszPaths = NULL;
+	nPathsSize = 0;
+	hMutex = NULL;
+
+	char *pszCurrentDir = ::CPLGetCurrentDir();
+	sCurrentDir = pszCurrentDir != NULL ? pszCurrentDir : "";
+	::CPLFree(pszCurrentDir);
+	}
+
+GeoRefCache::~GeoRefCache()
+	{
+	Close();
+
+	if ( hMutex != NULL )
+		{ ::CPLDestroyMutex(hMutex); }
+	}
+
+//***********************************************************************//
+//!Unmap the cache file
+//***********************************************************************//
+void GeoRefCache::Close()
+	{
+#ifndef _WIN32
+	if ( bMapped )
+		{ munmap(pabyData, nDataSize); }
+	else
+#endif
+		{ ::CPLFree(pabyData); }
+
+	pabyData = NULL;
+	nDataSize = 0;
+	bMapped = false;
+	psRecords = NULL;
+	nRecords = 0;
+	}
+
+//***********************************************************************//
+//!Open the cache file (memory mapped, read in memory on windows). A
+//!missing file is an empty cache, created by Save()
+//***********************************************************************//
+bool GeoRefCache::Open(const char* pszPath)
+	{
+	Close();
+	sPath = pszPath;
+
+	VSIStatBufL psStatBuf;
+	if ( ::VSIStatL(pszPath, &psStatBuf) != 0 )
+		{ return true; }
+
+	nDataSize = (size_t) psStatBuf.st_size;
+	if ( nDataSize < sizeof(GeoRefCacheHeader) )
+		{
+		nDataSize = 0;
+		return true;
+		}
+
+#ifndef _WIN32
+	int nFd = open(pszPath, O_RDONLY);
+	if ( nFd >= 0 )
+		{
+		void *pData = mmap(NULL, nDataSize, PROT_READ, MAP_SHARED, nFd, 0);
+		close(nFd);
+
+		if ( pData != MAP_FAILED )
+			{
+			pabyData = (GByte *) pData;
+			bMapped = true;
+			}
+		}
+#endif
+
+	if ( pabyData == NULL )
+		{
+		VSILFILE *fp = ::VSIFOpenL(pszPath, "rb");
+		pabyData = (GByte *) ::CPLMalloc(nDataSize);
+
+		if ( fp == NULL || ::VSIFReadL(pabyData, 1, nDataSize, fp) != nDataSize )
+			{
+			if ( fp != NULL )
+				{ ::VSIFCloseL(fp); }
+			Close();
+			::CPLError(CE_Warning, CPLE_FileIO, "Unable to read the georeferencing cache \"%s\", it is rebuilt", pszPath);
+			return true;
+			}
+
+		::VSIFCloseL(fp);
+		}
+
+	const GeoRefCacheHeader *psHeader = (const GeoRefCacheHeader *) pabyData;
+
+	if ( memcmp(psHeader->szMagic, GDAL_RENAME_CACHE_MAGIC, 8) != 0 || psHeader->nByteOrder != GDAL_RENAME_CACHE_BYTE_ORDER ||
+		 sizeof(GeoRefCacheHeader) + psHeader->nRecords * (GUIntBig) sizeof(GeoRefCacheRecord) + psHeader->nPathsSize != nDataSize )
+		{
+		Close();
+		::CPLError(CE_Warning, CPLE_AppDefined, "\"%s\" is not a valid georeferencing cache, it is rebuilt", pszPath);
+		return true;
+		}
+
+	nRecords = psHeader->nRecords;
+	psRecords = (const GeoRefCacheRecord *)(pabyData + sizeof(GeoRefCacheHeader));
+	pszPaths = (const char *)(psRecords + nRecords);
+	nPathsSize = (size_t) psHeader->nPathsSize;
+
+	return true;
+	}
+
+//***********************************************************************//
+//!Key of a file in the cache : its absolute path, without the "."
+//!components (ie: "./new_name.tif" of a renamed dataset)
+//***********************************************************************//
+std::string GeoRefCache::GetKey(const char* pszFilePath) const
+	{
+	std::string sPath = ::CPLIsFilenameRelative(pszFilePath) ? sCurrentDir + sDirSep + pszFilePath : std::string(pszFilePath);
+	size_t nPos = 0;
+
+	while ( ( nPos = sPath.find_first_of("/\\", nPos) ) != std::string::npos )
+		{
+		if ( nPos + 2 < sPath.size() && sPath[nPos + 1] == '.' && ( sPath[nPos + 2] == '/' || sPath[nPos + 2] == '\\' ) )
+			{ sPath.erase(nPos, 2); }
+		else
+			{ nPos++; }
+		}
+
+	return SiblingIndex::GetKey(sPath);
+	}
+
+//***********************************************************************//
+//!Look for the georeferencing of a file, valid only if the file size,
+//!modification time and inode did not change. oRecord receives the
+//!current file stamp to Add() the file if not found
+//***********************************************************************//
+bool GeoRefCache::Lookup(const char* pszFilePath, GeoRefCacheRecord& oRecord, DatasetGeoRef& oGeoRef) const
+	{
+	VSIStatBufL psStatBuf;
+
+	memset(&oRecord, 0, sizeof(oRecord));
+	if ( ::VSIStatL(pszFilePath, &psStatBuf) != 0 )
+		{ return false; }
+
+	std::string sKey = GetKey(pszFilePath);
+	oRecord.nPathHash = hashCachePath(sKey);
+	oRecord.nSize = (GUIntBig) psStatBuf.st_size;
+	oRecord.nMTime = (GIntBig) psStatBuf.st_mtime;
+	oRecord.nMTimeNSec = (GUInt32) GDAL_RENAME_STAT_MTIME_NSEC(psStatBuf);
+	oRecord.nInode = (GUIntBig) psStatBuf.st_ino;
+
+	const GeoRefCacheRecord *psRecord = std::lower_bound(psRecords, psRecords + nRecords, oRecord, compareCacheRecords);
+
+	for( ; psRecord != psRecords + nRecords && psRecord->nPathHash == oRecord.nPathHash; psRecord++ )
+		{
+		if ( psRecord->nPathOffset + psRecord->nPathLength > nPathsSize ||
+			 sKey.compare(0, std::string::npos, pszPaths + psRecord->nPathOffset, psRecord->nPathLength) != 0 )
+			{ continue; }
+
+		if ( psRecord->nSize != oRecord.nSize || psRecord->nMTime != oRecord.nMTime || psRecord->nMTimeNSec != oRecord.nMTimeNSec ||
+			 psRecord->nInode != oRecord.nInode )
+			{ return false; }
+
+		memcpy(oGeoRef.adfGeoTransform, psRecord->adfGeoTransform, sizeof(oGeoRef.adfGeoTransform));
+		oGeoRef.nRasterXSize = psRecord->nRasterXSize;
+		oGeoRef.nRasterYSize = psRecord->nRasterYSize;
+		return true;
+		}
+
+	return false;
+	}
+
+//***********************************************************************//
+//!Add the georeferencing of a file read this run (oRecord is the stamp
+//!returned by Lookup())
+//***********************************************************************//
+void GeoRefCache::Add(const char* pszFilePath, const GeoRefCacheRecord& oRecord, const DatasetGeoRef& oGeoRef)
+	{
+	//file not found by Lookup()
+	if ( oRecord.nPathHash == 0 )
+		{ return; }
+
+	GeoRefCacheRecord oNewRecord = oRecord;
+	memcpy(oNewRecord.adfGeoTransform, oGeoRef.adfGeoTransform, sizeof(oNewRecord.adfGeoTransform));
+	oNewRecord.nRasterXSize = oGeoRef.nRasterXSize;
+	oNewRecord.nRasterYSize = oGeoRef.nRasterYSize;
+
+	CPLMutexHolderD(&hMutex);
+	oNewRecords[GetKey(pszFilePath)] = oNewRecord;
+	}
+
+//***********************************************************************//
+//!Record a file rename so its georeferencing is saved with its new path
+//!(a rename keeps the size, modification time and inode of the file)
+//***********************************************************************//
+void GeoRefCache::Renamed(const std::string& sSourcePath, const std::string& sNewPath)
+	{
+	CPLMutexHolderD(&hMutex);
+	oRenamed[GetKey(sSourcePath.c_str())] = GetKey(sNewPath.c_str());
+	}
+
+//***********************************************************************//
+//!Write the cache file with the records read this run and the renames
+//!applied : written to a temporary file and renamed over the old one
+//***********************************************************************//
+bool GeoRefCache::Save()
+	{
+	CPLMutexHolderD(&hMutex);
+
+	if ( sPath.empty() || (oNewRecords.empty() && oRenamed.empty()) )
+		{ return true; }
+
+	std::unordered_map<std::string, GeoRefCacheRecord> oRecords;
+
+	for( size_t i = 0; i < nRecords; i++ )
+		{
+		if ( psRecords[i].nPathOffset + psRecords[i].nPathLength <= nPathsSize )
+			{ oRecords[std::string(pszPaths + psRecords[i].nPathOffset, psRecords[i].nPathLength)] = psRecords[i]; }
+		}
+
+	std::unordered_map<std::string, GeoRefCacheRecord>::iterator it = oNewRecords.begin();
+	while ( it != oNewRecords.end() )
+		{
+		oRecords[it->first] = it->second;
+		++it;
+		}
+
+	std::unordered_map<std::string, std::string>::iterator itRenamed = oRenamed.begin();
+	while ( itRenamed != oRenamed.end() )
+		{
+		it = oRecords.find(itRenamed->first);
+		if ( it != oRecords.end() )
+			{
+			GeoRefCacheRecord oRecord = it->second;
+			oRecords.erase(it);
+			oRecords[itRenamed->second] = oRecord;
+			}
+		++itRenamed;
+		}
+
+	std::vector<GeoRefCacheRecord> aoRecords;
+	std::string sPaths;
+
+	aoRecords.reserve(oRecords.size());
+	for( it = oRecords.begin(); it != oRecords.end(); ++it )
+		{
+		GeoRefCacheRecord oRecord = it->second;
+		oRecord.nPathHash = hashCachePath(it->first);
+		oRecord.nPathOffset = sPaths.size();
+		oRecord.nPathLength = (GUInt32) it->first.size();
+		sPaths += it->first;
+		aoRecords.push_back(oRecord);
+		}
+
+	std::sort(aoRecords.begin(), aoRecords.end(), compareCacheRecords);
+
+	GeoRefCacheHeader sHeader;
+	memcpy(sHeader.szMagic, GDAL_RENAME_CACHE_MAGIC, 8);
+	sHeader.nByteOrder = GDAL_RENAME_CACHE_BYTE_ORDER;
+	sHeader.nRecords = (GUInt32) aoRecords.size();
+	sHeader.nPathsSize = sPaths.size();
+
+	std::string sTmpPath = sPath + ".tmp";
+	VSILFILE *fp = ::VSIFOpenL(sTmpPath.c_str(), "wb");
+	bool bSuccess = ( fp != NULL );
+
+	if ( bSuccess )
+		{
+		bSuccess = ::VSIFWriteL(&sHeader, sizeof(sHeader), 1, fp) == 1 &&
+				   ( aoRecords.empty() || ::VSIFWriteL(&aoRecords[0], sizeof(GeoRefCacheRecord), aoRecords.size(), fp) == aoRecords.size() ) &&
+				   ::VSIFWriteL(sPaths.data(), 1, sPaths.size(), fp) == sPaths.size();
+		bSuccess = ( ::VSIFCloseL(fp) == 0 ) && bSuccess;
+		}
+
+	Close();
+
+#ifdef _WIN32
+	//rename does not replace an existing file on windows
+	if ( bSuccess )
+		{ ::VSIUnlink(sPath.c_str()); }
+#endif
+
+	if ( !bSuccess || ::VSIRename(sTmpPath.c_str(), sPath.c_str()) != 0 )
+		{
+		::VSIUnlink(sTmpPath.c_str());
+		::CPLError(CE_Failure, CPLE_FileIO, "Unable to write the georeferencing cache \"%s\"", sPath.c_str());
+		return false;
+		}
+
+	oNewRecords.clear();
+	oRenamed.clear();
+
+	return Open(sPath.c_str());
+	}
+
+//***********************************************************************//
+//!Tile index of the renamed datasets, the layer is created with the
+//!first features (its SRS is the one of the first dataset, as gdaltindex)
+//***********************************************************************//
+TileIndex::TileIndex()
+	{
+	poDataset = NULL;
+	poLayer = NULL;
+	poReprojection = NULL;
+	nLocationField = -1;
+	nSRSField = -1;
+	nPendingFeatures = 0;
+	bTransaction = false;
+	bSuccess = true;
+	}
+
+TileIndex::~TileIndex()
+	{
+	Close();
+	}
+
+//***********************************************************************//
+//!Create the tile index file with a GDAL vector driver ("GPKG" or
+//!"FlatGeobuf"), an existing file is not written over
+//***********************************************************************//
+bool TileIndex::Open(const char* pszPath, const char* pszFormat)
+	{
+	::VSIStatBufL psStatBuf;
+	if ( ::VSIStatExL(pszPath, &psStatBuf, VSI_STAT_EXISTS_FLAG) == 0 )
+		{
+		::CPLError(CE_Failure, CPLE_FileIO, "Tile index \"%s\" already exists", pszPath);
+		return false;
+		}
+
+	GDALDriver *poDriver = GetGDALDriverManager()->GetDriverByName(pszFormat);
+
+	if ( poDriver == NULL )
+		{
+		::CPLError(CE_Failure, CPLE_AppDefined, "GDAL driver \"%s\" not available for the tile index", pszFormat);
+		return false;
+		}
+
+	poDataset = poDriver->Create(pszPath, 0, 0, 0, GDT_Unknown, NULL);
+
+	if ( poDataset == NULL )
+		{
+		::CPLError(CE_Failure, CPLE_FileIO, "Unable to create the tile index \"%s\"", pszPath);
+		return false;
+		}
+
+	sPath = pszPath;
+	return true;
+	}
+
+//***********************************************************************//
+//!Create the layer of the tile index : polygons with a spatial index,
+//!location (new path of the dataset) and srs fields
+//***********************************************************************//
+bool TileIndex::CreateLayer(const std::string& sSRS)
+	{
+	OGRSpatialReference *poSRS = NULL;
+
+	if ( !sSRS.empty() )
+		{
+		poSRS = new OGRSpatialReference();
+		if ( poSRS->SetFromUserInput(sSRS.c_str()) != OGRERR_NONE )
+			{
+			poSRS->Release();
+			poSRS = NULL;
+			}
+#if GDAL_VERSION_NUM >= 3000000
+		else
+			{ poSRS->SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER); }
+#endif
+		}
+
+	char **papszOptions = ::CSLAddString(NULL, "SPATIAL_INDEX=YES");
+	poLayer = poDataset->CreateLayer(::CPLGetBasename(sPath.c_str()), poSRS, wkbPolygon, papszOptions);
+	::CSLDestroy(papszOptions);
+
+	//the layer keeps its own reference
+	if ( poSRS != NULL )
+		{ poSRS->Release(); }
+
+	if ( poLayer == NULL )
+		{ return false; }
+
+	sLayerSRS = sSRS;
+
+	OGRFieldDefn oLocationField("location", OFTString);
+	OGRFieldDefn oSRSField("srs", OFTString);
+
+	if ( poLayer->CreateField(&oLocationField) != OGRERR_NONE || poLayer->CreateField(&oSRSField) != OGRERR_NONE )
+		{ return false; }
+
+	nLocationField = poLayer->GetLayerDefn()->GetFieldIndex("location");
+	nSRSField = poLayer->GetLayerDefn()->GetFieldIndex("srs");
+
+	return true;
+	}
+
+//***********************************************************************//
+//!Commit the features written since the transaction start
+//***********************************************************************//
+bool TileIndex::CommitTransaction()
+	{
+	nPendingFeatures = 0;
+
+	if ( !bTransaction )
+		{ return true; }
+
+	bTransaction = false;
+	return poDataset->CommitTransaction() == OGRERR_NONE;
+	}
+
+//***********************************************************************//
+//!Write the footprints of the datasets of a group of jobs whose rename
+//!succeeded (their new path), a transaction is committed every
+//!GDAL_RENAME_TILE_INDEX_TRANSACTION features
+//***********************************************************************//
+void TileIndex::Add(const std::vector<RenameJob>& aoJobs, const char* pszOutputDir)
+	{
+	if ( poDataset == NULL || !bSuccess )
+		{ return; }
+
+	PhaseTimer oTimer(PHASE_TILE_INDEX);
+
+	for( size_t i = 0; i < aoJobs.size() && bSuccess; i++ )
+		{
+		const RenameJob& oJob = aoJobs[i];
+
+		if ( !oJob.bSuccess )
+			{ continue; }
+
+		if ( poLayer == NULL && !CreateLayer(oJob.sSRS) )
+			{
+			::CPLError(CE_Failure, CPLE_AppDefined, "Unable to create the layer of the tile index \"%s\"", sPath.c_str());
+			bSuccess = false;
+			break;
+			}
+
+		//FlatGeobuf has no transactions, its features are buffered until the close
+		if ( nPendingFeatures == 0 && !bTransaction )
+			{ bTransaction = ( poDataset->StartTransaction() == OGRERR_NONE ); }
+
+		const double *adfGT = oJob.oGeoRef.adfGeoTransform;
+		const double adfPixels[5][2] = { {0, 0}, {(double) oJob.oGeoRef.nRasterXSize, 0},
+										 {(double) oJob.oGeoRef.nRasterXSize, (double) oJob.oGeoRef.nRasterYSize},
+										 {0, (double) oJob.oGeoRef.nRasterYSize}, {0, 0} };
+		OGRLinearRing *poRing = new OGRLinearRing();
+		OGRPolygon *poFootprint = new OGRPolygon();
+
+		for( int j = 0; j < 5; j++ )
+			{
+			poRing->addPoint( adfGT[0] + adfPixels[j][0] * adfGT[1] + adfPixels[j][1] * adfGT[2],
+							  adfGT[3] + adfPixels[j][0] * adfGT[4] + adfPixels[j][1] * adfGT[5] );
+			}
+		poFootprint->addRingDirectly(poRing);
+
+		std::string sNewPath = getRenamedPath(oJob.sFilePath, oJob.sNewFileName, ::CPLGetExtension(oJob.sFilePath.c_str()), pszOutputDir);
+
+		//corners reprojected to the layer SRS, as gdaltindex -t_srs
+		if ( oJob.sSRS != sLayerSRS )
+			{
+			OGRCoordinateTransformationH hTransform = NULL;
+
+			if ( !oJob.sSRS.empty() && !sLayerSRS.empty() )
+				{
+				if ( poReprojection == NULL )
+					{ poReprojection = new ReprojectionCache(sLayerSRS.c_str()); }
+				hTransform = poReprojection->Get(oJob.sSRS);
+				}
+
+			if ( hTransform == NULL || poFootprint->transform( (OGRCoordinateTransformation *) hTransform ) != OGRERR_NONE )
+				{
+				::CPLError(CE_Warning, CPLE_AppDefined, "\"%s\" not written to the tile index \"%s\", its footprint can't be reprojected to the SRS of the index",
+						   sNewPath.c_str(), sPath.c_str());
+				delete poFootprint;
+				continue;
+				}
+			}
+
+		OGRFeature *poFeature = OGRFeature::CreateFeature(poLayer->GetLayerDefn());
+		poFeature->SetField(nLocationField, sNewPath.c_str());
+		poFeature->SetField(nSRSField, oJob.sSRS.c_str());
+		poFeature->SetGeometryDirectly(poFootprint);
+
+		if ( poLayer->CreateFeature(poFeature) != OGRERR_NONE )
+			{
+			::CPLError(CE_Failure, CPLE_AppDefined, "Unable to write \"%s\" to the tile index \"%s\"", sNewPath.c_str(), sPath.c_str());
+			bSuccess = false;
+			}
+		else
+			{ countRunStats(COUNTER_INDEXED); }
+
+		OGRFeature::DestroyFeature(poFeature);
+
+		if ( ++nPendingFeatures >= GDAL_RENAME_TILE_INDEX_TRANSACTION )
+			{ bSuccess = CommitTransaction() && bSuccess; }
+		}
+	}
+
+//***********************************************************************//
+//!Commit the last features and close the tile index, the spatial index
+//!is built by the driver on close (FlatGeobuf)
+//***********************************************************************//
+bool TileIndex::Close()
+	{
+	if ( poDataset == NULL )
+		{ return bSuccess; }
+
+	PhaseTimer oTimer(PHASE_TILE_INDEX);
+
+	bSuccess = CommitTransaction() && bSuccess;
+
+	//an empty index still has its layer
+	if ( poLayer == NULL && !CreateLayer("") )
+		{ bSuccess = false; }
+
+	::GDALClose( (GDALDatasetH) poDataset );
+	poDataset = NULL;
+	poLayer = NULL;
+	delete poReprojection;
+	poReprojection = NULL;
+
+	if ( !bSuccess )
+		{ ::CPLError(CE_Failure, CPLE_FileIO, "Error while writing the tile index \"%s\"", sPath.c_str()); }
+
+	return bSuccess;
+	}
+
+//***********************************************************************//
+//!Duplicate targets check, nothing recorded yet
+//***********************************************************************//
+DuplicateCheck::DuplicateCheck()
+	{
+	nMemoryBudget = (size_t) GDAL_RENAME_CHECK_MEMORY * 1024 * 1024;
+	nMemoryUsed = 0;
+	nDuplicates = 0;
+	nDuplicateDatasets = 0;
+	nExistingTargets = 0;
+	bSuccess = true;
+	}
+
+DuplicateCheck::~DuplicateCheck()
+	{
+	for( size_t i = 0; i < asRunPaths.size(); i++ )
+		{ ::VSIUnlink(asRunPaths[i].c_str()); }
+	}
+
+//***********************************************************************//
+//!Memory used by the hash table of the targets before it is spilled
+//***********************************************************************//
+void DuplicateCheck::SetMemoryBudget(size_t nBytes)
+	{
+	nMemoryBudget = nBytes;
+	}
+
+//***********************************************************************//
+//!Record the targets of a group of datasets of the rename stage, and
+//!their sources (so the targets taken by a dataset of the inventory are
+//!known). The hash table is spilled once over the memory budget
+//***********************************************************************//
+void DuplicateCheck::Add(const std::vector<RenameJob>& aoJobs, const char* pszOutputDir)
+	{
+	for( size_t i = 0; i < aoJobs.size(); i++ )
+		{
+		const RenameJob& oJob = aoJobs[i];
+
+		if ( !oJob.bSuccess )
+			{ continue; }
+
+		std::string sTarget = getRenamedPath(oJob.sFilePath, oJob.sNewFileName, ::CPLGetExtension(oJob.sFilePath.c_str()), pszOutputDir);
+		std::vector<std::string>& asTargetSources = oTargets[sTarget];
+		std::vector<std::string>& asSourceSources = oTargets[oJob.sFilePath];
+
+		//node, key and value strings (the estimate leans on the high side)
+		nMemoryUsed += ( asTargetSources.empty() ? sTarget.size() + 96 : 0 ) + oJob.sFilePath.size() + 32;
+		nMemoryUsed += ( asSourceSources.empty() ? oJob.sFilePath.size() + 96 : 0 ) + 32;
+		asTargetSources.push_back(oJob.sFilePath);
+		asSourceSources.push_back("");
+		}
+
+	if ( nMemoryUsed > nMemoryBudget )
+		{ Spill(); }
+	}
+
+//***********************************************************************//
+//!Order of the targets in the runs and in the report
+//***********************************************************************//
+static bool compareStringPointers(const std::string* psString1, const std::string* psString2)
+	{
+	return *psString1 < *psString2;
+	}
+
+//***********************************************************************//
+//!Write the hash table sorted by target to a run file (NUL terminated
+//!target and source records) and empty it
+//***********************************************************************//
+bool DuplicateCheck::Spill()
+	{
+	PhaseTimer oTimer(PHASE_DUPLICATE_CHECK);
+	std::vector<const std::string*> apsTargets;
+	std::string sRunPath = ::CPLGenerateTempFilename("gdal_rename_check");
+	VSILFILE *fp = ::VSIFOpenL(sRunPath.c_str(), "wb");
+
+	if ( fp == NULL )
+		{
+		::CPLError(CE_Failure, CPLE_FileIO, "Unable to create the run file \"%s\", the memory budget is exceeded", sRunPath.c_str());
+		bSuccess = false;
+		return false;
+		}
+
+	asRunPaths.push_back(sRunPath);
+	countRunStats(COUNTER_CHECK_SPILLS);
+
+	for( std::unordered_map< std::string, std::vector<std::string> >::const_iterator it = oTargets.begin(); it != oTargets.end(); ++it )
+		{ apsTargets.push_back(&it->first); }
+	std::sort(apsTargets.begin(), apsTargets.end(), compareStringPointers);
+
+	for( size_t i = 0; i < apsTargets.size() && bSuccess; i++ )
+		{
+		const std::vector<std::string>& asSources = oTargets[*apsTargets[i]];
+
+		for( size_t j = 0; j < asSources.size() && bSuccess; j++ )
+			{
+			bSuccess = ::VSIFWriteL(apsTargets[i]->c_str(), 1, apsTargets[i]->size() + 1, fp) == apsTargets[i]->size() + 1 &&
+					   ::VSIFWriteL(asSources[j].c_str(), 1, asSources[j].size() + 1, fp) == asSources[j].size() + 1;
+			}
+		}
+
+	bSuccess = ( ::VSIFCloseL(fp) == 0 ) && bSuccess;
+	if ( !bSuccess )
+		{ ::CPLError(CE_Failure, CPLE_FileIO, "Error while writing the run file \"%s\"", sRunPath.c_str()); }
+
+	oTargets.clear();
+	nMemoryUsed = 0;
+	return bSuccess;
+	}
+
+//***********************************************************************//
+//!Report a target of several datasets, or of one dataset when an existing
+//!file out of the inventory holds it (it would be backed up as _OldOne)
+//***********************************************************************//
+void DuplicateCheck::ReportTarget(const std::string& sTarget, const std::vector<std::string>& asSources)
+	{
+	std::vector<std::string> asDatasets;
+	bool bIsSource = false;
+
+	for( size_t i = 0; i < asSources.size(); i++ )
+		{
+		if ( asSources[i].empty() )
+			{ bIsSource = true; }
+		else
+			{ asDatasets.push_back(asSources[i]); }
+		}
+
+	if ( asDatasets.size() > 1 )
+		{
+		//the same report whether the targets were spilled or not
+		std::sort(asDatasets.begin(), asDatasets.end());
+		std::string sReport = CPLSPrintf("Duplicate target \"%s\" of %d datasets :", sTarget.c_str(), (int) asDatasets.size());
+
+		for( size_t i = 0; i < asDatasets.size(); i++ )
+			{ sReport += "\n    \"" + asDatasets[i] + "\""; }
+
+		::CPLError(CE_Warning, CPLE_AppDefined, "%s", sReport.c_str());
+		countRunStats(COUNTER_DUPLICATE_TARGETS);
+		nDuplicates++;
+		nDuplicateDatasets += (int) asDatasets.size();
+		return;
+		}
+
+	::VSIStatBufL psStatBuf;
+
+	if ( asDatasets.size() == 1 && !bIsSource && ::VSIStatExL(sTarget.c_str(), &psStatBuf, VSI_STAT_EXISTS_FLAG) == 0 )
+		{
+		::CPLError(CE_Warning, CPLE_AppDefined, "Existing target \"%s\" out of the inventory, renaming \"%s\" would back it up",
+				   sTarget.c_str(), asDatasets[0].c_str());
+		countRunStats(COUNTER_EXISTING_TARGETS);
+		nExistingTargets++;
+		}
+	}
+
+//!Reader of a run file spilled by the duplicate targets check
+struct DuplicateRunReader
+	{
+	VSILFILE			*fp;
+	std::vector<char>	abyBuffer;
+	size_t				nPos;
+	size_t				nSize;
+	std::string			sTarget;
+	std::string			sSource;
+
+	bool ReadString(std::string& sValue);
+	bool Next() { return ReadString(sTarget) && ReadString(sSource); }
+	};
+
+//***********************************************************************//
+//!Read the next NUL terminated string of a run file, by buffer refills
+//***********************************************************************//
+bool DuplicateRunReader::ReadString(std::string& sValue)
+	{
+	sValue.clear();
+
+	while ( true )
+		{
+		if ( nPos == nSize )
+			{
+			nSize = ::VSIFReadL(&abyBuffer[0], 1, abyBuffer.size(), fp);
+			nPos = 0;
+			if ( nSize == 0 )
+				{ return false; }
+			}
+
+		const char *pszEnd = (const char *) memchr(&abyBuffer[nPos], '\0', nSize - nPos);
+		size_t nLength = ( pszEnd != NULL ) ? (size_t)( pszEnd - &abyBuffer[nPos] ) : nSize - nPos;
+
+		sValue.append(&abyBuffer[nPos], nLength);
+		nPos += nLength;
+		if ( pszEnd != NULL )
+			{
+			nPos++;
+			return true;
+			}
+		}
+	}
+
+//!Order of the run readers in the merge heap, smallest target on top
+struct DuplicateRunGreater
+	{
+	const std::vector<DuplicateRunReader> *paoReaders;
+
+	bool operator()(size_t i, size_t j) const { return (*paoReaders)[i].sTarget > (*paoReaders)[j].sTarget; }
+	};
+
+//***********************************************************************//
+//!Report the duplicate targets of the whole inventory : from the hash
+//!table, or by a merge of the sorted runs once it was spilled. Give the
+//!counts of the summary, return false if a spilled run was not read
+//***********************************************************************//
+bool DuplicateCheck::Report(int& nDuplicateTargets, int& nDuplicateDatasetsOut, int& nExistingTargetsOut)
+	{
+	if ( !asRunPaths.empty() && !oTargets.empty() )
+		{ Spill(); }
+
+	PhaseTimer oTimer(PHASE_DUPLICATE_CHECK);
+
+	if ( asRunPaths.empty() )
+		{
+		std::vector<const std::string*> apsTargets;
+
+		for( std::unordered_map< std::string, std::vector<std::string> >::const_iterator it = oTargets.begin(); it != oTargets.end(); ++it )
+			{ apsTargets.push_back(&it->first); }
+		std::sort(apsTargets.begin(), apsTargets.end(), compareStringPointers);
+
+		for( size_t i = 0; i < apsTargets.size(); i++ )
+			{ ReportTarget(*apsTargets[i], oTargets[*apsTargets[i]]); }
+		}
+	else
+		{
+		//k-way merge of the runs, one buffer per run
+		std::vector<DuplicateRunReader> aoReaders(asRunPaths.size());
+		DuplicateRunGreater oGreater;
+		std::vector<size_t> anHeap;
+
+		oGreater.paoReaders = &aoReaders;
+		for( size_t i = 0; i < aoReaders.size(); i++ )
+			{
+			aoReaders[i].fp = ::VSIFOpenL(asRunPaths[i].c_str(), "rb");
+			aoReaders[i].abyBuffer.resize(GDAL_RENAME_CHECK_RUN_BUFFER);
+			aoReaders[i].nPos = 0;
+			aoReaders[i].nSize = 0;
+
+			if ( aoReaders[i].fp == NULL )
+				{ bSuccess = false; }
+			else if ( aoReaders[i].Next() )
+				{ anHeap.push_back(i); }
+			}
+		std::make_heap(anHeap.begin(), anHeap.end(), oGreater);
+
+		std::string sTarget;
+		std::vector<std::string> asSources;
+
+		while ( !anHeap.empty() )
+			{
+			std::pop_heap(anHeap.begin(), anHeap.end(), oGreater);
+			DuplicateRunReader& oReader = aoReaders[anHeap.back()];
+
+			if ( oReader.sTarget != sTarget )
+				{
+				if ( !asSources.empty() )
+					{ ReportTarget(sTarget, asSources); }
+				sTarget = oReader.sTarget;
+				asSources.clear();
+				}
+			asSources.push_back(oReader.sSource);
+
+			if ( oReader.Next() )
+				{ std::push_heap(anHeap.begin(), anHeap.end(), oGreater); }
+			else
+				{ anHeap.pop_back(); }
+			}
+
+		if ( !asSources.empty() )
+			{ ReportTarget(sTarget, asSources); }
+
+		for( size_t i = 0; i < aoReaders.size(); i++ )
+			{
+			if ( aoReaders[i].fp != NULL )
+				{ ::VSIFCloseL(aoReaders[i].fp); }
+			::VSIUnlink(asRunPaths[i].c_str());
+			}
+		asRunPaths.clear();
+		}
+
+	oTargets.clear();
+
+	nDuplicateTargets = nDuplicates;
+	nDuplicateDatasetsOut = nDuplicateDatasets;
+	nExistingTargetsOut = nExistingTargets;
+
+	return bSuccess;
+	}
+
+//***********************************************************************//
+//!Check whether or not the given refpoint is good
+//***********************************************************************//
+bool checkRefPoint(const char* CoordRefPoint)
+	{
+	bool Success = false;
+
+	if ( strlen(CoordRefPoint)==2)
+		{
+		if ( EQUAL(CoordRefPoint, "WN" ) || EQUAL(CoordRefPoint, "EN" ) || EQUAL(CoordRefPoint, "NW" ) || EQUAL(CoordRefPoint, "NE" ) ||
+			 EQUAL(CoordRefPoint, "WS" ) || EQUAL(CoordRefPoint, "ES" ) || EQUAL(CoordRefPoint, "SW" ) || EQUAL(CoordRefPoint, "ES" ) )
+			{ Success = true ; }
+		}
+
+	return Success;
+	}
+
+//***********************************************************************//
+//!Append a path quoted for a POSIX shell : single quotes, the single
+//!quotes of the path closed, escaped and reopened ('\'')
+//***********************************************************************//
+static void appendShellQuoted(std::string& sOutput, const std::string& sPath)
+	{
+	sOutput += '\'';
+	for( size_t i = 0; i < sPath.length(); i++ )
+		{
+		if ( sPath[i] == '\'' )
+			{ sOutput += "'\\''"; }
+		else
+			{ sOutput += sPath[i]; }
+		}
+	sOutput += '\'';
+	}
+
+//***********************************************************************//
+//!Append a path quoted for cmd.exe : double quotes (not allowed in the
+//!Windows file names), the % doubled in a batch script
+//***********************************************************************//
+static void appendCmdQuoted(std::string& sOutput, const std::string& sPath, bool bScript)
+	{
+	sOutput += '"';
+	for( size_t i = 0; i < sPath.length(); i++ )
+		{
+		if ( sPath[i] == '%' && bScript )
+			{ sOutput += "%%"; }
+		else
+			{ sOutput += sPath[i]; }
+		}
+	sOutput += '"';
+	}
+
+//***********************************************************************//
+//!Length of the valid UTF-8 sequence starting at nPos (overlong forms
+//!and surrogates rejected), 0 if the byte does not start one
+//***********************************************************************//
+static size_t getUTF8SequenceLength(const std::string& sText, size_t nPos)
+	{
+	unsigned char ch = (unsigned char) sText[nPos];
+	size_t nLength = 0;
+	unsigned char chMin = 0x80, chMax = 0xBF;	//bounds of the second byte
+
+	if ( ch < 0x80 )
+		{ return 1; }
+	else if ( ch >= 0xC2 && ch <= 0xDF )
+		{ nLength = 2; }
+	else if ( ch >= 0xE0 && ch <= 0xEF )
+		{
+		nLength = 3;
+		if ( ch == 0xE0 )
+			{ chMin = 0xA0; }
+		else if ( ch == 0xED )
+			{ chMax = 0x9F; }
+		}
+	else if ( ch >= 0xF0 && ch <= 0xF4 )
+		{
+		nLength = 4;
+		if ( ch == 0xF0 )
+			{ chMin = 0x90; }
+		else if ( ch == 0xF4 )
+			{ chMax = 0x8F; }
+		}
+	else
+		{ return 0; }
+
+	if ( nPos + nLength > sText.length() )
+		{ return 0; }
+
+	for( size_t i = 1; i < nLength; i++ )
+		{
+		unsigned char chNext = (unsigned char) sText[nPos + i];
+
+		if ( chNext < ( i == 1 ? chMin : 0x80 ) || chNext > ( i == 1 ? chMax : 0xBF ) )
+			{ return 0; }
+		}
+
+	return nLength;
+	}
+
+//***********************************************************************//
+//!Append a path as a JSON string, the UTF-8 bytes of the path are kept.
+//!A byte out of a valid UTF-8 sequence is written as a lone surrogate
+//!\udcXX (PEP 383, ie: os.fsencode() in python gives the path back)
+//***********************************************************************//
+static void appendJSONString(std::string& sOutput, const std::string& sPath)
+	{
+	sOutput += '"';
+	for( size_t i = 0; i < sPath.length(); )
+		{
+		unsigned char ch = (unsigned char) sPath[i];
+		size_t nLength = getUTF8SequenceLength(sPath, i);
+
+		if ( nLength == 0 )
+			{ sOutput += CPLSPrintf("\\udc%02x", ch); nLength = 1; }
+		else if ( ch == '"' || ch == '\\' )
+			{ sOutput += '\\'; sOutput += (char) ch; }
+		else if ( ch < 0x20 || ch == 0x7F )
+			{ sOutput += CPLSPrintf("\\u%04x", ch); }
+		else
+			{ sOutput.append(sPath, i, nLength); }
+
+		i += nLength;
+		}
+	sOutput += '"';
+	}
+
+//***********************************************************************//
+//!Append the command of a rename in one of the --output-console formats,
+//!the "move" of the console for an unknown one
+//***********************************************************************//
+static void appendRenameCommand(std::string& sOutput, const char* pszFormat, const std::string& sSourcePath, const std::string& sTargetPath)
+	{
+	if ( EQUAL(pszFormat, "unix") || EQUAL(pszFormat, "sh") )
+		{
+		//mv overwrites the target, the script stops instead
+		if ( EQUAL(pszFormat, "sh") )
+			{
+			sOutput += "[ ! -e ";
+			appendShellQuoted(sOutput, sTargetPath);
+			sOutput += " ] && [ ! -L ";
+			appendShellQuoted(sOutput, sTargetPath);
+			sOutput += " ] || { echo \"already exists:\" ";
+			appendShellQuoted(sOutput, sTargetPath);
+			sOutput += " >&2; exit 1; }\n";
+			}
+
+		sOutput += "mv -- ";
+		appendShellQuoted(sOutput, sSourcePath);
+		sOutput += ' ';
+		appendShellQuoted(sOutput, sTargetPath);
+		sOutput += '\n';
+		}
+	else if ( EQUAL(pszFormat, "nul") )
+		{
+		sOutput.append(sSourcePath.c_str(), sSourcePath.length() + 1);
+		sOutput.append(sTargetPath.c_str(), sTargetPath.length() + 1);
+		}
+	else if ( EQUAL(pszFormat, "jsonl") )
+		{
+		sOutput += "{\"source\":";
+		appendJSONString(sOutput, sSourcePath);
+		sOutput += ",\"target\":";
+		appendJSONString(sOutput, sTargetPath);
+		sOutput += "}\n";
+		}
+	else
+		{
+		bool bScript = EQUAL(pszFormat, "cmd");
+
+		//move /-Y asks before overwriting, the script stops instead
+		if ( bScript )
+			{
+			sOutput += "if exist ";
+			appendCmdQuoted(sOutput, sTargetPath, bScript);
+			sOutput += " (echo already exists: ";
+			appendCmdQuoted(sOutput, sTargetPath, bScript);
+			sOutput += " 1>&2 & exit /b 1)\n";
+			}
+
+		sOutput += "move /-Y ";
+		appendCmdQuoted(sOutput, sSourcePath, bScript);
+		sOutput += ' ';
+		appendCmdQuoted(sOutput, sTargetPath, bScript);
+		sOutput += bScript ? " >nul || exit /b 1\n" : "\n";
+		}
+	}
+
+//***********************************************************************//
+//!format the rename command line for output in the console
+//***********************************************************************//
+std::string formatRenameCmdLine(const char* pszSystemType, const char* pszSourceName, const char* pszNewName)
+	{
+	std::string sCommandLine;
+
+	appendRenameCommand(sCommandLine, pszSystemType, pszSourceName, pszNewName);
+
+	return sCommandLine;
+	}
+
+//***********************************************************************//
+//!Renaming options default values
+//***********************************************************************//
+RenameOptions::RenameOptions()
+	{
+	pszCoordRefPoint = "WN"; // any Easting/Northing pair combination in the following list N, E, S, W
+	pszCoordPadding = true;
+	pszCoordLenght = "7";
+	pszCoordDecLenght = "3";
+	pszCoordType = ""; //"reel"
+	pszCoordSignType = "std"; // "std , force or geo"
+	pszCoordSep = "_";
+	pszPrefix = "";
+	pszSuffix = "";
+	pszPrintf= ""; // printf syntax for the whole renaming string ex: "Tile_%.4d_%.4d_SRS", checked against the coordinates type
+	pszNameTemplate = ""; // ex: "{prefix}{x:07d}{sep}{y:07d}"
+	pszOutputConsole = "";	//"win", "unix", "sh", "cmd", "nul" or "jsonl"
+	bFastGeoRef = true;
+	bPlanRenames = false;
+	poGeoRefCache = NULL;
+	poTileIndex = NULL;
+	poNameTemplate = NULL;
+	pszTargetSRS = NULL;
+	poTileGrid = NULL;
+	pszOffGridSuffix = "_offgrid";
+	poDrivers = NULL;
+	pszOutputDir = NULL;
+	poCommandWriter = NULL;
+	nTransferThreads = 4;
+	poDuplicateCheck = NULL;
+	}
+
+//***********************************************************************//
+//!WorkQueue constructor, nMaxItems is the number of queued items above
+//!which Push() waits for the consumers
+//***********************************************************************//
+template <class T> WorkQueue<T>::WorkQueue(size_t nMaxItemsIn)
+	{
+	hMutex = ::CPLCreateMutex();
+	::CPLReleaseMutex(hMutex);
+	hCondNotEmpty = ::CPLCreateCond();
+	hCondNotFull = ::CPLCreateCond();
+	nMaxItems = nMaxItemsIn;
+	bClosed = false;
+	}
+
+template <class T> WorkQueue<T>::~WorkQueue()
+	{
+	::CPLDestroyCond(hCondNotEmpty);
+	::CPLDestroyCond(hCondNotFull);
+	::CPLDestroyMutex(hMutex);
+	}
+
+//***********************************************************************//
+//!Add an item at the end of the queue, wait while the queue is full
+//***********************************************************************//
+template <class T> void WorkQueue<T>::Push(const T& oItem)
+	{
+	::CPLAcquireMutex(hMutex, 1000.0);
+
+	while ( oItems.size() >= nMaxItems && !bClosed )
+		{ ::CPLCondWait(hCondNotFull, hMutex); }
+
+	oItems.push_back(oItem);
+	::CPLCondSignal(hCondNotEmpty);
+
+	::CPLReleaseMutex(hMutex);
+	}
+
+//***********************************************************************//
+//!Get the first item of the queue, wait while the queue is empty. Return
+//!false once the queue is closed and all its items have been popped
+//***********************************************************************//
+template <class T> bool WorkQueue<T>::Pop(T& oItem)
+	{
+	bool Success = false;
+
+	::CPLAcquireMutex(hMutex, 1000.0);
+
+	while ( oItems.empty() && !bClosed )
+		{ ::CPLCondWait(hCondNotEmpty, hMutex); }
+
+	if ( !oItems.empty() )
+		{
+		oItem = oItems.front();
+		oItems.pop_front();
+		::CPLCondSignal(hCondNotFull);
+		Success = true;
+		}
+
+	::CPLReleaseMutex(hMutex);
+
+	return Success;
+	}
+
+//***********************************************************************//
+//!Get the first item of the queue if there is one, without waiting
+//***********************************************************************//
+template <class T> bool WorkQueue<T>::TryPop(T& oItem)
+	{
+	bool Success = false;
+
+	::CPLAcquireMutex(hMutex, 1000.0);
+
+	if ( !oItems.empty() )
+		{
+		oItem = oItems.front();
+		oItems.pop_front();
+		::CPLCondSignal(hCondNotFull);
+		Success = true;
+		}
+
+	::CPLReleaseMutex(hMutex);
+
+	return Success;
+	}
+
+//***********************************************************************//
+//!No more items will be pushed, wake up all the waiting consumers
+//***********************************************************************//
+template <class T> void WorkQueue<T>::Close()
+	{
+	::CPLAcquireMutex(hMutex, 1000.0);
+	bClosed = true;
+	::CPLCondBroadcast(hCondNotEmpty);
+	::CPLCondBroadcast(hCondNotFull);
+	::CPLReleaseMutex(hMutex);
+	}
+
+//***********************************************************************//
+//!Writer of the --output-console commands, the output is set by Open()
+//***********************************************************************//
+CommandWriter::CommandWriter()
+	{
+	fp = NULL;
+	hMutex = NULL;
+	bSuccess = true;
+	}
+
+CommandWriter::~CommandWriter()
+	{
+	Flush();
+	if ( hMutex != NULL )
+		{ ::CPLDestroyMutex(hMutex); }
+	}
+
+//***********************************************************************//
+//!Check the name of an --output-console format
+//***********************************************************************//
+bool CommandWriter::IsFormat(const char* pszFormat)
+	{
+	return EQUAL(pszFormat, "unix") || EQUAL(pszFormat, "win") || EQUAL(pszFormat, "sh") ||
+		   EQUAL(pszFormat, "cmd") || EQUAL(pszFormat, "nul") || EQUAL(pszFormat, "jsonl");
+	}
+
+//***********************************************************************//
+//!Start the commands of a format written to fpOutput (NULL to discard
+//!them), the header of the scripts is written once per format
+//***********************************************************************//
+bool CommandWriter::Open(const char* pszFormat, FILE* fpOutput)
+	{
+	Flush();
+
+	CPLMutexHolderD(&hMutex);
+	bool bNewFormat = !EQUAL(sFormat.c_str(), pszFormat);
+
+	sFormat = pszFormat;
+	fp = fpOutput;
+	bSuccess = true;
+	sBuffer.reserve(GDAL_RENAME_COMMAND_BUFFER + 4096);
+
+	if ( bNewFormat )
+		{
+		oDirectories.clear();
+		if ( EQUAL(pszFormat, "sh") )
+			{ sBuffer += "#!/bin/sh\n# renames of gdal_rename\nset -e\n"; }
+		else if ( EQUAL(pszFormat, "cmd") )
+			{ sBuffer += "@echo off\nrem renames of gdal_rename\n"; }
+		}
+
+	return IsFormat(pszFormat);
+	}
+
+//***********************************************************************//
+//!Append the commands of a group of renames (in their order), the
+//!scripts create the target directories out of the source ones first.
+//!The buffer is written once full
+//***********************************************************************//
+void CommandWriter::Write(const std::vector<RenameOperation>& aoRenames)
+	{
+	CPLMutexHolderD(&hMutex);
+	bool bScript = EQUAL(sFormat.c_str(), "sh") || EQUAL(sFormat.c_str(), "cmd");
+
+	for( size_t i = 0; i < aoRenames.size(); i++ )
+		{
+		if ( bScript )
+			{
+			std::string sDirectory = ::CPLGetPath(aoRenames[i].sTargetPath.c_str());
+			std::string sSourceDirectory = ::CPLGetPath(aoRenames[i].sSourcePath.c_str());
+
+			//a relative source without directory is in the current one
+			if ( sSourceDirectory.empty() )
+				{ sSourceDirectory = "."; }
+
+			if ( !sDirectory.empty() && sDirectory != sSourceDirectory &&
+				 oDirectories.insert(sDirectory).second )
+				{
+				if ( EQUAL(sFormat.c_str(), "sh") )
+					{
+					sBuffer += "mkdir -p -- ";
+					appendShellQuoted(sBuffer, sDirectory);
+					sBuffer += '\n';
+					}
+				else
+					{
+					sBuffer += "if not exist ";
+					appendCmdQuoted(sBuffer, sDirectory + "\\", true);
+					sBuffer += " mkdir ";
+					appendCmdQuoted(sBuffer, sDirectory, true);
+					sBuffer += " || exit /b 1\n";
+					}
+				}
+			}
+
+		appendRenameCommand(sBuffer, sFormat.c_str(), aoRenames[i].sSourcePath, aoRenames[i].sTargetPath);
+
+		if ( sBuffer.length() >= GDAL_RENAME_COMMAND_BUFFER )
+			{ WriteBuffer(); }
+		}
+	}
+
+//***********************************************************************//
+//!Write the buffered commands, false once a write failed (ie: closed pipe)
+//***********************************************************************//
+bool CommandWriter::Flush()
+	{
+	CPLMutexHolderD(&hMutex);
+
+	return WriteBuffer() && ( fp == NULL || fflush(fp) == 0 );
+	}
+
+//***********************************************************************//
+//!Write the buffer in one block, called with the mutex held. After a
+//!failure the commands are dropped, the error reported once
+//***********************************************************************//
+bool CommandWriter::WriteBuffer()
+	{
+	if ( fp != NULL && bSuccess && !sBuffer.empty() &&
+		 fwrite(sBuffer.data(), 1, sBuffer.length(), fp) != sBuffer.length() )
+		{
+		::CPLError(CE_Failure, CPLE_FileIO, "Failed to write the commands : %s", strerror(errno));
+		bSuccess = false;
+		}
+
+	sBuffer.clear();
+	return bSuccess;
+	}
+
+//***********************************************************************//
+//!Transformations to the target SRS, its axis order is forced to the
+//!easting/northing one (GDAL 3 follows the EPSG axis order otherwise)
+//***********************************************************************//
+ReprojectionCache::ReprojectionCache(const char* pszTargetSRS)
+	{
+	hTargetSRS = ::OSRNewSpatialReference(NULL);
+	::OSRSetFromUserInput(hTargetSRS, pszTargetSRS); //checked by main()
+#if GDAL_VERSION_NUM >= 3000000
+	::OSRSetAxisMappingStrategy(hTargetSRS, OAMS_TRADITIONAL_GIS_ORDER);
+#endif
+	}
+
+ReprojectionCache::~ReprojectionCache()
+	{
+	std::map<std::string, OGRCoordinateTransformationH>::iterator it;
+
+	for( it = oTransforms.begin(); it != oTransforms.end(); ++it )
+		{
+		if ( it->second != NULL )
+			{ ::OCTDestroyCoordinateTransformation(it->second); }
+		}
+
+	::OSRDestroySpatialReference(hTargetSRS);
+	}
+
+//***********************************************************************//
+//!Get the transformation from a source SRS (EPSG code, WKT or .prj file
+//!content) to the target SRS, created on the first use. NULL if the
+//!source SRS is not recognized or can't be transformed
+//***********************************************************************//
+OGRCoordinateTransformationH ReprojectionCache::Get(const std::string& sSourceSRS)
+	{
+	std::map<std::string, OGRCoordinateTransformationH>::iterator it = oTransforms.find(sSourceSRS);
+
+	if ( it != oTransforms.end() )
+		{ return it->second; }
+
+	OGRCoordinateTransformationH hTransform = NULL;
+	OGRSpatialReferenceH hSourceSRS = ::OSRNewSpatialReference(NULL);
+
+	if ( ::OSRSetFromUserInput(hSourceSRS, sSourceSRS.c_str()) != OGRERR_NONE )
+		{ ::CPLError(CE_Failure, CPLE_AppDefined, "Unrecognized SRS \"%.80s\"", sSourceSRS.c_str()); }
+	else
+		{
+#if GDAL_VERSION_NUM >= 3000000
+		::OSRSetAxisMappingStrategy(hSourceSRS, OAMS_TRADITIONAL_GIS_ORDER);
+#endif
+		hTransform = ::OCTNewCoordinateTransformation(hSourceSRS, hTargetSRS);
+
+		if ( hTransform == NULL )
+			{ ::CPLError(CE_Failure, CPLE_AppDefined, "No transformation from the SRS \"%.80s\" to the target SRS", sSourceSRS.c_str()); }
+		else
+			{ countRunStats(COUNTER_TRANSFORMS); }
+		}
+
+	//the transformation keeps its own copy
+	::OSRDestroySpatialReference(hSourceSRS);
+	oTransforms[sSourceSRS] = hTransform;
+
+	return hTransform;
+	}
+
+//***********************************************************************//
+//!Compute the new file names of a group of datasets : corners of the
+//!whole group, transformed to the target SRS with one call if poCache,
+//!then rendered. A point out of the domain of the transformation only
+//!fails its own dataset
+//***********************************************************************//
+void renderNameGroup(NameGroup& oGroup, const std::string& sSourceSRS, ReprojectionCache* poCache, const RenameOptions& oOptions)
+	{
+	int nTiles = (int) oGroup.aoJobs.size();
+	std::vector<double> adfCoordsX, adfCoordsY;
+	std::vector<int> abSuccess(nTiles, TRUE);
+	std::vector<std::string> asNames;
+	OGRCoordinateTransformationH hTransform = NULL;
+
+	if ( nTiles == 0 )
+		{ return; }
+
+	oOptions.poNameTemplate->GetCoordsBatch(oGroup.oExtents, adfCoordsX, adfCoordsY);
+
+	//the names are rendered by the rename stage once the grid is inferred
+	if ( oOptions.poTileGrid != NULL && oOptions.poTileGrid->bInfer )
+		{
+		for( int i = 0; i < nTiles; i++ )
+			{
+			RenameJob& oJob = oGroup.aoJobs[i];
+
+			oJob.bSuccess = true;
+			oJob.sNewFileName.clear();
+			oJob.dCoordX = adfCoordsX[i];
+			oJob.dCoordY = adfCoordsY[i];
+			oJob.dTileSizeX = fabs(oGroup.oExtents.adfRasterSizeX[i] * oGroup.oExtents.adfPixelSizeX[i]);
+			oJob.dTileSizeY = fabs(oGroup.oExtents.adfRasterSizeY[i] * oGroup.oExtents.adfPixelSizeY[i]);
+			}
+
+		return;
+		}
+
+	if ( poCache != NULL )
+		{
+		hTransform = sSourceSRS.empty() ? NULL : poCache->Get(sSourceSRS);
+		std::fill(abSuccess.begin(), abSuccess.end(), FALSE);
+
+		if ( hTransform != NULL )
+			{
+			PhaseTimer oTimer(PHASE_REPROJECT);
+			countRunStats(COUNTER_REPROJECT_CALLS);
+			::OCTTransformEx(hTransform, nTiles, &adfCoordsX[0], &adfCoordsY[0], NULL, &abSuccess[0]);
+			}
+
+		//no name rendered from the coordinates not transformed
+		for( int i = 0; i < nTiles; i++ )
+			{
+			if ( !abSuccess[i] )
+				{ adfCoordsX[i] = adfCoordsY[i] = 0.0; }
+			}
+		}
+
+		{
+		PhaseTimer oTimer(PHASE_NAME_FORMAT);
+		oOptions.poNameTemplate->RenderBatch(adfCoordsX, adfCoordsY, asNames);
+		}
+
+	for( int i = 0; i < nTiles; i++ )
+		{
+		RenameJob& oJob = oGroup.aoJobs[i];
+
+		oJob.bSuccess = ( abSuccess[i] != FALSE );
+
+		if ( oJob.bSuccess )
+			{
+			oJob.sNewFileName.swap(asNames[i]);
+			reportOffGridDataset(*oOptions.poNameTemplate, oJob.sFilePath, adfCoordsX[i], adfCoordsY[i]);
+			continue;
+			}
+
+		oJob.sNewFileName.clear();
+		if ( sSourceSRS.empty() )
+			{
+			countRunStats(COUNTER_FAILED_NO_SRS);
+			::CPLError(CE_Failure, CPLE_AppDefined, "No SRS found in the file \"%s\"", oJob.sFilePath.c_str());
+			continue;
+			}
+
+		countRunStats(COUNTER_FAILED_REPROJECTION);
+		if ( hTransform != NULL )
+			{ ::CPLError(CE_Failure, CPLE_AppDefined, "The coordinates of the file \"%s\" can't be transformed to the target SRS", oJob.sFilePath.c_str()); }
+		}
+	}
+
+//***********************************************************************//
+//!Infer the tiles grid of a whole batch (gathered by the rename stage)
+//!then render the names of its datasets from the reference points and
+//!tiles sizes kept by the workers
+//***********************************************************************//
+void renderGridNames(std::vector<RenameJob>& aoJobs, const RenameOptions& oOptions)
+	{
+	TileGrid& oGrid = *oOptions.poTileGrid;
+	size_t nJobs = 0;
+
+	for( size_t i = 0; i < aoJobs.size(); i++ )
+		{
+		if ( aoJobs[i].bSuccess )
+			{ nJobs++; }
+		}
+
+	if ( nJobs == 0 )
+		{ return; }
+
+	if ( !inferTileGrid(aoJobs, oOptions.poNameTemplate->HasRowsNorthward(), oGrid) )
+		{
+		::CPLError(CE_Failure, CPLE_AppDefined, "The tiles grid can't be inferred from the datasets");
+		for( size_t i = 0; i < aoJobs.size(); i++ )
+			{ aoJobs[i].bSuccess = false; }
+		return;
+		}
+
+	::fprintf(stderr, "Tile grid inferred : origin %.15g,%.15g tiles size %.15g,%.15g\n",
+			  oGrid.dOriginX, oGrid.dOriginY, oGrid.dTileSizeX, oGrid.dTileSizeY);
+
+	for( size_t i = 0; i < aoJobs.size(); i++ )
+		{
+		RenameJob& oJob = aoJobs[i];
+
+		if ( !oJob.bSuccess )
+			{ continue; }
+
+			{
+			PhaseTimer oTimer(PHASE_NAME_FORMAT);
+			oJob.sNewFileName.clear();
+			oOptions.poNameTemplate->RenderCoords(oJob.dCoordX, oJob.dCoordY, oJob.sNewFileName);
+			}
+
+		reportOffGridDataset(*oOptions.poNameTemplate, oJob.sFilePath, oJob.dCoordX, oJob.dCoordY);
+		}
+	}
+
+//***********************************************************************//
+//!Whether a dataset has a sidecar file its georeferencing may come from
+//!(world file, MapInfo .tab, ER Mapper header or PAM .aux.xml)
+//***********************************************************************//
+static bool hasGeoRefSidecar(const char* pszFilePath, SiblingIndex& oSiblingIndex)
+	{
+	std::string sExt = ::CPLGetExtension(pszFilePath);
+	std::string sWorldFileExt = getWorldFileExt(pszFilePath);
+	std::string sLongWorldFileExt = sExt + "w";
+	const char *apszSidecarExts[5] = { sWorldFileExt.c_str(), sLongWorldFileExt.c_str(), "wld", "tab", "ers" };
+	std::string sSiblingPath;
+
+	for( int i = 0; i < 5; i++ )
+		{
+		if ( !EQUAL(sExt.c_str(), apszSidecarExts[i]) && oSiblingIndex.FindSibling(pszFilePath, apszSidecarExts[i], sSiblingPath) )
+			{ return true; }
+		}
+
+	return oSiblingIndex.Exists( std::string(pszFilePath) + ".aux.xml" );
+	}
+
+//***********************************************************************//
+//!Read the georeferencing of a dataset from the georeferencing cache or
+//!from the dataset. The cache holds no SRS, it is not used if psSRS
+//***********************************************************************//
+bool readDatasetGeoRef(const char* pszFilePath, const RenameOptions& oOptions, SiblingIndex& oSiblingIndex, DatasetGeoRef& oGeoRef, std::string* psSRS)
+	{
+	GeoRefCacheRecord oCacheRecord;
+	GeoRefCache *poGeoRefCache = psSRS == NULL ? oOptions.poGeoRefCache : NULL;
+	bool bCached = false;
+
+	countRunStats(COUNTER_DATASETS);
+
+	//the cache records only check the dataset file, a sidecar can be edited
+	if ( poGeoRefCache != NULL && hasGeoRefSidecar(pszFilePath, oSiblingIndex) )
+		{ poGeoRefCache = NULL; }
+
+	if ( poGeoRefCache != NULL )
+		{
+		PhaseTimer oTimer(PHASE_CACHE_LOOKUP);
+		bCached = poGeoRefCache->Lookup(pszFilePath, oCacheRecord, oGeoRef);
+		}
+
+	if ( bCached )
+		{
+		countRunStats(COUNTER_CACHE_HITS);
+		return true;
+		}
+
+	char **papszAllowedDrivers = oOptions.poDrivers != NULL ? oOptions.poDrivers->GetDrivers(pszFilePath) : NULL;
+
+	if ( !readGeoRef(pszFilePath, oGeoRef, oOptions.bFastGeoRef, papszAllowedDrivers, oSiblingIndex, psSRS) )
+		{ return false; }
+
+	if ( poGeoRefCache != NULL )
+		{ poGeoRefCache->Add(pszFilePath, oCacheRecord, oGeoRef); }
+
+	return true;
+	}
+
+//***********************************************************************//
+//!Open a dataset and compute its new file name (without directory nor
+//!extension)
+//***********************************************************************//
+bool computeNewFileName(const char* pszFilePath, const RenameOptions& oOptions, SiblingIndex& oSiblingIndex, std::string& sNewFileName)
+	{
+	DatasetGeoRef oGeoRef;
+
+	//a group of one dataset, the batch mode groups the datasets by source SRS
+	if ( oOptions.pszTargetSRS != NULL )
+		{
+		ReprojectionCache oReprojectionCache(oOptions.pszTargetSRS);
+		NameGroup oGroup;
+		std::string sSRS;
+
+		if ( !readDatasetGeoRef(pszFilePath, oOptions, oSiblingIndex, oGeoRef, &sSRS) )
+			{ return false; }
+
+		oGroup.aoJobs.resize(1);
+		oGroup.aoJobs[0].sFilePath = pszFilePath;
+		oGroup.oExtents.Add(oGeoRef);
+
+		renderNameGroup(oGroup, sSRS, &oReprojectionCache, oOptions);
+
+		sNewFileName = oGroup.aoJobs[0].sNewFileName;
+		return oGroup.aoJobs[0].bSuccess;
+		}
+
+	if ( !readDatasetGeoRef(pszFilePath, oOptions, oSiblingIndex, oGeoRef, NULL) )
+		{ return false; }
+
+	double dCoordX, dCoordY;
+
+		{
+		PhaseTimer oTimer(PHASE_NAME_FORMAT);
+		sNewFileName.clear();
+		oOptions.poNameTemplate->GetCoords(oGeoRef, dCoordX, dCoordY);
+		oOptions.poNameTemplate->RenderCoords(dCoordX, dCoordY, sNewFileName);
+		}
+
+	reportOffGridDataset(*oOptions.poNameTemplate, pszFilePath, dCoordX, dCoordY);
+	return true;
+	}
+
+//***********************************************************************//
+//!Path of a renamed file : its new name and the given extension, in the
+//!output directory (--output-dir) or in the directory of the file
+//***********************************************************************//
+std::string getRenamedPath(const std::string& sFilePath, const std::string& sNewFileName, const std::string& sExt, const char* pszOutputDir)
+	{
+	std::string sDirName = pszOutputDir != NULL ? pszOutputDir : ::CPLGetDirname(sFilePath.c_str());
+
+	return sDirName + getDirSep(sDirName) + sNewFileName + "." + sExt;
+	}
+
+//***********************************************************************//
+//!List the renames of a dataset and of its sibling files (only the
+//!siblings which exist, keeping their extension case)
+//***********************************************************************//
+void listRenameOperations(const char* pszFilePath, const std::string& sNewFileName, const char* pszOutputDir, size_t nJob,
+						  SiblingIndex& oSiblingIndex, std::vector<RenameOperation>& aoOps)
+	{
+	std::string sExt		= ::CPLGetExtension(pszFilePath);
+
+	RenameOperation oOp;
+	oOp.sSourcePath = pszFilePath;
+	oOp.sTargetPath = getRenamedPath(pszFilePath, sNewFileName, sExt, pszOutputDir);
+	oOp.nJob = nJob;
+	oOp.bMainFile = true;
+	oOp.nResult = RENAME_NOT_DONE;
+	aoOps.push_back(oOp);
+
+	std::vector<std::string> SiblingFilesExts = getSiblingFilesExt(pszFilePath);
+	std::vector<std::string>::iterator it = SiblingFilesExts.begin();
+
+	while ( it != SiblingFilesExts.end() )
+		{
+		std::string sCurSiblingFileName;
+
+		if ( oSiblingIndex.FindSibling(pszFilePath, (*it).c_str(), sCurSiblingFileName) )
+			{
+			oOp.sSourcePath = sCurSiblingFileName;
+			oOp.sTargetPath = getRenamedPath(pszFilePath, sNewFileName, ::CPLGetExtension(sCurSiblingFileName.c_str()), pszOutputDir);
+			oOp.bMainFile = false;
+			aoOps.push_back(oOp);
+			}
+
+		++it;
+		}
+	}
+
+//***********************************************************************//
+//!Perform a list of renames (submitted in batches by the io_uring
+//!backend, the renames not done this way go through renameFileNoOverWrite).
+//!Return false if a dataset (main file) rename failed
+//***********************************************************************//
+bool executeRenameOperations(std::vector<RenameOperation>& aoOps, SiblingIndex& oSiblingIndex)
+	{
+	bool Success = true;
+
+	renameNoReplaceBatch(aoOps, oSiblingIndex);
+
+	for( size_t i = 0; i < aoOps.size(); i++ )
+		{
+		RenameOperation& oOp = aoOps[i];
+
+		if ( oOp.nResult == RENAME_DONE )
+			{ oSiblingIndex.Renamed(oOp.sSourcePath, oOp.sTargetPath); }
+		else
+			{ oOp.nResult = renameFileNoOverWrite(oOp.sSourcePath, oOp.sTargetPath, oSiblingIndex) ? RENAME_DONE : RENAME_FAILED; }
+
+		if ( oOp.nResult != RENAME_DONE && oOp.bMainFile )
+			{
+			::CPLError(CE_Failure, CPLE_FileIO, "Unable to rename the file \"%s\", check the file is not locked or still exists", oOp.sSourcePath.c_str());
+			Success = false;
+			}
+		}
+
+	return Success;
+	}
+
+//!Datasets moved across file systems, copied by a pool of threads
+struct TransferContext
+	{
+	const std::vector<RenameOperation>			*paoOps;
+	const std::vector< std::vector<size_t> >	*paanGroups;	//operations of each dataset moved
+	std::vector<int>							*pabCopied;		//all the files of the dataset copied
+	volatile int								nNextGroup;
+	};
+
+//***********************************************************************//
+//!Copy thread of the moves across file systems : all the files of a
+//!dataset are copied next to their targets, or none of them
+//***********************************************************************//
+static void transferWorker(void* pData)
+	{
+	TransferContext *poContext = (TransferContext *) pData;
+	int iGroup;
+
+	while ( ( iGroup = CPLAtomicInc(&poContext->nNextGroup) - 1 ) < (int) poContext->paanGroups->size() )
+		{
+		const std::vector<size_t>& anOps = (*poContext->paanGroups)[iGroup];
+		size_t nCopied = 0;
+
+		while ( nCopied < anOps.size() )
+			{
+			const RenameOperation& oOp = (*poContext->paoOps)[anOps[nCopied]];
+
+			if ( !copyFileForMove(oOp.sSourcePath, getTransferPath(oOp.sTargetPath)) )
+				{ break; }
+			nCopied++;
+			}
+
+		if ( nCopied < anOps.size() )
+			{
+			countRunStats(COUNTER_FAILED_TRANSFER);
+			for( size_t i = 0; i < nCopied; i++ )
+				{ ::VSIUnlink( getTransferPath((*poContext->paoOps)[anOps[i]].sTargetPath).c_str() ); }
+			}
+
+		(*poContext->pabCopied)[iGroup] = ( nCopied == anOps.size() );
+		}
+	}
+
+//***********************************************************************//
+//!Whether two directories are on different file systems (no rename
+//!possible between them)
+//***********************************************************************//
+static bool isOtherDevice(const std::string& sDirName1, const std::string& sDirName2)
+	{
+	::VSIStatBufL psStatBuf1, psStatBuf2;
+
+	if ( STARTS_WITH(sDirName1.c_str(), "/vsi") || STARTS_WITH(sDirName2.c_str(), "/vsi") ||
+		 ::VSIStatL(sDirName1.c_str(), &psStatBuf1) != 0 || ::VSIStatL(sDirName2.c_str(), &psStatBuf2) != 0 )
+		{ return false; }
+
+	return psStatBuf1.st_dev != psStatBuf2.st_dev;
+	}
+
+//***********************************************************************//
+//!Rename the copy of a file to its target, an existing target is kept
+//!under its backup name (sBackupPath) as the renames in place do
+//***********************************************************************//
+static bool placeTransferredFile(const RenameOperation& oOp, std::string& sBackupPath, SiblingIndex& oSiblingIndex)
+	{
+	std::string sTransferPath = getTransferPath(oOp.sTargetPath);
+	int nError = 0;
+
+	//the target existence is checked by the rename itself, as in renameFileNoOverWrite
+	RenameResult nResult = renameNoReplaceFile(sTransferPath, oOp.sTargetPath, &nError);
+
+	if ( nResult == RENAME_TARGET_EXISTS )
+		{
+		std::string sNewBackupPath = getBackupPath(oOp.sTargetPath);
+
+		if ( fileExists(sNewBackupPath) )
+			{
+			countRunStats(COUNTER_FAILED_TARGET_EXISTS);
+			::CPLError(CE_Failure, CPLE_FileIO, "Unable to move \"%s\" to \"%s\" : both the new name and its backup name already exist",
+					   oOp.sSourcePath.c_str(), oOp.sTargetPath.c_str());
+			return false;
+			}
+
+		if ( poRenameJournal != NULL )
+			{
+			poRenameJournal->Planned(oOp.sTargetPath, sNewBackupPath);
+			poRenameJournal->Sync();
+			}
+
+		if ( renameNoReplace(oOp.sTargetPath, sNewBackupPath) != RENAME_DONE )
+			{
+			countRunStats(COUNTER_FAILED_BACKUP);
+			::CPLError(CE_Failure, CPLE_FileIO, "Unable to back up \"%s\" to \"%s\", \"%s\" not moved",
+					   oOp.sTargetPath.c_str(), sNewBackupPath.c_str(), oOp.sSourcePath.c_str());
+			return false;
+			}
+
+		countRunStats(COUNTER_BACKUPS);
+		oSiblingIndex.Renamed(oOp.sTargetPath, sNewBackupPath);
+		sBackupPath = sNewBackupPath;
+		nResult = renameNoReplaceFile(sTransferPath, oOp.sTargetPath, &nError);
+		}
+
+	if ( nResult != RENAME_DONE )
+		{
+		countRunStats(COUNTER_FAILED_RENAME);
+		::CPLError(CE_Failure, CPLE_FileIO, "Unable to move \"%s\" to \"%s\"", oOp.sSourcePath.c_str(), oOp.sTargetPath.c_str());
+		return false;
+		}
+
+	return true;
+	}
+
+//***********************************************************************//
+//!Perform a list of renames to the output directory (--output-dir). The
+//!datasets on the file system of the output directory are renamed, the
+//!others are moved as a whole : all their files copied by nThreads
+//!threads (reflink or in kernel copy, synced), renamed to their targets,
+//!the directory synced and only then the sources unlinked. A dataset
+//!not fully copied or renamed is left untouched in its directory
+//***********************************************************************//
+void executeTransferOperations(std::vector<RenameOperation>& aoOps, SiblingIndex& oSiblingIndex, int nThreads)
+	{
+	std::map<std::string, bool> oOtherDevices;	//source directory -> on another file system than its target
+	std::map<size_t, size_t> oGroupByJob;
+	std::vector< std::vector<size_t> > aanGroups;
+	std::vector<RenameOperation> aoLocalOps;
+	std::vector<size_t> anLocalOps;
+
+	for( size_t i = 0; i < aoOps.size(); i++ )
+		{
+		const RenameOperation& oOp = aoOps[i];
+		std::string sSourceDir = ::CPLGetDirname(oOp.sSourcePath.c_str());
+		std::map<std::string, bool>::iterator it = oOtherDevices.find(sSourceDir);
+
+		if ( it == oOtherDevices.end() )
+			{ it = oOtherDevices.insert( std::make_pair(sSourceDir, isOtherDevice(sSourceDir, ::CPLGetDirname(oOp.sTargetPath.c_str()))) ).first; }
+
+		if ( !it->second )
+			{
+			anLocalOps.push_back(i);
+			aoLocalOps.push_back(oOp);
+			continue;
+			}
+
+		std::map<size_t, size_t>::iterator itGroup = oGroupByJob.find(oOp.nJob);
+		if ( itGroup == oGroupByJob.end() )
+			{
+			itGroup = oGroupByJob.insert( std::make_pair(oOp.nJob, aanGroups.size()) ).first;
+			aanGroups.push_back( std::vector<size_t>() );
+			}
+		aanGroups[itGroup->second].push_back(i);
+		}
+
+	if ( !aoLocalOps.empty() )
+		{
+		executeRenameOperations(aoLocalOps, oSiblingIndex);
+
+		for( size_t i = 0; i < anLocalOps.size(); i++ )
+			{ aoOps[anLocalOps[i]].nResult = aoLocalOps[i].nResult; }
+		}
+
+	if ( aanGroups.empty() )
+		{ return; }
+
+	//the copies of the datasets in parallel
+	std::vector<int> abCopied(aanGroups.size(), FALSE);
+	TransferContext oContext;
+	oContext.paoOps = &aoOps;
+	oContext.paanGroups = &aanGroups;
+	oContext.pabCopied = &abCopied;
+	oContext.nNextGroup = 0;
+
+	std::vector<CPLJoinableThread*> apoThreads;
+	for( int i = 1; i < std::min(nThreads, (int) aanGroups.size()); i++ )
+		{ apoThreads.push_back( ::CPLCreateJoinableThread(transferWorker, &oContext) ); }
+
+	transferWorker(&oContext);
+
+	for( size_t i = 0; i < apoThreads.size(); i++ )
+		{ ::CPLJoinThread(apoThreads[i]); }
+
+	//then each dataset is renamed into place and its sources removed, in order
+	for( size_t iGroup = 0; iGroup < aanGroups.size(); iGroup++ )
+		{
+		const std::vector<size_t>& anOps = aanGroups[iGroup];
+		std::vector<std::string> asBackupPaths(anOps.size());
+		size_t nPlaced = 0;
+		bool bMoved = ( abCopied[iGroup] != FALSE );
+
+		while ( bMoved && nPlaced < anOps.size() )
+			{
+			bMoved = placeTransferredFile(aoOps[anOps[nPlaced]], asBackupPaths[nPlaced], oSiblingIndex);
+			if ( bMoved )
+				{ nPlaced++; }
+			}
+
+		if ( bMoved )
+			{
+			syncPath(::CPLGetDirname(aoOps[anOps[0]].sTargetPath.c_str()));
+
+			//the dataset stays where it was if its main file can't be removed
+			bMoved = ( ::VSIUnlink(aoOps[anOps[0]].sSourcePath.c_str()) == 0 );
+			if ( !bMoved )
+				{ countRunStats(COUNTER_FAILED_TRANSFER); }
+			}
+
+		if ( !bMoved )
+			{
+			for( size_t i = 0; i < anOps.size(); i++ )
+				{
+				const RenameOperation& oOp = aoOps[anOps[i]];
+
+				if ( i < nPlaced )
+					{
+					::VSIUnlink(oOp.sTargetPath.c_str());
+					if ( !asBackupPaths[i].empty() && renameNoReplace(asBackupPaths[i], oOp.sTargetPath) == RENAME_DONE )
+						{ oSiblingIndex.Renamed(asBackupPaths[i], oOp.sTargetPath); }
+					}
+				else if ( abCopied[iGroup] )
+					{ ::VSIUnlink(getTransferPath(oOp.sTargetPath).c_str()); }
+
+				aoOps[anOps[i]].nResult = RENAME_FAILED;
+				}
+
+			::CPLError(CE_Failure, CPLE_FileIO, "Unable to move the dataset \"%s\" to \"%s\", left in place",
+					   aoOps[anOps[0]].sSourcePath.c_str(), ::CPLGetDirname(aoOps[anOps[0]].sTargetPath.c_str()));
+			continue;
+			}
+
+		for( size_t i = 0; i < anOps.size(); i++ )
+			{
+			RenameOperation& oOp = aoOps[anOps[i]];
+
+			if ( i > 0 && ::VSIUnlink(oOp.sSourcePath.c_str()) != 0 )
+				{
+				countRunStats(COUNTER_FAILED_TRANSFER);
+				::CPLError(CE_Failure, CPLE_FileIO, "Unable to remove \"%s\", copied to \"%s\"", oOp.sSourcePath.c_str(), oOp.sTargetPath.c_str());
+				oOp.nResult = RENAME_FAILED;
+				continue;
+				}
+
+			countRunStats(COUNTER_TRANSFERS);
+			oSiblingIndex.Renamed(oOp.sSourcePath, oOp.sTargetPath);
+			if ( poRenameJournal != NULL )
+				{ poRenameJournal->Done(oOp.sSourcePath, oOp.sTargetPath); }
+			oOp.nResult = RENAME_DONE;
+			}
+		}
+	}
+
+//***********************************************************************//
+//!Build the rename graph of a batch (each file renamed once, a rename
+//!depends on the one moving the file away from its target) and sort it :
+//!the chains (A->B, B->C) are done from their end and the cycles (A->B,
+//!B->A) are kept apart. The renames to the same target are reported and
+//!all the files of their datasets are left untouched
+//***********************************************************************//
+void planRenameOperations(std::vector<RenameOperation>& aoOps, RenamePlan& oPlan)
+	{
+	const size_t NONE = (size_t) -1;
+	std::unordered_map<std::string, size_t> oOpBySource;
+	std::unordered_map<std::string, std::vector<size_t> > oOpsByTarget;
+	std::unordered_set<size_t> oSkippedJobs;
+	std::vector<bool> abPlanned(aoOps.size(), true);
+
+	oPlan.anOrder.clear();
+	oPlan.anFreedBy.assign(aoOps.size(), NONE);
+	oPlan.aanCycles.clear();
+	oPlan.aoDuplicates.clear();
+
+	for( size_t i = 0; i < aoOps.size(); i++ )
+		{
+		std::string sSourceKey = SiblingIndex::GetKey(aoOps[i].sSourcePath);
+		std::unordered_map<std::string, size_t>::iterator it = oOpBySource.find(sSourceKey);
+
+		if ( it == oOpBySource.end() )
+			{ oOpBySource[sSourceKey] = i; }
+		//same dataset listed twice (ie: a file and its directory)
+		else if ( SiblingIndex::GetKey(aoOps[it->second].sTargetPath) == SiblingIndex::GetKey(aoOps[i].sTargetPath) )
+			{
+			oPlan.aoDuplicates.push_back( std::make_pair(i, it->second) );
+			abPlanned[i] = false;
+			continue;
+			}
+		else
+			{
+			::CPLError(CE_Failure, CPLE_AppDefined, "\"%s\" would be renamed to both \"%s\" and \"%s\"",
+					   aoOps[i].sSourcePath.c_str(), aoOps[it->second].sTargetPath.c_str(), aoOps[i].sTargetPath.c_str());
+			oSkippedJobs.insert(aoOps[i].nJob);
+			oSkippedJobs.insert(aoOps[it->second].nJob);
+			}
+
+		oOpsByTarget[SiblingIndex::GetKey(aoOps[i].sTargetPath)].push_back(i);
+		}
+
+	std::unordered_map<std::string, std::vector<size_t> >::iterator itTarget = oOpsByTarget.begin();
+	while ( itTarget != oOpsByTarget.end() )
+		{
+		if ( itTarget->second.size() > 1 )
+			{
+			std::string sSources;
+			for( size_t j = 0; j < itTarget->second.size(); j++ )
+				{
+				sSources += "\n  " + aoOps[itTarget->second[j]].sSourcePath;
+				oSkippedJobs.insert(aoOps[itTarget->second[j]].nJob);
+				}
+
+			::CPLError(CE_Failure, CPLE_AppDefined, "%d files would be renamed to \"%s\", left untouched :%s",
+					   (int) itTarget->second.size(), aoOps[itTarget->second[0]].sTargetPath.c_str(), sSources.c_str());
+			}
+		++itTarget;
+		}
+
+	for( size_t i = 0; i < aoOps.size(); i++ )
+		{
+		if ( !abPlanned[i] )
+			{ continue; }
+
+		if ( oSkippedJobs.count(aoOps[i].nJob) > 0 )
+			{
+			if ( aoOps[i].bMainFile )
+				{ countRunStats(COUNTER_FAILED_TARGET_CONFLICT); }
+			aoOps[i].nResult = RENAME_FAILED;
+			abPlanned[i] = false;
+			}
+		//already named this way
+		else if ( aoOps[i].sSourcePath == aoOps[i].sTargetPath )
+			{
+			aoOps[i].nResult = RENAME_DONE;
+			abPlanned[i] = false;
+			}
+		}
+
+	//rename which must be done first to free the target of each rename
+	std::vector<size_t> anMovedBefore(aoOps.size(), NONE);
+
+	for( size_t i = 0; i < aoOps.size(); i++ )
+		{
+		if ( !abPlanned[i] )
+			{ continue; }
+
+		std::string sTargetKey = SiblingIndex::GetKey(aoOps[i].sTargetPath);
+		std::unordered_map<std::string, size_t>::iterator it = oOpBySource.find(sTargetKey);
+
+		//the same file with another case (case insensitive file systems) is not a dependency
+		if ( it != oOpBySource.end() && it->second != i && abPlanned[it->second] )
+			{
+			anMovedBefore[i] = it->second;
+			oPlan.anFreedBy[i] = it->second;
+			}
+		}
+
+	//sources and targets are unique so each rename has at most one rename
+	//depending on it : the graph is made of chains and cycles
+	std::vector<size_t> anMovedAfter(aoOps.size(), NONE);
+	for( size_t i = 0; i < aoOps.size(); i++ )
+		{
+		if ( anMovedBefore[i] != NONE )
+			{ anMovedAfter[anMovedBefore[i]] = i; }
+		}
+
+	std::vector<bool> abVisited(aoOps.size(), false);
+
+	for( size_t i = 0; i < aoOps.size(); i++ )
+		{
+		if ( !abPlanned[i] || anMovedBefore[i] != NONE )
+			{ continue; }
+
+		for( size_t j = i; j != NONE; j = anMovedAfter[j] )
+			{
+			oPlan.anOrder.push_back(j);
+			abVisited[j] = true;
+			}
+		}
+
+	for( size_t i = 0; i < aoOps.size(); i++ )
+		{
+		if ( !abPlanned[i] || abVisited[i] )
+			{ continue; }
+
+		std::vector<size_t> anCycle;
+		for( size_t j = i; !abVisited[j]; j = anMovedBefore[j] )
+			{
+			anCycle.push_back(j);
+			abVisited[j] = true;
+			}
+
+		oPlan.aanCycles.push_back(anCycle);
+		}
+	}
+
+//***********************************************************************//
+//!Temporary name used to break a cycle of renames, in the same directory
+//***********************************************************************//
+std::string getTemporaryRenamePath(const std::string& sFilePath, SiblingIndex& oSiblingIndex)
+	{
+	std::string sPrefix = std::string(::CPLGetDirname(sFilePath.c_str())) + sDirSep + "~" + ::CPLGetBasename(sFilePath.c_str());
+	std::string sExt = ::CPLGetExtension(sFilePath.c_str());
+	std::string sTmpPath = sPrefix + ".gdal_rename." + sExt;
+
+	for( int i = 1; oSiblingIndex.Exists(sTmpPath); i++ )
+		{ sTmpPath = sPrefix + CPLSPrintf(".gdal_rename%d.", i) + sExt; }
+
+	return sTmpPath;
+	}
+
+//***********************************************************************//
+//!List the renames breaking a cycle with one temporary name, starting at
+//!the nFirst rename of the cycle : the source of the first rename is moved
+//!to the temporary name, then the renames are done backward and the
+//!temporary file is moved to the target of the first rename
+//***********************************************************************//
+void listCycleRenames(const std::vector<RenameOperation>& aoOps, const std::vector<size_t>& anCycle, size_t nFirst,
+					  const std::string& sTmpPath, std::vector<RenameOperation>& aoRenames)
+	{
+	RenameOperation oRename = aoOps[anCycle[nFirst]];
+
+	//the file to move by the first rename is at the source of the cycle (moved there by the exchanges)
+	oRename.sSourcePath = aoOps[anCycle[0]].sSourcePath;
+	oRename.sTargetPath = sTmpPath;
+	aoRenames.push_back(oRename);
+
+	for( size_t j = anCycle.size() - 1; j > nFirst; j-- )
+		{ aoRenames.push_back(aoOps[anCycle[j]]); }
+
+	oRename.sSourcePath = sTmpPath;
+	oRename.sTargetPath = aoOps[anCycle[nFirst]].sTargetPath;
+	aoRenames.push_back(oRename);
+	}
+
+//***********************************************************************//
+//!Perform a cycle of renames (A->B, B->C, C->A). The files are exchanged
+//!with RENAME_EXCHANGE when available (no temporary name at all), else,
+//!or if an exchange fails, the cycle is broken with one temporary name
+//***********************************************************************//
+void executeRenameCycle(std::vector<RenameOperation>& aoOps, const std::vector<size_t>& anCycle, SiblingIndex& oSiblingIndex)
+	{
+	const std::string& sPivotPath = aoOps[anCycle[0]].sSourcePath;
+	size_t nFirst = 0;
+
+	//each exchange puts a file to its target and the file of the next rename at the pivot
+	while ( nFirst + 1 < anCycle.size() && renameExchange(sPivotPath, aoOps[anCycle[nFirst]].sTargetPath) )
+		{ aoOps[anCycle[nFirst++]].nResult = RENAME_DONE; }
+
+	if ( nFirst + 1 == anCycle.size() )
+		{
+		aoOps[anCycle[nFirst]].nResult = RENAME_DONE;
+		return;
+		}
+
+	std::vector<RenameOperation> aoRenames;
+	std::string sTmpPath = getTemporaryRenamePath(sPivotPath, oSiblingIndex);
+	listCycleRenames(aoOps, anCycle, nFirst, sTmpPath, aoRenames);
+
+	if ( poRenameJournal != NULL )
+		{
+		for( size_t j = 0; j < aoRenames.size(); j++ )
+			{ poRenameJournal->Planned(aoRenames[j].sSourcePath, aoRenames[j].sTargetPath); }
+		poRenameJournal->Sync();
+		}
+
+	for( size_t j = 0; j < aoRenames.size(); j++ )
+		{
+		if ( renameNoReplace(aoRenames[j].sSourcePath, aoRenames[j].sTargetPath) != RENAME_DONE )
+			{
+			countRunStats(COUNTER_FAILED_RENAME);
+			::CPLError(CE_Failure, CPLE_FileIO, "Unable to rename \"%s\" to \"%s\"", aoRenames[j].sSourcePath.c_str(), aoRenames[j].sTargetPath.c_str());
+			if ( j > 0 )
+				{ ::CPLError(CE_Failure, CPLE_FileIO, "\"%s\" is left as \"%s\"", aoRenames[0].sSourcePath.c_str(), sTmpPath.c_str()); }
+
+			for( size_t k = nFirst; k < anCycle.size(); k++ )
+				{
+				if ( aoOps[anCycle[k]].nResult != RENAME_DONE )
+					{ aoOps[anCycle[k]].nResult = RENAME_FAILED; }
+				}
+			return;
+			}
+
+		oSiblingIndex.Renamed(aoRenames[j].sSourcePath, aoRenames[j].sTargetPath);
+
+		//the renames of the cycle are done from its end, then the temporary file
+		if ( j > 0 && j + 1 < aoRenames.size() )
+			{ aoOps[anCycle[anCycle.size() - j]].nResult = RENAME_DONE; }
+		}
+
+	aoOps[anCycle[nFirst]].nResult = RENAME_DONE;
+	}
+
+//***********************************************************************//
+//!Perform the renames of a batch in the order computed by the planner.
+//!Return false if a dataset (main file) rename failed
+//***********************************************************************//
+bool executePlannedRenameOperations(std::vector<RenameOperation>& aoOps, const RenamePlan& oPlan, SiblingIndex& oSiblingIndex)
+	{
+	const size_t NONE = (size_t) -1;
+	bool Success = true;
+	std::vector<RenameOperation> aoOrdered;
+	std::vector<bool> abReported(aoOps.size()); //skipped by the planner, already reported
+
+	for( size_t i = 0; i < aoOps.size(); i++ )
+		{ abReported[i] = ( aoOps[i].nResult == RENAME_FAILED ); }
+
+	for( size_t i = 0; i < oPlan.anOrder.size(); i++ )
+		{ aoOrdered.push_back(aoOps[oPlan.anOrder[i]]); }
+
+	renameNoReplaceBatch(aoOrdered, oSiblingIndex);
+
+	for( size_t i = 0; i < oPlan.anOrder.size(); i++ )
+		{
+		RenameOperation& oOp = aoOps[oPlan.anOrder[i]];
+		size_t nFreedBy = oPlan.anFreedBy[oPlan.anOrder[i]];
+
+		oOp.nResult = aoOrdered[i].nResult;
+
+		if ( oOp.nResult == RENAME_DONE )
+			{ oSiblingIndex.Renamed(oOp.sSourcePath, oOp.sTargetPath); }
+		//target not freed, the file which should have been moved is not overwritten
+		else if ( nFreedBy != NONE && aoOps[nFreedBy].nResult != RENAME_DONE )
+			{
+			countRunStats(COUNTER_FAILED_RENAME);
+			::CPLError(CE_Failure, CPLE_FileIO, "Unable to rename \"%s\" to \"%s\" : the file with the new name could not be renamed first",
+					   oOp.sSourcePath.c_str(), oOp.sTargetPath.c_str());
+			oOp.nResult = RENAME_FAILED;
+			}
+		else if ( nFreedBy != NONE )
+			{
+			oOp.nResult = renameNoReplace(oOp.sSourcePath, oOp.sTargetPath) == RENAME_DONE ? RENAME_DONE : RENAME_FAILED;
+			if ( oOp.nResult == RENAME_DONE )
+				{ oSiblingIndex.Renamed(oOp.sSourcePath, oOp.sTargetPath); }
+			else
+				{
+				countRunStats(COUNTER_FAILED_RENAME);
+				::CPLError(CE_Failure, CPLE_FileIO, "Unable to rename \"%s\" to \"%s\"", oOp.sSourcePath.c_str(), oOp.sTargetPath.c_str());
+				}
+			}
+		//end of a chain, the target is either free or a file out of the batch (backuped)
+		else
+			{ oOp.nResult = renameFileNoOverWrite(oOp.sSourcePath, oOp.sTargetPath, oSiblingIndex) ? RENAME_DONE : RENAME_FAILED; }
+		}
+
+	for( size_t i = 0; i < oPlan.aanCycles.size(); i++ )
+		{ executeRenameCycle(aoOps, oPlan.aanCycles[i], oSiblingIndex); }
+
+	for( size_t i = 0; i < oPlan.aoDuplicates.size(); i++ )
+		{ aoOps[oPlan.aoDuplicates[i].first].nResult = aoOps[oPlan.aoDuplicates[i].second].nResult; }
+
+	for( size_t i = 0; i < aoOps.size(); i++ )
+		{
+		if ( aoOps[i].nResult != RENAME_DONE && aoOps[i].bMainFile )
+			{
+			if ( !abReported[i] )
+				{ ::CPLError(CE_Failure, CPLE_FileIO, "Unable to rename the file \"%s\", check the file is not locked or still exists", aoOps[i].sSourcePath.c_str()); }
+			Success = false;
+			}
+		}
+
+	return Success;
+	}
+
+//***********************************************************************//
+//!Rename datasets and their sibling files to their new names (or print
+//!the commands to do it). The jobs whose new name could not be computed
+//!are skipped, bSuccess is set to false for the ones whose rename failed
+//***********************************************************************//
+void applyRenames(std::vector<RenameJob>& aoJobs, const RenameOptions& oOptions, SiblingIndex& oSiblingIndex)
+	{
+	const char *pszOutputConsole = oOptions.pszOutputConsole;
+	std::vector<RenameOperation> aoOps;
+	RenamePlan oPlan;
+
+	for( size_t i = 0; i < aoJobs.size(); i++ )
+		{
+		if ( aoJobs[i].bSuccess )
+			{ listRenameOperations(aoJobs[i].sFilePath.c_str(), aoJobs[i].sNewFileName, oOptions.pszOutputDir, i, oSiblingIndex, aoOps); }
+		}
+
+	if ( oOptions.bPlanRenames )
+		{ planRenameOperations(aoOps, oPlan); }
+
+	if ( !EQUAL(pszOutputConsole, "") )
+		{
+		std::vector<RenameOperation> aoRenames;
+
+		if ( oOptions.bPlanRenames )
+			{
+			for( size_t i = 0; i < oPlan.anOrder.size(); i++ )
+				{ aoRenames.push_back(aoOps[oPlan.anOrder[i]]); }
+
+			for( size_t i = 0; i < oPlan.aanCycles.size(); i++ )
+				{
+				std::string sTmpPath = getTemporaryRenamePath(aoOps[oPlan.aanCycles[i][0]].sSourcePath, oSiblingIndex);
+				listCycleRenames(aoOps, oPlan.aanCycles[i], 0, sTmpPath, aoRenames);
+				}
+			}
+		else
+			{ aoRenames = aoOps; }
+
+		//without the writer of the run, the commands of the batch are written at once
+		CommandWriter oBatchWriter;
+		CommandWriter *poWriter = oOptions.poCommandWriter;
+
+		if ( poWriter == NULL )
+			{
+			oBatchWriter.Open(pszOutputConsole, stdout);
+			poWriter = &oBatchWriter;
+			}
+		poWriter->Write(aoRenames);
+
+		//datasets skipped by the planner
+		for( size_t i = 0; i < aoOps.size(); i++ )
+			{
+			if ( aoOps[i].bMainFile && aoOps[i].nResult == RENAME_FAILED )
+				{ aoJobs[aoOps[i].nJob].bSuccess = false; }
+			}
+
+		return;
+		}
+
+	//the group of renames is recorded before any of them is done (in the
+	//planned order, the cycles record their own renames), then their
+	//results are made durable together
+	if ( poRenameJournal != NULL )
+		{
+		for( size_t i = 0; i < ( oOptions.bPlanRenames ? oPlan.anOrder.size() : aoOps.size() ); i++ )
+			{
+			const RenameOperation& oOp = aoOps[oOptions.bPlanRenames ? oPlan.anOrder[i] : i];
+			if ( oOp.sSourcePath != oOp.sTargetPath )
+				{ poRenameJournal->Planned(oOp.sSourcePath, oOp.sTargetPath); }
+			}
+		poRenameJournal->Sync();
+		}
+
+	if ( oOptions.bPlanRenames )
+		{ executePlannedRenameOperations(aoOps, oPlan, oSiblingIndex); }
+	else if ( oOptions.pszOutputDir != NULL )
+		{ executeTransferOperations(aoOps, oSiblingIndex, oOptions.nTransferThreads); }
+	else
+		{ executeRenameOperations(aoOps, oSiblingIndex); }
+
+	if ( poRenameJournal != NULL )
+		{ poRenameJournal->Sync(); }
+
+	for( size_t i = 0; i < aoOps.size(); i++ )
+		{
+		if ( aoOps[i].bMainFile && aoOps[i].nResult != RENAME_DONE )
+			{ aoJobs[aoOps[i].nJob].bSuccess = false; }
+		else if ( aoOps[i].bMainFile && oOptions.poGeoRefCache != NULL )
+			{ oOptions.poGeoRefCache->Renamed(aoOps[i].sSourcePath, aoOps[i].sTargetPath); }
+
+		if ( aoOps[i].nResult == RENAME_DONE && aoOps[i].sSourcePath != aoOps[i].sTargetPath )
+			{ countRunStats(aoOps[i].bMainFile ? COUNTER_DATASETS_RENAMED : COUNTER_SIBLINGS_RENAMED); }
+		}
+	}
+
+//***********************************************************************//
+//!Rename a dataset and its sibling files to the new name (or print the
+//!commands to do it)
+//***********************************************************************//
+bool applyRename(const char* pszFilePath, const std::string& sNewFileName, const RenameOptions& oOptions, SiblingIndex& oSiblingIndex)
+	{
+	std::vector<RenameJob> aoJobs(1);
+
+	aoJobs[0].sFilePath = pszFilePath;
+	aoJobs[0].sNewFileName = sNewFileName;
+	aoJobs[0].bSuccess = true;
+
+	applyRenames(aoJobs, oOptions, oSiblingIndex);
+
+	return aoJobs[0].bSuccess;
+	}
+
+//***********************************************************************//
+//!Rename a dataset and its sibling files (or print the commands to do it)
+//***********************************************************************//
+bool renameDataset(const char* pszFilePath, const RenameOptions& oOptions)
+	{
+	std::string sNewFileName;
+	SiblingIndex oSiblingIndex(false); //only one dataset, stat calls are cheaper than reading the directory
+
+	if ( !computeNewFileName(pszFilePath, oOptions, oSiblingIndex, sNewFileName) )
+		{ return false; }
+
+	return applyRename(pszFilePath, sNewFileName, oOptions, oSiblingIndex);
+	}
+
+//***********************************************************************//
+//!Compute the names of a group of datasets of a worker and pass them to
+//!the rename stage
+//***********************************************************************//
+static void flushNameGroup(BatchContext* poContext, NameGroup& oGroup, const std::string& sSourceSRS, ReprojectionCache* poCache)
+	{
+	renderNameGroup(oGroup, sSourceSRS, poCache, *poContext->poOptions);
+
+	for( size_t i = 0; i < oGroup.aoJobs.size(); i++ )
+		{ poContext->poJobQueue->Push(oGroup.aoJobs[i]); }
+
+	oGroup.aoJobs.clear();
+	oGroup.oExtents.Clear();
+	}
+
+//***********************************************************************//
+//!Read the georeferencing (and SRS with --target-srs or --tile-index) of
+//!a dataset and add it to the group of its SRS, the group names are
+//!computed once it is full. A dataset not read is passed to the rename
+//!stage as a failure
+//***********************************************************************//
+static void addNameGroupJob(BatchContext* poContext, const RenameJob& oJob, std::map<std::string, NameGroup>& oGroups,
+							ReprojectionCache* poCache)
+	{
+	DatasetGeoRef oGeoRef;
+	std::string sSRS;
+	bool bIndexed = ( poContext->poOptions->poTileIndex != NULL );
+
+	if ( !readDatasetGeoRef(oJob.sFilePath.c_str(), *poContext->poOptions, *poContext->poSiblingIndex, oGeoRef,
+							poCache != NULL || bIndexed ? &sSRS : NULL) )
+		{
+		RenameJob oFailedJob = oJob;
+		oFailedJob.bSuccess = false;
+		poContext->poJobQueue->Push(oFailedJob);
+		return;
+		}
+
+	NameGroup& oGroup = oGroups[sSRS];
+
+	oGroup.aoJobs.push_back(oJob);
+	oGroup.oExtents.Add(oGeoRef);
+
+	//kept for the rename stage which writes the tile index
+	if ( bIndexed )
+		{
+		oGroup.aoJobs.back().oGeoRef = oGeoRef;
+		oGroup.aoJobs.back().sSRS = sSRS;
+		}
+
+	if ( oGroup.aoJobs.size() >= GDAL_RENAME_NAME_GROUP )
+		{ flushNameGroup(poContext, oGroup, sSRS, poCache); }
+	}
+
+//***********************************************************************//
+//!Worker thread of the batch mode, read the georeferencing of the datasets
+//!popped from the queue (GDALOpen or headers) and compute their new names
+//!by groups (of same source SRS with --target-srs, transformed with one
+//!call), then pass them to the rename stage. The groups are flushed as
+//!soon as the queue is empty, so a stream of paths (--from-stdin) is not
+//!delayed
+//***********************************************************************//
+static void computeWorker(void* pData)
+	{
+	BatchContext *poContext = (BatchContext *) pData;
+	const RenameOptions *poOptions = poContext->poOptions;
+	ReprojectionCache *poReprojectionCache = NULL;
+	std::map<std::string, NameGroup> oGroups;
+	RenameJob oJob;
+
+	if ( poOptions->pszTargetSRS != NULL )
+		{ poReprojectionCache = new ReprojectionCache(poOptions->pszTargetSRS); }
+
+	while ( true )
+		{
+		if ( !poContext->poQueue->TryPop(oJob.sFilePath) )
+			{
+			for( std::map<std::string, NameGroup>::iterator it = oGroups.begin(); it != oGroups.end(); ++it )
+				{
+				if ( !it->second.aoJobs.empty() )
+					{ flushNameGroup(poContext, it->second, it->first, poReprojectionCache); }
+				}
+
+			if ( !poContext->poQueue->Pop(oJob.sFilePath) )
+				{ break; }
+			}
+
+		//already renamed by the resumed run, not opened again
+		if ( poContext->poDonePaths != NULL && poContext->poDonePaths->count(oJob.sFilePath) > 0 )
+			{
+			::CPLAtomicInc(&poContext->nSkipped);
+			countRunStats(COUNTER_DATASETS_SKIPPED);
+			continue;
+			}
+
+		oJob.sNewFileName.clear();
+		addNameGroupJob(poContext, oJob, oGroups, poReprojectionCache);
+
+		//the workers report the progress too, the rename stage waits for the whole batch with --plan
+		if ( poRunStats != NULL )
+			{ poRunStats->Progress(); }
+		}
+
+	delete poReprojectionCache;
+	}
+
+//***********************************************************************//
+//!Rename stage of the batch mode, apply the jobs computed by the workers.
+//!Only one thread performs the renames (and console output) so the
+//!"no overwrite" checks of a batch are not raced by the other datasets
+//!of the same batch. The jobs already waiting in the queue are applied
+//!together so the io_uring backend can submit them in one batch, with
+//!the planner (or an inferred grid) all the jobs are gathered and planned
+//!together. With a journal up to 4096 waiting jobs are applied together
+//!so that each journal sync covers thousands of renames while the
+//!workers are ahead, no job waits for a group to fill
+//***********************************************************************//
+static void renameStage(void* pData)
+	{
+	BatchContext *poContext = (BatchContext *) pData;
+	std::vector<RenameJob> aoJobs;
+	RenameJob oJob;
+
+	while ( poContext->poJobQueue->Pop(oJob) )
+		{
+		aoJobs.assign(1, oJob);
+
+		//the grid is inferred from the whole batch before any name
+		bool bInferGrid = poContext->poOptions->poTileGrid != NULL && poContext->poOptions->poTileGrid->bInfer;
+
+		if ( poContext->poOptions->bPlanRenames || bInferGrid )
+			{
+			while ( poContext->poJobQueue->Pop(oJob) )
+				{ aoJobs.push_back(oJob); }
+			}
+
+		if ( bInferGrid )
+			{ renderGridNames(aoJobs, *poContext->poOptions); }
+
+		size_t nMaxJobs = ( poRenameJournal != NULL ) ? 4096 : 256;
+
+		while ( aoJobs.size() < nMaxJobs && poContext->poJobQueue->TryPop(oJob) )
+			{ aoJobs.push_back(oJob); }
+
+		//the check only records the targets of the whole inventory
+		if ( poContext->poOptions->poDuplicateCheck != NULL )
+			{ poContext->poOptions->poDuplicateCheck->Add(aoJobs, poContext->poOptions->pszOutputDir); }
+		else
+			{ applyRenames(aoJobs, *poContext->poOptions, *poContext->poSiblingIndex); }
+
+		//the commands of the watched datasets are printed once renamed
+		if ( poContext->bWatch && poContext->poOptions->poCommandWriter != NULL )
+			{ poContext->poOptions->poCommandWriter->Flush(); }
+
+		if ( poContext->poOptions->poTileIndex != NULL )
+			{ poContext->poOptions->poTileIndex->Add(aoJobs, poContext->poOptions->pszOutputDir); }
+
+		for( size_t i = 0; i < aoJobs.size(); i++ )
+			{
+			if ( aoJobs[i].bSuccess )
+				{ poContext->nSuccess++; }
+			else
+				{
+				poContext->aosFailures.push_back(aoJobs[i].sFilePath);
+				countRunStats(COUNTER_DATASETS_FAILED);
+				}
+			}
+
+		if ( poRunStats != NULL )
+			{ poRunStats->Progress(); }
+		}
+	}
+
+//***********************************************************************//
+//!Push the paths read from stdin (one per line, or NUL delimited as
+//!printed by "find -print0") to the batch queue, as they arrive
+//***********************************************************************//
+void queueStdinPaths(bool bNulDelimited, WorkQueue<std::string>& oQueue)
+	{
+	std::string sPath;
+
+	while ( std::getline(std::cin, sPath, bNulDelimited ? '\0' : '\n') )
+		{
+		if ( !bNulDelimited && !sPath.empty() && sPath[sPath.length()-1] == '\r' )
+			{ sPath.erase(sPath.length()-1); }
+
+		if ( !sPath.empty() )
+			{ oQueue.Push(sPath); }
+		}
+	}
+
+//***********************************************************************//
+//!Push a file to the batch queue, or all the matching files of a directory
+//!(recursively). Only the files with one of the given extensions are kept
+//!from the directories, so sibling files are not processed as datasets.
+//!The files of each directory are pushed before its subdirectories are
+//!listed (GDAL 3.0), the whole tree is listed first with older versions
+//***********************************************************************//
+void queueInputPath(const std::string& sInputPath, char** papszExtensions, WorkQueue<std::string>& oQueue)
+	{
+	::VSIStatBufL psStatBuf;
+	bool bIsDir = false;
+
+	countRunStats(COUNTER_STAT_CALLS);
+		{
+		PhaseTimer oTimer(PHASE_STAT);
+		bIsDir = ::VSIStatExL ( sInputPath.c_str(), &psStatBuf, VSI_STAT_EXISTS_FLAG | VSI_STAT_NATURE_FLAG) == 0 &&
+				 VSI_ISDIR(psStatBuf.st_mode);
+		}
+
+	if ( !bIsDir )
+		{
+		oQueue.Push(sInputPath);
+		return;
+		}
+
+#if GDAL_VERSION_NUM >= 3000000
+	//one directory at a time : it is fully listed before its files are
+	//pushed (and renamed), so a renamed file is never listed again
+	std::vector<std::string> aosDirectories(1, sInputPath);
+
+	while ( !aosDirectories.empty() )
+		{
+		std::string sDirectory = aosDirectories.back();
+		std::vector<std::string> aosFiles;
+		aosDirectories.pop_back();
+
+			{
+			PhaseTimer oTimer(PHASE_DIRECTORY_WALK);
+			VSIDIR *psDir = ::VSIOpenDir( sDirectory.c_str(), 0, NULL );
+			const VSIDIREntry *psEntry = NULL;
+
+			while ( psDir != NULL && ( psEntry = ::VSIGetNextDirEntry(psDir) ) != NULL )
+				{
+				std::string sPath = sDirectory + sDirSep + psEntry->pszName;
+				bool bEntryIsDir = psEntry->bModeKnown && VSI_ISDIR(psEntry->nMode);
+
+				if ( !psEntry->bModeKnown )
+					{
+					countRunStats(COUNTER_STAT_CALLS);
+					bEntryIsDir = ::VSIStatExL(sPath.c_str(), &psStatBuf, VSI_STAT_EXISTS_FLAG | VSI_STAT_NATURE_FLAG) == 0 &&
+								  VSI_ISDIR(psStatBuf.st_mode);
+					}
+
+				if ( bEntryIsDir )
+					{ aosDirectories.push_back(sPath); }
+				else if ( ::CSLFindString(papszExtensions, ::CPLGetExtension(psEntry->pszName)) >= 0 )
+					{ aosFiles.push_back(sPath); }
+				}
+
+			if ( psDir != NULL )
+				{ ::VSICloseDir(psDir); }
+			}
+
+		//blocks while the workers are behind, the walk goes on once they pop
+		for( size_t i = 0; i < aosFiles.size(); i++ )
+			{ oQueue.Push(aosFiles[i]); }
+		}
+#else
+	char **papszFiles = NULL;
+
+		{
+		PhaseTimer oTimer(PHASE_DIRECTORY_WALK);
+		papszFiles = ::VSIReadDirRecursive( sInputPath.c_str() );
+		}
+
+	for( int i = 0; papszFiles != NULL && papszFiles[i] != NULL; i++ )
+		{
+		std::string sFile = papszFiles[i];
+
+		//directories are listed with a trailing separator
+		if ( sFile.empty() || sFile[sFile.length()-1] == '/' || sFile[sFile.length()-1] == '\\' )
+			{ continue; }
+
+		if ( ::CSLFindString(papszExtensions, ::CPLGetExtension(sFile.c_str())) < 0 )
+			{ continue; }
+
+		oQueue.Push(sInputPath + sDirSep + sFile);
+		}
+
+	::CSLDestroy(papszFiles);
+#endif
+	}
+
+#ifdef GDAL_RENAME_HAVE_INOTIFY
+static volatile sig_atomic_t bWatchStopped = 0;
+
+//***********************************************************************//
+//!SIGINT/SIGTERM handler of the watch mode, the datasets already queued
+//!are renamed before exiting
+//***********************************************************************//
+static void stopWatch(int)
+	{
+	bWatchStopped = 1;
+	}
+
+//***********************************************************************//
+//!Watch a directory and its sub directories (written by inotify events)
+//***********************************************************************//
+static bool addWatchDirectory(int hInotify, const std::string& sDirectory, std::map<int, std::string>& oWatches)
+	{
+	const uint32_t nMask = IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_FROM | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR;
+	int hWatch = inotify_add_watch(hInotify, sDirectory.c_str(), nMask);
+
+	if ( hWatch < 0 )
+		{
+		::CPLError(CE_Failure, CPLE_FileIO, "Unable to watch the directory \"%s\" : %s", sDirectory.c_str(), strerror(errno));
+		return false;
+		}
+
+	oWatches[hWatch] = sDirectory;
+
+	char **papszFiles = ::VSIReadDirRecursive( sDirectory.c_str() );
+
+	for( int i = 0; papszFiles != NULL && papszFiles[i] != NULL; i++ )
+		{
+		std::string sFile = papszFiles[i];
+
+		//directories are listed with a trailing separator
+		if ( !sFile.empty() && sFile[sFile.length()-1] == '/' )
+			{
+			sFile = sDirectory + sDirSep + sFile.substr(0, sFile.length()-1);
+			hWatch = inotify_add_watch(hInotify, sFile.c_str(), nMask);
+			if ( hWatch >= 0 )
+				{ oWatches[hWatch] = sFile; }
+			}
+		}
+
+	::CSLDestroy(papszFiles);
+	return true;
+	}
+
+//***********************************************************************//
+//!Whether a dataset and its sibling files are fully written : closed
+//!after their last write and without event for the settle window
+//***********************************************************************//
+static bool isWatchedDatasetSettled(const std::string& sFilePath, const std::map<std::string, WatchedFile>& oFiles, double dfSettleTime)
+	{
+	std::vector<std::string> asFiles(1, sFilePath);
+	std::vector<std::string> SiblingFilesExts = getSiblingFilesExt(sFilePath);
+	std::string sBasePath = std::string(::CPLGetDirname(sFilePath.c_str())) + sDirSep + ::CPLGetBasename(sFilePath.c_str()) + ".";
+
+	for( size_t i = 0; i < SiblingFilesExts.size(); i++ )
+		{
+		std::string sLower = SiblingFilesExts[i], sUpper = SiblingFilesExts[i];
+		std::transform(sLower.begin(), sLower.end(), sLower.begin(), ::tolower);
+		std::transform(sUpper.begin(), sUpper.end(), sUpper.begin(), ::toupper);
+		asFiles.push_back(sBasePath + sLower);
+		asFiles.push_back(sBasePath + sUpper);
+		}
+
+	for( size_t i = 0; i < asFiles.size(); i++ )
+		{
+		std::map<std::string, WatchedFile>::const_iterator it = oFiles.find(asFiles[i]);
+
+		if ( it != oFiles.end() && ( !it->second.bClosed || it->second.dfLastEvent > dfSettleTime ) )
+			{ return false; }
+		}
+
+	return true;
+	}
+#endif
+
+//***********************************************************************//
+//!Watch directories (and their sub directories) with inotify and push the
+//!datasets written there to the batch queue once they and their sibling
+//!files are closed and unchanged for the settle window, until SIGINT or
+//!SIGTERM. The datasets already there are queued first. The datasets
+//!moved to a new path by this process (renames, backups), known by the
+//!sibling index of the rename stage, are not queued again, the ones moved
+//!by someone else are
+//***********************************************************************//
+bool queueWatchedPaths(const std::vector<std::string>& aosDirectories, char** papszExtensions, double dfSettle, SiblingIndex& oSiblingIndex, WorkQueue<std::string>& oQueue)
+	{
+#ifdef GDAL_RENAME_HAVE_INOTIFY
+	int hInotify = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+	std::map<int, std::string> oWatches;			//watch descriptor -> directory
+	std::map<std::string, WatchedFile> oFiles;		//files being written, by path
+	std::set<std::string> oPending;					//datasets written, waiting to settle
+	std::set<std::string> oPendingMoves;			//datasets moved in or listed again, maybe by a rename of this process
+	std::set<std::string> oQueued;					//datasets queued, until moved away
+
+	if ( hInotify < 0 )
+		{
+		::CPLError(CE_Failure, CPLE_AppDefined, "inotify not available : %s", strerror(errno));
+		return false;
+		}
+
+	//watched before the existing datasets are listed, so none is missed
+	for( size_t i = 0; i < aosDirectories.size(); i++ )
+		{
+		if ( !addWatchDirectory(hInotify, aosDirectories[i], oWatches) )
+			{
+			close(hInotify);
+			return false;
+			}
+		}
+
+	for( size_t i = 0; i < aosDirectories.size(); i++ )
+		{ queueInputPath(aosDirectories[i], papszExtensions, oQueue); }
+
+	struct sigaction sAction;
+	memset(&sAction, 0, sizeof(sAction));
+	sAction.sa_handler = stopWatch;
+	sigaction(SIGINT, &sAction, NULL);
+	sigaction(SIGTERM, &sAction, NULL);
+
+	fprintf(stderr, "Watching %d director%s, stop with Ctrl+C\n", (int) oWatches.size(), oWatches.size() > 1 ? "ies" : "y");
+
+	std::vector<char> abyEvents(65536);
+
+	while ( !bWatchStopped )
+		{
+		struct pollfd sPoll;
+		sPoll.fd = hInotify;
+		sPoll.events = POLLIN;
+		sPoll.revents = 0;
+
+		//woken up to check the settle window while some files are written
+		int nTimeout = oFiles.empty() && oPending.empty() ? -1 : std::max(1, (int)( dfSettle * 500.0 ));
+
+		if ( poll(&sPoll, 1, nTimeout) < 0 && errno != EINTR )
+			{ break; }
+
+		double dfNow = RunStats::GetTime();
+		ssize_t nRead;
+
+		while ( ( nRead = read(hInotify, &abyEvents[0], abyEvents.size()) ) > 0 )
+			{
+			for( ssize_t nOffset = 0; nOffset < nRead; )
+				{
+				const struct inotify_event *psEvent = (const struct inotify_event *) &abyEvents[nOffset];
+				nOffset += sizeof(struct inotify_event) + psEvent->len;
+
+				//events lost : the watched directories are listed again (and the
+				//sub directories created meanwhile watched), their datasets queued once settled
+				if ( psEvent->mask & IN_Q_OVERFLOW )
+					{
+					::CPLError(CE_Warning, CPLE_AppDefined, "Too many changes in the watched directories, listing them again");
+
+					//the closes may be lost, the datasets listed wait for a whole settle window
+					oFiles.clear();
+					oPending.clear();
+					for( size_t i = 0; i < aosDirectories.size(); i++ )
+						{
+						addWatchDirectory(hInotify, aosDirectories[i], oWatches);
+
+						char **papszFiles = ::VSIReadDirRecursive( aosDirectories[i].c_str() );
+						for( int j = 0; papszFiles != NULL && papszFiles[j] != NULL; j++ )
+							{
+							std::string sFile = aosDirectories[i] + sDirSep + papszFiles[j];
+
+							if ( ::CSLFindString(papszExtensions, ::CPLGetExtension(papszFiles[j])) >= 0 && oQueued.count(sFile) == 0 )
+								{
+								WatchedFile& oFile = oFiles[sFile];
+								oFile.dfLastEvent = dfNow;
+								oFile.bClosed = true;
+								oPending.insert(sFile);
+								oPendingMoves.insert(sFile);
+								}
+							}
+						::CSLDestroy(papszFiles);
+						}
+
+					//the moves away of the queued datasets may be lost too
+					std::set<std::string>::iterator itQueued = oQueued.begin();
+					while ( itQueued != oQueued.end() )
+						{
+						if ( !fileExists(*itQueued) )
+							{ oQueued.erase(itQueued++); }
+						else
+							{ ++itQueued; }
+						}
+					continue;
+					}
+
+				std::map<int, std::string>::iterator itWatch = oWatches.find(psEvent->wd);
+
+				if ( psEvent->mask & IN_IGNORED )
+					{
+					if ( itWatch != oWatches.end() )
+						{ oWatches.erase(itWatch); }
+					continue;
+					}
+
+				if ( itWatch == oWatches.end() || psEvent->len == 0 )
+					{ continue; }
+
+				std::string sPath = itWatch->second + sDirSep + psEvent->name;
+				bool bDataset = ::CSLFindString(papszExtensions, ::CPLGetExtension(psEvent->name)) >= 0;
+
+				if ( psEvent->mask & IN_ISDIR )
+					{
+					//new sub directory, its files written before the watch are queued once settled
+					if ( psEvent->mask & (IN_CREATE | IN_MOVED_TO) )
+						{
+						std::map<int, std::string> oNewWatches;
+						if ( addWatchDirectory(hInotify, sPath, oNewWatches) )
+							{
+							char **papszFiles = ::VSIReadDirRecursive( sPath.c_str() );
+							for( int i = 0; papszFiles != NULL && papszFiles[i] != NULL; i++ )
+								{
+								if ( ::CSLFindString(papszExtensions, ::CPLGetExtension(papszFiles[i])) >= 0 )
+									{ oPending.insert(sPath + sDirSep + papszFiles[i]); }
+								}
+							::CSLDestroy(papszFiles);
+							oWatches.insert(oNewWatches.begin(), oNewWatches.end());
+							}
+						}
+					continue;
+					}
+
+				//moved away (renamed by this process, or by someone else)
+				if ( psEvent->mask & IN_MOVED_FROM )
+					{
+					oPending.erase(sPath);
+					oPendingMoves.erase(sPath);
+					oQueued.erase(sPath);
+					oFiles.erase(sPath);
+					continue;
+					}
+
+				//created, written, closed or moved in
+				WatchedFile& oFile = oFiles[sPath];
+				oFile.dfLastEvent = dfNow;
+				oFile.bClosed = ( psEvent->mask & (IN_CLOSE_WRITE | IN_MOVED_TO) ) != 0;
+
+				if ( bDataset )
+					{
+					oPending.insert(sPath);
+					if ( psEvent->mask & IN_MOVED_TO )
+						{ oPendingMoves.insert(sPath); }
+					else
+						{ oPendingMoves.erase(sPath); }
+					}
+				}
+			}
+
+		//settled datasets, the closed files have no more use past the window
+		dfNow = RunStats::GetTime();
+
+		std::set<std::string>::iterator itPending = oPending.begin();
+		while ( itPending != oPending.end() )
+			{
+			if ( isWatchedDatasetSettled(*itPending, oFiles, dfNow - dfSettle) )
+				{
+				//the rename stage records its renames right after them, before they settle
+				bool bRenamed = oPendingMoves.erase(*itPending) > 0 &&
+								( oSiblingIndex.IsRenamedPath(*itPending) || !fileExists(*itPending) );
+
+				if ( !bRenamed )
+					{
+					oQueue.Push(*itPending);
+					oQueued.insert(*itPending);
+					}
+				oPending.erase(itPending++);
+				}
+			else
+				{ ++itPending; }
+			}
+
+		std::map<std::string, WatchedFile>::iterator itFile = oFiles.begin();
+		while ( itFile != oFiles.end() )
+			{
+			if ( itFile->second.bClosed && itFile->second.dfLastEvent <= dfNow - dfSettle )
+				{ oFiles.erase(itFile++); }
+			else
+				{ ++itFile; }
+			}
+		}
+
+	signal(SIGINT, SIG_DFL);
+	signal(SIGTERM, SIG_DFL);
+	close(hInotify);
+
+	//written but not settled yet when stopped
+	for( std::set<std::string>::iterator it = oPending.begin(); it != oPending.end(); ++it )
+		{ fprintf(stderr, "Watch stopped before \"%s\" was fully written, not renamed\n", it->c_str()); }
+
+	return true;
+#else
+	::CPLError(CE_Failure, CPLE_NotSupported, "--watch needs inotify (Linux)");
+	return false;
+#endif
+	}
+
+//***********************************************************************//
+//!Rename the datasets of the inputs (files, directories walked
+//!recursively, stdin and/or watched directories) with the batch pipeline,
+//!the summary of the successes and failures is left in oContext
+//***********************************************************************//
+void runBatch(const std::vector<std::string>& aosInputPaths, bool bFromStdin, bool bNulDelimited, bool bWatch, double dfWatchSettle,
+			  int nThreads, char** papszExtensions, const RenameOptions& oOptions, const std::unordered_set<std::string>* poDonePaths,
+			  BatchContext& oContext)
+	{
+	//pipeline : reader (this thread) -> workers (open/format) -> rename stage,
+	//the queues are bounded so memory use does not depend on the inputs count
+	WorkQueue<std::string> oQueue( nThreads * 64 );
+	WorkQueue<RenameJob> oJobQueue( nThreads * 64 );
+
+	//each directory is read once to find the sibling files and check the
+	//targets, watched directories change all the time and are not indexed
+	SiblingIndex oSiblingIndex(!bWatch);
+
+	oContext.poOptions = &oOptions;
+	oContext.poQueue = &oQueue;
+	oContext.poJobQueue = &oJobQueue;
+	oContext.poSiblingIndex = &oSiblingIndex;
+	oContext.poDonePaths = poDonePaths;
+	oContext.bWatch = bWatch;
+	oContext.nSkipped = 0;
+	oContext.nSuccess = 0;
+
+	CPLJoinableThread *poRenameThread = ::CPLCreateJoinableThread(renameStage, &oContext);
+
+	std::vector<CPLJoinableThread*> apoThreads;
+	for( int i = 0; i < nThreads; i++ )
+		{ apoThreads.push_back( ::CPLCreateJoinableThread(computeWorker, &oContext) ); }
+
+	//directories (walked, GDAL 3.0) and stdin are read while the first files are already renamed
+	if ( bWatch )
+		{
+		oSiblingIndex.TrackRenames();
+		queueWatchedPaths(aosInputPaths, papszExtensions, dfWatchSettle, oSiblingIndex, oQueue);
+		}
+
+	for( size_t i = 0; i < aosInputPaths.size() && !bWatch; i++ )
+		{ queueInputPath(aosInputPaths[i], papszExtensions, oQueue); }
+
+	if ( bFromStdin )
+		{ queueStdinPaths(bNulDelimited, oQueue); }
+
+	oQueue.Close();
+
+	for( size_t i = 0; i < apoThreads.size(); i++ )
+		{ ::CPLJoinThread(apoThreads[i]); }
+
+	oJobQueue.Close();
+	::CPLJoinThread(poRenameThread);
+	}
+
+//***********************************************************************//
+//!Write an unsigned integer of nBytes, little endian (ZIP headers)
+//***********************************************************************//
+static void writeUIntToBuffer(GByte *pabyData, GUIntBig nValue, int nBytes)
+	{
+	for( int i = 0; i < nBytes; i++ )
+		{
+		pabyData[i] = (GByte)( nValue & 0xFF );
+		nValue >>= 8;
+		}
+	}
+
+//***********************************************************************//
+//!Copy nBytes of an archive as they are, by chunks of the buffer
+//***********************************************************************//
+static bool copyArchiveBytes(VSILFILE *fpSource, VSILFILE *fpTarget, GUIntBig nBytes, std::vector<GByte>& abyBuffer)
+	{
+	while ( nBytes > 0 )
+		{
+		size_t nChunk = (size_t) std::min<GUIntBig>(nBytes, abyBuffer.size());
+
+		if ( ::VSIFReadL(&abyBuffer[0], 1, nChunk, fpSource) != nChunk ||
+			 ::VSIFWriteL(&abyBuffer[0], 1, nChunk, fpTarget) != nChunk )
+			{ return false; }
+
+		nBytes -= nChunk;
+		}
+
+	return true;
+	}
+
+//***********************************************************************//
+//!List the datasets of an archive (read through /vsizip/ or /vsitar/)
+//!and their new member names. A dataset is renamed only if none of its
+//!new names is kept by another member or given to another dataset
+//***********************************************************************//
+static void listArchiveRenames(const std::string& sVSIPath, char** papszExtensions, const RenameOptions& oOptions,
+							   std::map<std::string, std::string>& oRenames, int& nRenamed, int& nSiblings, int& nFailures)
+	{
+	SiblingIndex oSiblingIndex(true);
+	std::vector<RenameOperation> aoOps;
+	std::set<std::string> oMembers;
+	size_t nJobs = 0;
+	char **papszMembers = NULL;
+
+		{
+		PhaseTimer oTimer(PHASE_DIRECTORY_WALK);
+		papszMembers = ::VSIReadDirRecursive( sVSIPath.c_str() );
+		}
+
+	for( int i = 0; papszMembers != NULL && papszMembers[i] != NULL; i++ )
+		{
+		std::string sMember = papszMembers[i];
+		std::string sNewFileName;
+
+		//directories are listed with a trailing separator
+		if ( sMember.empty() || sMember[sMember.length()-1] == '/' )
+			{ continue; }
+
+		oMembers.insert(sMember);
+
+		if ( ::CSLFindString(papszExtensions, ::CPLGetExtension(sMember.c_str())) < 0 )
+			{ continue; }
+
+		std::string sMemberPath = sVSIPath + "/" + sMember;
+
+		if ( !computeNewFileName(sMemberPath.c_str(), oOptions, oSiblingIndex, sNewFileName) )
+			{
+			nFailures++;
+			continue;
+			}
+
+		listRenameOperations(sMemberPath.c_str(), sNewFileName, NULL, nJobs++, oSiblingIndex, aoOps);
+		}
+
+	::CSLDestroy(papszMembers);
+
+	//all the entries are renamed at once, so swaps need no temporary name,
+	//the datasets rejected keep their names which may reject others
+	std::vector<bool> abRejected(nJobs, false);
+	bool bChanged = true;
+
+	while ( bChanged )
+		{
+		std::map<std::string, size_t> oTargets;
+		std::set<std::string> oRenamedMembers;
+
+		bChanged = false;
+		for( size_t i = 0; i < aoOps.size(); i++ )
+			{
+			if ( !abRejected[aoOps[i].nJob] )
+				{ oRenamedMembers.insert(aoOps[i].sSourcePath.substr(sVSIPath.length() + 1)); }
+			}
+
+		for( size_t i = 0; i < aoOps.size(); i++ )
+			{
+			const RenameOperation& oOp = aoOps[i];
+			std::string sTarget = oOp.sTargetPath.substr(sVSIPath.length() + 1);
+
+			if ( abRejected[oOp.nJob] )
+				{ continue; }
+
+			std::map<std::string, size_t>::iterator it = oTargets.find(sTarget);
+			bool bConflict = ( it != oTargets.end() && it->second != oOp.nJob );
+			bool bKept = ( oMembers.count(sTarget) > 0 && oRenamedMembers.count(sTarget) == 0 );
+
+			if ( bConflict || bKept )
+				{
+				countRunStats(bConflict ? COUNTER_FAILED_TARGET_CONFLICT : COUNTER_FAILED_TARGET_EXISTS);
+				::CPLError(CE_Failure, CPLE_AppDefined, "Unable to rename \"%s\" to \"%s\" : %s", oOp.sSourcePath.c_str(), sTarget.c_str(),
+						   bConflict ? "another dataset of the archive is renamed to the same name, left untouched" :
+									   "the new name is already a member of the archive, left untouched");
+				abRejected[oOp.nJob] = true;
+				if ( bConflict )
+					{ abRejected[it->second] = true; }
+				bChanged = true;
+				continue;
+				}
+
+			oTargets[sTarget] = oOp.nJob;
+			}
+		}
+
+	std::vector<bool> abCounted(nJobs, false);
+
+	for( size_t i = 0; i < aoOps.size(); i++ )
+		{
+		const RenameOperation& oOp = aoOps[i];
+
+		if ( abCounted[oOp.nJob] || !oOp.bMainFile )
+			{ continue; }
+
+		abCounted[oOp.nJob] = true;
+		if ( abRejected[oOp.nJob] )
+			{ nFailures++; }
+		else
+			{ nRenamed++; }
+		}
+
+	for( size_t i = 0; i < aoOps.size(); i++ )
+		{
+		if ( abRejected[aoOps[i].nJob] || aoOps[i].sSourcePath == aoOps[i].sTargetPath )
+			{ continue; }
+
+		oRenames[aoOps[i].sSourcePath.substr(sVSIPath.length() + 1)] = aoOps[i].sTargetPath.substr(sVSIPath.length() + 1);
+		if ( !aoOps[i].bMainFile )
+			{ nSiblings++; }
+		}
+	}
+
+//!Central directory record of a ZIP entry
+struct ZipCentralEntry
+	{
+	GByte				abyHeader[46];
+	std::string			sName;
+	std::vector<GByte>	abyExtra;
+	std::vector<GByte>	abyComment;
+	GUIntBig			nCompressedSize;
+	GUIntBig			nLocalOffset;
+	int					nZip64OffsetPos;	//position of the offset in the ZIP64 extra field, or -1
+	};
+
+//***********************************************************************//
+//!Read the central directory record of a ZIP entry at nOffset, with its
+//!ZIP64 sizes and offset
+//***********************************************************************//
+static bool readZipCentralEntry(VSILFILE *fp, GUIntBig nOffset, ZipCentralEntry& oEntry)
+	{
+	if ( ::VSIFSeekL(fp, nOffset, SEEK_SET) != 0 || ::VSIFReadL(oEntry.abyHeader, 1, 46, fp) != 46 ||
+		 readUIntFromBuffer(oEntry.abyHeader, 4, false) != 0x02014b50 )
+		{ return false; }
+
+	size_t nNameLength = (size_t) readUIntFromBuffer(oEntry.abyHeader + 28, 2, false);
+	oEntry.abyExtra.resize( (size_t) readUIntFromBuffer(oEntry.abyHeader + 30, 2, false) );
+	oEntry.abyComment.resize( (size_t) readUIntFromBuffer(oEntry.abyHeader + 32, 2, false) );
+	oEntry.sName.resize(nNameLength);
+
+	if ( ( nNameLength > 0 && ::VSIFReadL(&oEntry.sName[0], 1, nNameLength, fp) != nNameLength ) ||
+		 ( !oEntry.abyExtra.empty() && ::VSIFReadL(&oEntry.abyExtra[0], 1, oEntry.abyExtra.size(), fp) != oEntry.abyExtra.size() ) ||
+		 ( !oEntry.abyComment.empty() && ::VSIFReadL(&oEntry.abyComment[0], 1, oEntry.abyComment.size(), fp) != oEntry.abyComment.size() ) )
+		{ return false; }
+
+	GUIntBig nUncompressedSize = readUIntFromBuffer(oEntry.abyHeader + 24, 4, false);
+	oEntry.nCompressedSize = readUIntFromBuffer(oEntry.abyHeader + 20, 4, false);
+	oEntry.nLocalOffset = readUIntFromBuffer(oEntry.abyHeader + 42, 4, false);
+	oEntry.nZip64OffsetPos = -1;
+
+	//the 0xFFFFFFFF values are in the ZIP64 extra field, in this order
+	for( size_t nPos = 0; nPos + 4 <= oEntry.abyExtra.size(); )
+		{
+		int nId = (int) readUIntFromBuffer(&oEntry.abyExtra[nPos], 2, false);
+		size_t nSize = (size_t) readUIntFromBuffer(&oEntry.abyExtra[nPos + 2], 2, false);
+		size_t nField = nPos + 4;
+
+		if ( nId == 0x0001 )
+			{
+			if ( nUncompressedSize == 0xFFFFFFFF && nField + 8 <= nPos + 4 + nSize )
+				{ nField += 8; }
+			if ( oEntry.nCompressedSize == 0xFFFFFFFF && nField + 8 <= nPos + 4 + nSize )
+				{
+				oEntry.nCompressedSize = readUIntFromBuffer(&oEntry.abyExtra[nField], 8, false);
+				nField += 8;
+				}
+			if ( oEntry.nLocalOffset == 0xFFFFFFFF && nField + 8 <= nPos + 4 + nSize )
+				{
+				oEntry.nLocalOffset = readUIntFromBuffer(&oEntry.abyExtra[nField], 8, false);
+				oEntry.nZip64OffsetPos = (int) nField;
+				}
+			break;
+			}
+
+		nPos += 4 + nSize;
+		}
+
+	return true;
+	}
+
+//***********************************************************************//
+//!Extra fields of a renamed entry, without the Info-ZIP Unicode path
+//!field (0x7075) which holds the old name
+//***********************************************************************//
+static std::vector<GByte> removeZipUnicodePath(const std::vector<GByte>& abyExtra)
+	{
+	std::vector<GByte> abyFiltered;
+
+	for( size_t nPos = 0; nPos + 4 <= abyExtra.size(); )
+		{
+		size_t nFieldSize = 4 + (size_t) readUIntFromBuffer(&abyExtra[nPos + 2], 2, false);
+		size_t nEnd = std::min(nPos + nFieldSize, abyExtra.size());
+
+		if ( readUIntFromBuffer(&abyExtra[nPos], 2, false) != 0x7075 )
+			{ abyFiltered.insert(abyFiltered.end(), abyExtra.begin() + nPos, abyExtra.begin() + nEnd); }
+
+		nPos = nEnd;
+		}
+
+	return abyFiltered;
+	}
+
+//***********************************************************************//
+//!Write a ZIP archive with the entries of fpSource renamed : the local
+//!headers get the new names and the compressed data is copied as it is
+//!(no recompression), then the central directory (read again from the
+//!source, so the memory only holds the new offsets) and its end records
+//***********************************************************************//
+static bool rewriteZipArchive(VSILFILE *fpSource, VSILFILE *fpTarget, const std::map<std::string, std::string>& oRenames)
+	{
+	std::vector<GByte> abyBuffer(GDAL_RENAME_ARCHIVE_CHUNK);
+
+	//end of central directory record, before the archive comment
+	if ( ::VSIFSeekL(fpSource, 0, SEEK_END) != 0 )
+		{ return false; }
+
+	GUIntBig nFileSize = ::VSIFTellL(fpSource);
+	size_t nTailSize = (size_t) std::min<GUIntBig>(nFileSize, 22 + 65535);
+	std::vector<GByte> abyTail(nTailSize);
+	size_t nEOCD = 0;
+	bool bFound = false;
+
+	if ( nTailSize < 22 || ::VSIFSeekL(fpSource, nFileSize - nTailSize, SEEK_SET) != 0 ||
+		 ::VSIFReadL(&abyTail[0], 1, nTailSize, fpSource) != nTailSize )
+		{ return false; }
+
+	for( size_t i = nTailSize - 21; i > 0 && !bFound; i-- )
+		{
+		nEOCD = i - 1;
+		bFound = ( readUIntFromBuffer(&abyTail[nEOCD], 4, false) == 0x06054b50 &&
+				   nEOCD + 22 + readUIntFromBuffer(&abyTail[nEOCD + 20], 2, false) == nTailSize );
+		}
+
+	if ( !bFound || readUIntFromBuffer(&abyTail[nEOCD + 4], 2, false) != 0 || readUIntFromBuffer(&abyTail[nEOCD + 6], 2, false) != 0 )
+		{
+		::CPLError(CE_Failure, CPLE_NotSupported, "Not a single volume ZIP archive");
+		return false;
+		}
+
+	GUIntBig nEntries = readUIntFromBuffer(&abyTail[nEOCD + 10], 2, false);
+	GUIntBig nCDOffset = readUIntFromBuffer(&abyTail[nEOCD + 16], 4, false);
+	GByte abyZip64EOCD[56];
+	bool bZip64 = ( nEOCD >= 20 && readUIntFromBuffer(&abyTail[nEOCD - 20], 4, false) == 0x07064b50 );
+
+	if ( bZip64 )
+		{
+		if ( ::VSIFSeekL(fpSource, readUIntFromBuffer(&abyTail[nEOCD - 12], 8, false), SEEK_SET) != 0 ||
+			 ::VSIFReadL(abyZip64EOCD, 1, 56, fpSource) != 56 || readUIntFromBuffer(abyZip64EOCD, 4, false) != 0x06064b50 )
+			{ return false; }
+
+		nEntries = readUIntFromBuffer(abyZip64EOCD + 32, 8, false);
+		nCDOffset = readUIntFromBuffer(abyZip64EOCD + 48, 8, false);
+		}
+
+	//the local entries, renamed, with their data as it is
+	std::vector<GUIntBig> anNewOffsets;
+	ZipCentralEntry oEntry;
+	GUIntBig nCDPos = nCDOffset;
+
+	for( GUIntBig iEntry = 0; iEntry < nEntries; iEntry++ )
+		{
+		GByte abyLocal[30];
+
+		if ( !readZipCentralEntry(fpSource, nCDPos, oEntry) )
+			{ return false; }
+		nCDPos += 46 + oEntry.sName.size() + oEntry.abyExtra.size() + oEntry.abyComment.size();
+
+		if ( ::VSIFSeekL(fpSource, oEntry.nLocalOffset, SEEK_SET) != 0 || ::VSIFReadL(abyLocal, 1, 30, fpSource) != 30 ||
+			 readUIntFromBuffer(abyLocal, 4, false) != 0x04034b50 )
+			{ return false; }
+
+		size_t nNameLength = (size_t) readUIntFromBuffer(abyLocal + 26, 2, false);
+		std::vector<GByte> abyExtra( (size_t) readUIntFromBuffer(abyLocal + 28, 2, false) );
+		GUIntBig nDataOffset = oEntry.nLocalOffset + 30 + nNameLength + abyExtra.size();
+
+		if ( ::VSIFSeekL(fpSource, oEntry.nLocalOffset + 30 + nNameLength, SEEK_SET) != 0 ||
+			 ( !abyExtra.empty() && ::VSIFReadL(&abyExtra[0], 1, abyExtra.size(), fpSource) != abyExtra.size() ) )
+			{ return false; }
+
+		bool bLocalZip64 = false;
+		for( size_t nPos = 0; nPos + 4 <= abyExtra.size(); nPos += 4 + (size_t) readUIntFromBuffer(&abyExtra[nPos + 2], 2, false) )
+			{ bLocalZip64 = bLocalZip64 || readUIntFromBuffer(&abyExtra[nPos], 2, false) == 0x0001; }
+
+		std::map<std::string, std::string>::const_iterator it = oRenames.find(oEntry.sName);
+		const std::string& sName = ( it != oRenames.end() ) ? it->second : oEntry.sName;
+
+		if ( it != oRenames.end() )
+			{ abyExtra = removeZipUnicodePath(abyExtra); }
+
+		if ( sName.size() > 0xFFFF )
+			{ return false; }
+
+		writeUIntToBuffer(abyLocal + 26, sName.size(), 2);
+		writeUIntToBuffer(abyLocal + 28, abyExtra.size(), 2);
+		anNewOffsets.push_back( ::VSIFTellL(fpTarget) );
+
+		if ( ::VSIFWriteL(abyLocal, 1, 30, fpTarget) != 30 ||
+			 ( !sName.empty() && ::VSIFWriteL(sName.data(), 1, sName.size(), fpTarget) != sName.size() ) ||
+			 ( !abyExtra.empty() && ::VSIFWriteL(&abyExtra[0], 1, abyExtra.size(), fpTarget) != abyExtra.size() ) ||
+			 ::VSIFSeekL(fpSource, nDataOffset, SEEK_SET) != 0 ||
+			 !copyArchiveBytes(fpSource, fpTarget, oEntry.nCompressedSize, abyBuffer) )
+			{ return false; }
+
+		//data descriptor of the entries streamed when written, optional signature
+		if ( readUIntFromBuffer(abyLocal + 6, 2, false) & 0x0008 )
+			{
+			GByte abySignature[4];
+			GUIntBig nDescriptorSize = bLocalZip64 ? 20 : 12;
+
+			if ( ::VSIFReadL(abySignature, 1, 4, fpSource) != 4 )
+				{ return false; }
+			if ( readUIntFromBuffer(abySignature, 4, false) == 0x08074b50 )
+				{ nDescriptorSize += 4; }
+
+			if ( ::VSIFSeekL(fpSource, nDataOffset + oEntry.nCompressedSize, SEEK_SET) != 0 ||
+				 !copyArchiveBytes(fpSource, fpTarget, nDescriptorSize, abyBuffer) )
+				{ return false; }
+			}
+
+		countRunStats(COUNTER_ARCHIVE_ENTRIES);
+		}
+
+	//the central directory, read again
+	GUIntBig nNewCDOffset = ::VSIFTellL(fpTarget);
+	nCDPos = nCDOffset;
+
+	for( GUIntBig iEntry = 0; iEntry < nEntries; iEntry++ )
+		{
+		if ( !readZipCentralEntry(fpSource, nCDPos, oEntry) )
+			{ return false; }
+		nCDPos += 46 + oEntry.sName.size() + oEntry.abyExtra.size() + oEntry.abyComment.size();
+
+		GUIntBig nNewOffset = anNewOffsets[(size_t) iEntry];
+
+		if ( oEntry.nZip64OffsetPos >= 0 )
+			{ writeUIntToBuffer(&oEntry.abyExtra[oEntry.nZip64OffsetPos], nNewOffset, 8); }
+		else if ( nNewOffset >= 0xFFFFFFFF )
+			{
+			::CPLError(CE_Failure, CPLE_NotSupported, "The renamed entry \"%s\" would need a ZIP64 offset", oEntry.sName.c_str());
+			return false;
+			}
+		else
+			{ writeUIntToBuffer(oEntry.abyHeader + 42, nNewOffset, 4); }
+
+		std::map<std::string, std::string>::const_iterator it = oRenames.find(oEntry.sName);
+		if ( it != oRenames.end() )
+			{
+			oEntry.sName = it->second;
+			oEntry.abyExtra = removeZipUnicodePath(oEntry.abyExtra);
+			}
+
+		writeUIntToBuffer(oEntry.abyHeader + 28, oEntry.sName.size(), 2);
+		writeUIntToBuffer(oEntry.abyHeader + 30, oEntry.abyExtra.size(), 2);
+
+		if ( ::VSIFWriteL(oEntry.abyHeader, 1, 46, fpTarget) != 46 ||
+			 ( !oEntry.sName.empty() && ::VSIFWriteL(oEntry.sName.data(), 1, oEntry.sName.size(), fpTarget) != oEntry.sName.size() ) ||
+			 ( !oEntry.abyExtra.empty() && ::VSIFWriteL(&oEntry.abyExtra[0], 1, oEntry.abyExtra.size(), fpTarget) != oEntry.abyExtra.size() ) ||
+			 ( !oEntry.abyComment.empty() && ::VSIFWriteL(&oEntry.abyComment[0], 1, oEntry.abyComment.size(), fpTarget) != oEntry.abyComment.size() ) )
+			{ return false; }
+		}
+
+	GUIntBig nNewCDSize = ::VSIFTellL(fpTarget) - nNewCDOffset;
+	GByte *pabyEOCD = &abyTail[nEOCD];
+
+	//ZIP64 end record (without its extensible data) and its locator
+	if ( bZip64 )
+		{
+		GByte abyLocator[20];
+
+		writeUIntToBuffer(abyZip64EOCD + 4, 44, 8);
+		writeUIntToBuffer(abyZip64EOCD + 40, nNewCDSize, 8);
+		writeUIntToBuffer(abyZip64EOCD + 48, nNewCDOffset, 8);
+		writeUIntToBuffer(abyLocator, 0x07064b50, 4);
+		writeUIntToBuffer(abyLocator + 4, 0, 4);
+		writeUIntToBuffer(abyLocator + 8, ::VSIFTellL(fpTarget), 8);
+		writeUIntToBuffer(abyLocator + 16, 1, 4);
+
+		if ( ::VSIFWriteL(abyZip64EOCD, 1, 56, fpTarget) != 56 || ::VSIFWriteL(abyLocator, 1, 20, fpTarget) != 20 )
+			{ return false; }
+		}
+	else if ( nNewCDOffset >= 0xFFFFFFFF || nNewCDSize >= 0xFFFFFFFF )
+		{
+		::CPLError(CE_Failure, CPLE_NotSupported, "The renamed archive would need ZIP64 records");
+		return false;
+		}
+
+	writeUIntToBuffer(pabyEOCD + 12, std::min<GUIntBig>(nNewCDSize, 0xFFFFFFFF), 4);
+	writeUIntToBuffer(pabyEOCD + 16, std::min<GUIntBig>(nNewCDOffset, 0xFFFFFFFF), 4);
+
+	return ::VSIFWriteL(pabyEOCD, 1, nTailSize - nEOCD, fpTarget) == nTailSize - nEOCD;
+	}
+
+//***********************************************************************//
+//!Value of a TAR header number field : octal, or base-256 for the large
+//!values (GNU)
+//***********************************************************************//
+static GUIntBig readTarNumber(const GByte *pabyField, int nLength)
+	{
+	GUIntBig nValue = 0;
+
+	if ( pabyField[0] & 0x80 )
+		{
+		nValue = pabyField[0] & 0x7F;
+		for( int i = 1; i < nLength; i++ )
+			{ nValue = (nValue << 8) | pabyField[i]; }
+		return nValue;
+		}
+
+	for( int i = 0; i < nLength; i++ )
+		{
+		if ( pabyField[i] >= '0' && pabyField[i] <= '7' )
+			{ nValue = (nValue << 3) | (GUIntBig)( pabyField[i] - '0' ); }
+		else if ( pabyField[i] != ' ' || nValue != 0 )
+			{ break; }
+		}
+
+	return nValue;
+	}
+
+//***********************************************************************//
+//!Sum of a TAR header, its checksum field counted as spaces
+//***********************************************************************//
+static unsigned int getTarChecksum(const GByte *pabyHeader)
+	{
+	unsigned int nSum = 8 * ' ';
+
+	for( int i = 0; i < 512; i++ )
+		{
+		if ( i < 148 || i >= 156 )
+			{ nSum += pabyHeader[i]; }
+		}
+
+	return nSum;
+	}
+
+//***********************************************************************//
+//!Write a TAR header and its data (padded to 512 bytes), the size and
+//!checksum fields are set
+//***********************************************************************//
+static bool writeTarEntry(VSILFILE *fpTarget, GByte *pabyHeader, const std::string& sData)
+	{
+	size_t nPadding = ( 512 - sData.size() % 512 ) % 512;
+	std::string sPadding(nPadding, '\0');
+
+	snprintf( (char *) pabyHeader + 124, 12, "%011o", (unsigned int) sData.size() );
+	snprintf( (char *) pabyHeader + 148, 8, "%06o", getTarChecksum(pabyHeader) );
+	pabyHeader[155] = ' ';
+
+	return ::VSIFWriteL(pabyHeader, 1, 512, fpTarget) == 512 &&
+		   ::VSIFWriteL(sData.data(), 1, sData.size(), fpTarget) == sData.size() &&
+		   ::VSIFWriteL(sPadding.data(), 1, nPadding, fpTarget) == nPadding;
+	}
+
+//***********************************************************************//
+//!Set the name of a TAR header, split in the prefix field of the POSIX
+//!headers if longer than 100 characters. False if it does not fit (a
+//!GNU long name or pax path is needed), the name field is then truncated
+//***********************************************************************//
+static bool setTarName(GByte *pabyHeader, const std::string& sName)
+	{
+	bool bPosix = ( memcmp(pabyHeader + 257, "ustar\0", 6) == 0 );
+	size_t nSplit = std::string::npos;
+
+	if ( sName.size() > 100 && bPosix )
+		{
+		nSplit = sName.find('/', sName.size() > 101 ? sName.size() - 101 : 0);
+		if ( nSplit != std::string::npos && ( nSplit > 155 || nSplit + 1 == sName.size() ) )
+			{ nSplit = std::string::npos; }
+		}
+
+	const std::string sShortName = ( nSplit != std::string::npos ) ? sName.substr(nSplit + 1) : sName;
+
+	memset(pabyHeader, 0, 100);
+	memcpy(pabyHeader, sShortName.data(), std::min<size_t>(sShortName.size(), 100));
+	if ( bPosix )
+		{
+		memset(pabyHeader + 345, 0, 155);
+		if ( nSplit != std::string::npos )
+			{ memcpy(pabyHeader + 345, sName.data(), nSplit); }
+		}
+
+	return sShortName.size() <= 100;
+	}
+
+//***********************************************************************//
+//!Remove a record of pax extended header data, and return its value
+//***********************************************************************//
+static std::string removePaxRecord(std::string& sPaxData, const char* pszKey, bool* pbFound)
+	{
+	std::string sKept, sValue;
+	size_t nPos = 0;
+
+	*pbFound = false;
+	while ( nPos < sPaxData.size() )
+		{
+		size_t nLength = (size_t) atoi(sPaxData.c_str() + nPos);
+		size_t nSpace = sPaxData.find(' ', nPos);
+		size_t nEqual = sPaxData.find('=', nPos);
+
+		if ( nLength == 0 || nPos + nLength > sPaxData.size() || nSpace == std::string::npos || nEqual == std::string::npos ||
+			 nEqual > nPos + nLength )
+			{ break; }
+
+		if ( sPaxData.compare(nSpace + 1, nEqual - nSpace - 1, pszKey) == 0 )
+			{
+			*pbFound = true;
+			sValue = sPaxData.substr(nEqual + 1, nPos + nLength - nEqual - 2);
+			}
+		else
+			{ sKept += sPaxData.substr(nPos, nLength); }
+
+		nPos += nLength;
+		}
+
+	sPaxData = sKept + sPaxData.substr(std::min(nPos, sPaxData.size()));
+	return sValue;
+	}
+
+//***********************************************************************//
+//!Format a pax extended header record ("length key=value\n")
+//***********************************************************************//
+static std::string formatPaxRecord(const char* pszKey, const std::string& sValue)
+	{
+	size_t nLength = strlen(pszKey) + sValue.size() + 3;
+	size_t nDigits = 1;
+
+	while ( CPLSPrintf("%d", (int)( nLength + nDigits ))[nDigits] != '\0' )
+		{ nDigits++; }
+
+	return CPLSPrintf("%d %s=", (int)( nLength + nDigits ), pszKey) + sValue + "\n";
+	}
+
+//***********************************************************************//
+//!Write a TAR archive with the entries of fpSource renamed : the headers
+//!get the new names (prefix field, pax path or GNU long name when longer
+//!than 100 characters) and the data is copied as it is
+//***********************************************************************//
+static bool rewriteTarArchive(VSILFILE *fpSource, VSILFILE *fpTarget, const std::map<std::string, std::string>& oRenames)
+	{
+	std::vector<GByte> abyBuffer(GDAL_RENAME_ARCHIVE_CHUNK);
+	GByte abyHeader[512], abyLongNameHeader[512], abyPaxHeader[512];
+	std::string sLongName, sPaxData;
+	bool bHasLongName = false, bHasPax = false;
+
+	while ( true )
+		{
+		if ( ::VSIFReadL(abyHeader, 1, 512, fpSource) != 512 )
+			{ return false; }
+
+		//end of archive : two zero blocks
+		if ( std::count(abyHeader, abyHeader + 512, 0) == 512 )
+			{
+			std::string sEnd(1024, '\0');
+			return ::VSIFWriteL(sEnd.data(), 1, sEnd.size(), fpTarget) == sEnd.size();
+			}
+
+		if ( getTarChecksum(abyHeader) != readTarNumber(abyHeader + 148, 8) )
+			{
+			::CPLError(CE_Failure, CPLE_AppDefined, "Invalid TAR header checksum");
+			return false;
+			}
+
+		GUIntBig nSize = readTarNumber(abyHeader + 124, 12);
+		GUIntBig nPaddedSize = ( nSize + 511 ) / 512 * 512;
+		char chType = (char) abyHeader[156];
+
+		//GNU long name and pax extended header of the next entry
+		if ( chType == 'L' || chType == 'x' )
+			{
+			if ( nSize > GDAL_RENAME_ARCHIVE_CHUNK )
+				{ return false; }
+
+			std::string sData( (size_t) nPaddedSize, '\0' );
+			if ( nPaddedSize > 0 && ::VSIFReadL(&sData[0], 1, sData.size(), fpSource) != sData.size() )
+				{ return false; }
+			sData.resize( (size_t) nSize );
+
+			if ( chType == 'L' )
+				{
+				sLongName = sData.c_str();
+				bHasLongName = true;
+				memcpy(abyLongNameHeader, abyHeader, 512);
+				}
+			else
+				{
+				sPaxData = sData;
+				bHasPax = true;
+				memcpy(abyPaxHeader, abyHeader, 512);
+				}
+			continue;
+			}
+
+		bool bPaxPath = false;
+		std::string sPaxKept = sPaxData;
+		std::string sName = removePaxRecord(sPaxKept, "path", &bPaxPath);
+
+		if ( !bPaxPath && bHasLongName )
+			{ sName = sLongName; }
+		else if ( !bPaxPath )
+			{
+			sName.assign( (const char *) abyHeader, strnlen((const char *) abyHeader, 100) );
+			if ( memcmp(abyHeader + 257, "ustar\0", 6) == 0 && abyHeader[345] != '\0' )
+				{ sName = std::string( (const char *) abyHeader + 345, strnlen((const char *) abyHeader + 345, 155) ) + "/" + sName; }
+			}
+
+		std::map<std::string, std::string>::const_iterator it = oRenames.find(sName);
+		bool bFits = true;
+
+		if ( it != oRenames.end() )
+			{
+			bFits = setTarName(abyHeader, it->second);
+
+			if ( bHasPax )
+				{ sPaxData = bFits ? sPaxKept : sPaxKept + formatPaxRecord("path", it->second); }
+			}
+
+		if ( bHasPax && !writeTarEntry(fpTarget, abyPaxHeader, sPaxData) )
+			{ return false; }
+
+		//a GNU long name when the name does not fit and there is no pax header
+		if ( it != oRenames.end() && !bFits && !bHasPax )
+			{
+			if ( !bHasLongName )
+				{
+				memset(abyLongNameHeader, 0, 512);
+				strcpy( (char *) abyLongNameHeader, "././@LongLink" );
+				strcpy( (char *) abyLongNameHeader + 100, "0000644" );
+				abyLongNameHeader[156] = 'L';
+				memcpy(abyLongNameHeader + 257, "ustar  ", 8);
+				}
+
+			if ( !writeTarEntry(fpTarget, abyLongNameHeader, it->second + std::string(1, '\0')) )
+				{ return false; }
+			}
+		else if ( it == oRenames.end() && bHasLongName &&
+				  !writeTarEntry(fpTarget, abyLongNameHeader, sLongName + std::string(1, '\0')) )
+			{ return false; }
+
+		if ( it != oRenames.end() )
+			{
+			snprintf( (char *) abyHeader + 148, 8, "%06o", getTarChecksum(abyHeader) );
+			abyHeader[155] = ' ';
+			}
+
+		if ( ::VSIFWriteL(abyHeader, 1, 512, fpTarget) != 512 ||
+			 !copyArchiveBytes(fpSource, fpTarget, nPaddedSize, abyBuffer) )
+			{ return false; }
+
+		countRunStats(COUNTER_ARCHIVE_ENTRIES);
+		bHasLongName = false;
+		bHasPax = false;
+		sPaxData.clear();
+		}
+	}
+
+//***********************************************************************//
+//!Rename the datasets of a ZIP or TAR archive (and their sibling files)
+//!after their georeferencing, read through /vsizip/ or /vsitar/. A new
+//!archive is written next to it with the entries renamed, without
+//!recompression and in bounded memory, synced then renamed over it.
+//!nRenamed and nFailures receive the numbers of datasets
+//***********************************************************************//
+bool renameArchive(const char* pszArchivePath, char** papszExtensions, const RenameOptions& oOptions, int& nRenamed, int& nFailures)
+	{
+	bool bZip = EQUAL(::CPLGetExtension(pszArchivePath), "zip");
+	std::string sVSIPath = std::string(bZip ? "/vsizip/" : "/vsitar/") + pszArchivePath;
+	std::map<std::string, std::string> oRenames;
+	int nSiblings = 0;
+
+	nRenamed = 0;
+	nFailures = 0;
+
+	listArchiveRenames(sVSIPath, papszExtensions, oOptions, oRenames, nRenamed, nSiblings, nFailures);
+
+	bool bSuccess = true;
+
+	if ( !oRenames.empty() )
+		{
+		std::string sTransferPath = getTransferPath(pszArchivePath);
+		::VSIStatBufL psStatBuf;
+		VSILFILE *fpSource = ::VSIFOpenL(pszArchivePath, "rb");
+		VSILFILE *fpTarget = NULL;
+
+		if ( fpSource != NULL && ::VSIStatL(sTransferPath.c_str(), &psStatBuf) != 0 )
+			{ fpTarget = ::VSIFOpenL(sTransferPath.c_str(), "wb"); }
+
+			{
+			PhaseTimer oTimer(PHASE_ARCHIVE_WRITE);
+			bSuccess = fpTarget != NULL && ( bZip ? rewriteZipArchive(fpSource, fpTarget, oRenames) : rewriteTarArchive(fpSource, fpTarget, oRenames) );
+			}
+
+		if ( fpSource != NULL )
+			{ ::VSIFCloseL(fpSource); }
+		if ( fpTarget != NULL )
+			{ bSuccess = ( ::VSIFCloseL(fpTarget) == 0 ) && bSuccess; }
+
+		//the new archive is durable before it replaces the old one
+		if ( bSuccess )
+			{
+#ifndef _WIN32
+			if ( ::VSIStatL(pszArchivePath, &psStatBuf) == 0 )
+				{ chmod(sTransferPath.c_str(), psStatBuf.st_mode & 07777); }
+#endif
+			syncPath(sTransferPath);
+			countRunStats(COUNTER_RENAME_CALLS);
+			bSuccess = ( ::VSIRename(sTransferPath.c_str(), pszArchivePath) == 0 );
+			}
+
+		if ( bSuccess )
+			{ syncPath(::CPLGetDirname(pszArchivePath)); }
+		else
+			{
+			if ( fpTarget != NULL )
+				{ ::VSIUnlink(sTransferPath.c_str()); }
+			countRunStats(COUNTER_FAILED_ARCHIVE);
+			::CPLError(CE_Failure, CPLE_FileIO, "Unable to rewrite the archive \"%s\", left unchanged", pszArchivePath);
+			nFailures += nRenamed;
+			nRenamed = 0;
+			nSiblings = 0;
+			}
+		}
+
+	countRunStats(COUNTER_DATASETS_RENAMED, nRenamed);
+	countRunStats(COUNTER_SIBLINGS_RENAMED, nSiblings);
+	countRunStats(COUNTER_DATASETS_FAILED, nFailures);
+
+	return bSuccess && nFailures == 0;
+	}
+
+//***********************************************************************//
+//!Options and state of a GDALRenamer, hidden to keep the API layout
+//!stable : the option values are kept by name and turned into the
+//!RenameOptions of the command line by Prepare()
+//***********************************************************************//
+struct GDALRenamer::Private
+	{
+	std::map<std::string, std::string>	oValues;	//options set, by name
+	RenameOptions		oOptions;
+	NameTemplate		oNameTemplate;
+	TileGrid			oTileGrid;
+	SiblingIndex		oSiblingIndex;
+	CommandWriter		oCommandWriter;		//"output-console" commands, written by each Rename call
+	ReprojectionCache	*poReprojectionCache;	//created once prepared, with "target-srs"
+	bool				bPrepared;
+
+	//no directory read : the files of a long running process change between the calls
+	Private() : oSiblingIndex(false), poReprojectionCache(NULL), bPrepared(false) {}
+	~Private() { delete poReprojectionCache; }
+
+	const char* GetValue(const char* pszName, const char* pszDefault) const;
+	bool Prepare(std::string& sError);
+	bool Ready();
+	bool ComputeName(const char* pszFilePath, const DatasetGeoRef& oGeoRef, const std::string& sSRS, std::string& sNewFileName);
+	};
+
+//!Options of a GDALRenamer : the command line long names without the dashes
+static const char* const apszRenamerOptions[] = {
+	"refpoint", "coord-zero-padding", "coord-length", "coord-decimal-length", "coord-type", "coord-sign",
+	"coord-sep", "prefix", "suffix", "printf-syntax", "name-template", "target-srs", "grid", "offgrid-suffix",
+	"output-console", "fast-georef", "plan", "output-dir", "transfer-threads", NULL };
+
+//***********************************************************************//
+//!Value of an option, pszDefault if not set
+//***********************************************************************//
+const char* GDALRenamer::Private::GetValue(const char* pszName, const char* pszDefault) const
+	{
+	std::map<std::string, std::string>::const_iterator it = oValues.find(pszName);
+
+	return it == oValues.end() ? pszDefault : it->second.c_str();
+	}
+
+//***********************************************************************//
+//!Turn the options into RenameOptions and compile the naming, with the
+//!checks of the command line
+//***********************************************************************//
+bool GDALRenamer::Private::Prepare(std::string& sError)
+	{
+	RenameOptions oDefaults;
+
+	bPrepared = false;
+	oOptions = oDefaults;
+	oTileGrid = TileGrid();
+	delete poReprojectionCache;
+	poReprojectionCache = NULL;
+
+	oOptions.pszCoordRefPoint	= GetValue("refpoint", oOptions.pszCoordRefPoint);
+	oOptions.pszCoordPadding	= ::CPLTestBool(GetValue("coord-zero-padding", "YES")) != FALSE;
+	oOptions.pszCoordLenght		= GetValue("coord-length", oOptions.pszCoordLenght);
+	oOptions.pszCoordDecLenght	= GetValue("coord-decimal-length", oOptions.pszCoordDecLenght);
+	oOptions.pszCoordType		= GetValue("coord-type", oOptions.pszCoordType);
+	oOptions.pszCoordSignType	= GetValue("coord-sign", oOptions.pszCoordSignType);
+	oOptions.pszCoordSep		= GetValue("coord-sep", oOptions.pszCoordSep);
+	oOptions.pszPrefix			= GetValue("prefix", oOptions.pszPrefix);
+	oOptions.pszSuffix			= GetValue("suffix", oOptions.pszSuffix);
+	oOptions.pszPrintf			= GetValue("printf-syntax", oOptions.pszPrintf);
+	oOptions.pszNameTemplate	= GetValue("name-template", oOptions.pszNameTemplate);
+	oOptions.pszTargetSRS		= GetValue("target-srs", NULL);
+	oOptions.pszOffGridSuffix	= GetValue("offgrid-suffix", oOptions.pszOffGridSuffix);
+	oOptions.pszOutputConsole	= GetValue("output-console", oOptions.pszOutputConsole);
+	oOptions.bFastGeoRef		= ::CPLTestBool(GetValue("fast-georef", "YES")) != FALSE;
+	oOptions.bPlanRenames		= ::CPLTestBool(GetValue("plan", "NO")) != FALSE;
+	oOptions.pszOutputDir		= GetValue("output-dir", NULL);
+	oOptions.nTransferThreads	= std::max(1, atoi(GetValue("transfer-threads", "4")));
+
+	if ( !checkRefPoint(oOptions.pszCoordRefPoint) )
+		{
+		sError = CPLSPrintf("Invalid reference point '%s'", oOptions.pszCoordRefPoint);
+		return false;
+		}
+
+	if ( !EQUAL(oOptions.pszOutputConsole, "") )
+		{
+		if ( !oCommandWriter.Open(oOptions.pszOutputConsole, stdout) )
+			{
+			sError = CPLSPrintf("Unknown output console format '%s'", oOptions.pszOutputConsole);
+			return false;
+			}
+		oOptions.poCommandWriter = &oCommandWriter;
+		}
+
+	::VSIStatBufL psStatBuf;
+	if ( oOptions.pszOutputDir != NULL &&
+		 ( ::VSIStatExL(oOptions.pszOutputDir, &psStatBuf, VSI_STAT_EXISTS_FLAG | VSI_STAT_NATURE_FLAG) != 0 || !VSI_ISDIR(psStatBuf.st_mode) ) )
+		{
+		sError = CPLSPrintf("Output directory '%s' does not exist", oOptions.pszOutputDir);
+		return false;
+		}
+
+	if ( oOptions.bPlanRenames && oOptions.pszOutputDir != NULL )
+		{
+		sError = "\"plan\" orders the renames in place, it can't be used with \"output-dir\"";
+		return false;
+		}
+
+	const char *pszGrid = GetValue("grid", NULL);
+	if ( pszGrid != NULL && !parseTileGrid(pszGrid, oTileGrid) )
+		{
+		sError = CPLSPrintf("Invalid tiles grid '%s'", pszGrid);
+		return false;
+		}
+
+	//the grid is only inferred from a whole batch by the command line
+	if ( oTileGrid.bInfer )
+		{
+		sError = "The tiles grid can't be inferred (\"auto\") by the library, give origin_x,origin_y,tile_size_x,tile_size_y";
+		return false;
+		}
+
+	oOptions.poTileGrid = &oTileGrid;
+	if ( !oNameTemplate.Compile(oOptions, sError) )
+		{ return false; }
+	oOptions.poNameTemplate = &oNameTemplate;
+
+	if ( oNameTemplate.HasGridFields() && !oTileGrid.bValid )
+		{
+		sError = "{col} and {row} need an explicit grid (origin_x,origin_y,tile_size_x,tile_size_y)";
+		return false;
+		}
+
+	if ( oOptions.pszTargetSRS != NULL )
+		{
+		OGRSpatialReferenceH hTargetSRS = ::OSRNewSpatialReference(NULL);
+		bool bValidSRS = ( ::OSRSetFromUserInput(hTargetSRS, oOptions.pszTargetSRS) == OGRERR_NONE );
+
+		::OSRDestroySpatialReference(hTargetSRS);
+		if ( !bValidSRS )
+			{
+			sError = CPLSPrintf("Unrecognized target SRS '%s'", oOptions.pszTargetSRS);
+			return false;
+			}
+
+		poReprojectionCache = new ReprojectionCache(oOptions.pszTargetSRS);
+		}
+
+	bPrepared = true;
+	return true;
+	}
+
+//***********************************************************************//
+//!Prepare the options if not done yet, the error is reported by CPLError
+//***********************************************************************//
+bool GDALRenamer::Private::Ready()
+	{
+	std::string sError;
+
+	if ( bPrepared )
+		{ return true; }
+
+	if ( !Prepare(sError) )
+		{
+		::CPLError(CE_Failure, CPLE_IllegalArg, "%s", sError.c_str());
+		return false;
+		}
+
+	return true;
+	}
+
+//***********************************************************************//
+//!New name of a georeferencing, as a name group of one dataset
+//***********************************************************************//
+bool GDALRenamer::Private::ComputeName(const char* pszFilePath, const DatasetGeoRef& oGeoRef, const std::string& sSRS, std::string& sNewFileName)
+	{
+	NameGroup oGroup;
+
+	oGroup.aoJobs.resize(1);
+	oGroup.aoJobs[0].sFilePath = pszFilePath;
+	oGroup.oExtents.Add(oGeoRef);
+
+	renderNameGroup(oGroup, sSRS, poReprojectionCache, oOptions);
+
+	sNewFileName = oGroup.aoJobs[0].sNewFileName;
+	if ( oGroup.aoJobs[0].bSuccess && sNewFileName.empty() )
+		{
+		::CPLError(CE_Failure, CPLE_AppDefined, "Empty new name computed for \"%s\"", pszFilePath);
+		return false;
+		}
+
+	return oGroup.aoJobs[0].bSuccess;
+	}
+
+GDALRenamer::GDALRenamer() : psPrivate(new Private())
+	{
+	}
+
+GDALRenamer::~GDALRenamer()
+	{
+	delete psPrivate;
+	}
+
+//***********************************************************************//
+//!Set an option (command line long name without the dashes, "YES"/"NO"
+//!for the switches), NULL value to unset it. Applied by the next call
+//***********************************************************************//
+bool GDALRenamer::SetOption(const char* pszName, const char* pszValue)
+	{
+	for( int i = 0; apszRenamerOptions[i] != NULL; i++ )
+		{
+		if ( !EQUAL(pszName, apszRenamerOptions[i]) )
+			{ continue; }
+
+		if ( pszValue == NULL )
+			{ psPrivate->oValues.erase(apszRenamerOptions[i]); }
+		else
+			{ psPrivate->oValues[apszRenamerOptions[i]] = pszValue; }
+
+		psPrivate->bPrepared = false;
+		return true;
+		}
+
+	::CPLError(CE_Failure, CPLE_IllegalArg, "Unknown gdal_rename option '%s'", pszName);
+	return false;
+	}
+
+//***********************************************************************//
+//!Check the options and compile the naming, sError set on failure
+//***********************************************************************//
+bool GDALRenamer::Prepare(std::string& sError)
+	{
+	return psPrivate->Prepare(sError);
+	}
+
+//***********************************************************************//
+//!New name from a geotransform and a raster size
+//***********************************************************************//
+bool GDALRenamer::ComputeName(const double* padfGeoTransform, int nRasterXSize, int nRasterYSize, const char* pszSRS, std::string& sNewFileName)
+	{
+	DatasetGeoRef oGeoRef;
+
+	if ( !psPrivate->Ready() )
+		{ return false; }
+
+	memcpy(oGeoRef.adfGeoTransform, padfGeoTransform, sizeof(oGeoRef.adfGeoTransform));
+	oGeoRef.nRasterXSize = nRasterXSize;
+	oGeoRef.nRasterYSize = nRasterYSize;
+
+	return psPrivate->ComputeName("", oGeoRef, pszSRS != NULL ? pszSRS : "", sNewFileName);
+	}
+
+//***********************************************************************//
+//!New name of an open dataset
+//***********************************************************************//
+bool GDALRenamer::ComputeName(GDALDataset* poDataset, std::string& sNewFileName)
+	{
+	DatasetGeoRef oGeoRef;
+	std::string sSRS;
+
+	if ( !psPrivate->Ready() )
+		{ return false; }
+
+	if ( poDataset->GetGeoTransform(oGeoRef.adfGeoTransform) != CE_None )
+		{
+		::CPLError(CE_Failure, CPLE_AppDefined, "No georeferencing found in the dataset \"%s\"", poDataset->GetDescription());
+		return false;
+		}
+
+	oGeoRef.nRasterXSize = poDataset->GetRasterXSize();
+	oGeoRef.nRasterYSize = poDataset->GetRasterYSize();
+	if ( psPrivate->oOptions.pszTargetSRS != NULL && poDataset->GetProjectionRef() != NULL )
+		{ sSRS = poDataset->GetProjectionRef(); }
+
+	return psPrivate->ComputeName(poDataset->GetDescription(), oGeoRef, sSRS, sNewFileName);
+	}
+
+//***********************************************************************//
+//!New name of a dataset file
+//***********************************************************************//
+bool GDALRenamer::ComputeName(const char* pszFilePath, std::string& sNewFileName)
+	{
+	DatasetGeoRef oGeoRef;
+	std::string sSRS;
+
+	if ( !psPrivate->Ready() )
+		{ return false; }
+
+	if ( !readDatasetGeoRef(pszFilePath, psPrivate->oOptions, psPrivate->oSiblingIndex, oGeoRef,
+							psPrivate->oOptions.pszTargetSRS != NULL ? &sSRS : NULL) )
+		{ return false; }
+
+	return psPrivate->ComputeName(pszFilePath, oGeoRef, sSRS, sNewFileName);
+	}
+
+//***********************************************************************//
+//!Existing sibling files of a dataset, renamed with it
+//***********************************************************************//
+std::vector<std::string> GDALRenamer::GetSiblingFiles(const char* pszFilePath)
+	{
+	std::vector<RenameOperation> aoOps;
+	std::vector<std::string> asSiblingFiles;
+
+	listRenameOperations(pszFilePath, ::CPLGetBasename(pszFilePath), NULL, 0, psPrivate->oSiblingIndex, aoOps);
+
+	for( size_t i = 0; i < aoOps.size(); i++ )
+		{
+		if ( !aoOps[i].bMainFile )
+			{ asSiblingFiles.push_back(aoOps[i].sSourcePath); }
+		}
+
+	return asSiblingFiles;
+	}
+
+//***********************************************************************//
+//!Rename a dataset and its sibling files (or print the commands to do it
+//!with "output-console")
+//***********************************************************************//
+bool GDALRenamer::Rename(const char* pszFilePath, const std::string& sNewFileName)
+	{
+	if ( !psPrivate->Ready() )
+		{ return false; }
+
+	bool bSuccess = applyRename(pszFilePath, sNewFileName, psPrivate->oOptions, psPrivate->oSiblingIndex);
+
+	psPrivate->oCommandWriter.Flush();
+	return bSuccess;
+	}
+
+//***********************************************************************//
+//!Rename a batch of datasets, the renames of the batch are ordered (and
+//!their cycles broken) by the planner with the "plan" option
+//***********************************************************************//
+bool GDALRenamer::Rename(const std::vector<std::string>& asFilePaths, const std::vector<std::string>& asNewFileNames, std::vector<bool>& abSuccess)
+	{
+	std::vector<RenameJob> aoJobs(asFilePaths.size());
+	bool bSuccess = true;
+
+	abSuccess.assign(asFilePaths.size(), false);
+	if ( asFilePaths.size() != asNewFileNames.size() )
+		{
+		::CPLError(CE_Failure, CPLE_IllegalArg, "%d paths for %d new names", (int) asFilePaths.size(), (int) asNewFileNames.size());
+		return false;
+		}
+
+	if ( !psPrivate->Ready() )
+		{ return false; }
+
+	for( size_t i = 0; i < aoJobs.size(); i++ )
+		{
+		aoJobs[i].sFilePath = asFilePaths[i];
+		aoJobs[i].sNewFileName = asNewFileNames[i];
+		aoJobs[i].bSuccess = true;
+		}
+
+	applyRenames(aoJobs, psPrivate->oOptions, psPrivate->oSiblingIndex);
+	psPrivate->oCommandWriter.Flush();
+
+	for( size_t i = 0; i < aoJobs.size(); i++ )
+		{
+		abSuccess[i] = aoJobs[i].bSuccess;
+		bSuccess = bSuccess && aoJobs[i].bSuccess;
+		}
+
+	return bSuccess;
+	}
+
+//***********************************************************************//
+//!Compute the new name of a dataset file and rename it with its siblings
+//***********************************************************************//
+bool GDALRenamer::RenameDataset(const char* pszFilePath)
+	{
+	std::string sNewFileName;
+
+	if ( !ComputeName(pszFilePath, sNewFileName) )
+		{ return false; }
+
+	return Rename(pszFilePath, sNewFileName);
+	}
+
+//***********************************************************************//
+//!Rename the datasets inside a ZIP or TAR archive and their sibling
+//!entries, the archive is rewritten next to it then replaces it
+//***********************************************************************//
+bool GDALRenamer::RenameArchive(const char* pszArchivePath, const char* pszExtensions)
+	{
+	if ( !psPrivate->Ready() )
+		{ return false; }
+
+	//the archive is rewritten at once, in place
+	if ( !EQUAL(psPrivate->oOptions.pszOutputConsole, "") || psPrivate->oOptions.bPlanRenames || psPrivate->oOptions.pszOutputDir != NULL )
+		{
+		::CPLError(CE_Failure, CPLE_IllegalArg, "An archive is rewritten at once, it can't be renamed with \"output-console\", \"plan\" or \"output-dir\"");
+		return false;
+		}
+
+	char **papszExtensions = ::CSLTokenizeString2(pszExtensions, ",", 0);
+	int nRenamed = 0, nFailures = 0;
+	bool bSuccess = renameArchive(pszArchivePath, papszExtensions, psPrivate->oOptions, nRenamed, nFailures);
+
+	::CSLDestroy(papszExtensions);
+	return bSuccess;
+	}
@@ -0,0 +1,75 @@
+//##################################################################################//
+//									gdal_rename_lib									//
+//**********************************************************************************//
+// Desc: Stable C++ API of the gdal_rename library, to rename datasets in process	//
+//		 (ie: from an ingest service) without spawning gdal_rename for each file	//
+//		 nor registering the GDAL drivers again. Build gdal_rename_lib.cpp with	//
+//		 the application (or as a library) and link it with GDAL.					//
+//		 																			//
+// Author: 	Mathieu Lattes (mathieu dot lattes at yahoo dot fr)						//
+//																					//
+// Version:	see gdal_rename.cpp														//
+//##################################################################################//
+
+#ifndef GDAL_RENAME_LIB_H_INCLUDED
+#define GDAL_RENAME_LIB_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+class GDALDataset;
+
+//!Version of the API, incremented when methods or options are added
+#define GDAL_RENAME_LIB_VERSION	3
+
+//!Rename datasets and their sibling files after the coordinates of their
+//!georeferencing, with the naming and rename options of the gdal_rename
+//!command line. The options are set by name (the command line long names
+//!without the dashes, ie: "name-template", "refpoint", "target-srs",
+//!"grid", "plan", "output-dir"...) so new options don't change the class
+//!layout.
+//!The GDAL drivers are registered by the application (GDALAllRegister,
+//!once). Errors are reported with CPLError, nothing is printed but the
+//!commands of "output-console" (stdout). Not thread safe : the rename
+//!backend, journal, run statistics and directories caches of the rename
+//!library are process wide, only one GDALRenamer can be used per process
+class GDALRenamer
+	{
+	public:
+		GDALRenamer();
+		~GDALRenamer();
+
+		//!Set a naming or rename option, false if unknown
+		bool SetOption(const char* pszName, const char* pszValue);
+		//!Compile and check the naming, done by the first call otherwise
+		bool Prepare(std::string& sError);
+
+		//!New name (without directory nor extension) from a geotransform and raster size, pszSRS only used with "target-srs"
+		bool ComputeName(const double* padfGeoTransform, int nRasterXSize, int nRasterYSize, const char* pszSRS, std::string& sNewFileName);
+		//!New name of an already open dataset
+		bool ComputeName(GDALDataset* poDataset, std::string& sNewFileName);
+		//!New name of a dataset file (georeferencing read from its headers when possible)
+		bool ComputeName(const char* pszFilePath, std::string& sNewFileName);
+
+		//!Sibling files of a dataset (world file, .prj...) renamed with it
+		std::vector<std::string> GetSiblingFiles(const char* pszFilePath);
+
+		//!Rename a dataset and its sibling files, the existing targets are backed up
+		bool Rename(const char* pszFilePath, const std::string& sNewFileName);
+		//!Rename a batch of datasets (planned together with the "plan" option), abSuccess per dataset
+		bool Rename(const std::vector<std::string>& asFilePaths, const std::vector<std::string>& asNewFileNames, std::vector<bool>& abSuccess);
+		//!Compute the new name of a dataset file and rename it
+		bool RenameDataset(const char* pszFilePath);
+		//!Rename the datasets of the given extensions inside a ZIP or TAR archive, rewritten without recompression
+		//!(in place, fails with "output-console", "plan" or "output-dir")
+		bool RenameArchive(const char* pszArchivePath, const char* pszExtensions = "tif,tiff,jp2,j2k,ecw,img");
+
+	private:
+		GDALRenamer(const GDALRenamer&);
+		GDALRenamer& operator=(const GDALRenamer&);
+
+		struct Private;
+		Private		*psPrivate;
+	};
+
+#endif //GDAL_RENAME_LIB_H_INCLUDED
@@ -0,0 +1,942 @@
+//##################################################################################//
+//									gdal_rename_priv								//
+//**********************************************************************************//
+// Desc: Internal declarations of the gdal_rename library (georeferencing readers,	//
+//		 name templates, sibling index, rename backends, planner, journal, caches	//
+//		 and batch pipeline), shared by gdal_rename_lib.cpp and the gdal_rename		//
+//		 command line. Not a stable API, see gdal_rename_lib.h for it.				//
+//		 																			//
+// Author: 	Mathieu Lattes (mathieu dot lattes at yahoo dot fr)						//
+//																					//
+// Version:	see gdal_rename.cpp														//
+//##################################################################################//
+
+#ifndef GDAL_RENAME_PRIV_H_INCLUDED
+#define GDAL_RENAME_PRIV_H_INCLUDED
+
+#include <iostream>
+
+#include "gdal_priv.h"
+#include "gdal_frmts.h"
+
+#include "cpl_error.h"
+#include "cpl_conv.h"
+#include "cpl_vsi.h"
+#include "cpl_string.h"
+#include "cpl_multiproc.h"
+#include "cpl_atomic_ops.h"
+
+#include "json_object.h"
+#include "ogr_srs_api.h"
+#include "ogrsf_frmts.h"
+
+#include "commonutils.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+//vector kernels of the batch name generation, scalar code otherwise
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define GDAL_RENAME_HAVE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GDAL_RENAME_HAVE_SSE2
+#endif
+
+//durable rename journal (fsync), memory mapped georeferencing cache and
+//drivers registration functions lookup (--drivers), rewritten archives
+//mode (--archive)
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+//nanoseconds of the modification times (georeferencing cache), a file
+//rewritten within the same second keeps its st_mtime
+#if defined(__linux__) || defined(__CYGWIN__)
+#define GDAL_RENAME_STAT_MTIME_NSEC(psStatBuf)	((psStatBuf).st_mtim.tv_nsec)
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#define GDAL_RENAME_STAT_MTIME_NSEC(psStatBuf)	((psStatBuf).st_mtimespec.tv_nsec)
+#else
+#define GDAL_RENAME_STAT_MTIME_NSEC(psStatBuf)	0
+#endif
+
+//atomic no overwrite renames (renameat2) and batched submission (io_uring)
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#ifdef SYS_renameat2
+#define GDAL_RENAME_HAVE_RENAMEAT2
+#ifndef RENAME_NOREPLACE
+#define RENAME_NOREPLACE	(1 << 0)
+#endif
+#ifndef RENAME_EXCHANGE
+#define RENAME_EXCHANGE		(1 << 1)
+#endif
+#endif
+#if defined(GDAL_RENAME_HAVE_RENAMEAT2) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#ifdef __NR_io_uring_enter
+#define GDAL_RENAME_HAVE_IO_URING
+#endif
+#endif
+#endif
+#endif
+
+//moves across file systems (--output-dir) : reflinks and in kernel copies
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#if defined(__has_include)
+#if __has_include(<linux/fs.h>)
+#include <linux/fs.h>
+#endif
+#endif
+#ifndef FICLONE
+#define FICLONE		_IOW(0x94, 9, int)
+#endif
+#define GDAL_RENAME_HAVE_KERNEL_COPY
+#endif
+
+//watch mode (--watch), directories events
+#ifdef __linux__
+#include <poll.h>
+#include <signal.h>
+#include <sys/inotify.h>
+#define GDAL_RENAME_HAVE_INOTIFY
+#endif
+
+//!OS dependant directory separator
+extern std::string  sDirSep;
+
+//!Georeferencing of a dataset : geotransform and raster size
+struct DatasetGeoRef
+	{
+	double	adfGeoTransform[6];
+	int		nRasterXSize;
+	int		nRasterYSize;
+	};
+
+//!Directories content read once, used to find the sibling files of the
+//!datasets and to check the rename targets without a stat call per file
+class SiblingIndex
+	{
+	public:
+		SiblingIndex(bool bReadDirectories);
+		~SiblingIndex();
+
+		bool Exists(const std::string& sFilePath);
+		bool FindSibling(const char* pszFilePath, const char* pszExt, std::string& sSiblingPath);
+		void Renamed(const std::string& sSourcePath, const std::string& sNewPath);
+		void TrackRenames();
+		bool IsRenamedPath(const std::string& sFilePath);
+
+		static std::string GetKey(const std::string& sFileName);
+
+	private:
+		struct DirectoryContent
+			{
+			bool												bIndexed;
+			std::unordered_set<std::string>						oFiles;				//file names
+			std::unordered_multimap<std::string, std::string>	oFilesByBasename;	//basename -> file names
+			};
+
+		DirectoryContent* GetDirectory(const std::string& sDirName);
+
+		bool									bReadDirectories;
+		bool									bTrackRenames;
+		std::unordered_set<std::string>			oRenamedPaths;	//new paths of the renames (--watch)
+		CPLMutex								*hMutex;
+		std::map<std::string, DirectoryContent*> oDirectories;
+		std::deque<std::string>					oDirectoriesOrder; //oldest first
+	};
+
+//!Phases of a run timed by the statistics (--stats)
+enum RunPhase
+	{
+	PHASE_DRIVER_REGISTRATION,	//GDALAllRegister
+	PHASE_DIRECTORY_WALK,		//inputs directories walked (VSIReadDirRecursive)
+	PHASE_DIRECTORY_READ,		//directories read by the sibling index (VSIReadDir)
+	PHASE_STAT,					//existence probes (VSIStatExL)
+	PHASE_CACHE_LOOKUP,			//georeferencing cache
+	PHASE_HEADER_READ,			//georeferencing read from the headers (fast path)
+	PHASE_OPEN,					//GDALOpen
+	PHASE_GEOTRANSFORM,			//GetGeoTransform and raster size
+	PHASE_CLOSE,				//GDALClose
+	PHASE_REPROJECT,			//coordinates transformed to the target SRS (--target-srs)
+	PHASE_NAME_FORMAT,			//name template rendering
+	PHASE_RENAME,				//renameat2, VSIRename or exchange of one file
+	PHASE_RENAME_BATCH,			//io_uring submission of a batch of renames
+	PHASE_JOURNAL_SYNC,			//journal and renamed directories fsync
+	PHASE_TILE_INDEX,			//tile index features written (--tile-index)
+	PHASE_TRANSFER,				//file copied across file systems (--output-dir)
+	PHASE_ARCHIVE_WRITE,		//archive rewritten with its entries renamed (--archive)
+	PHASE_DUPLICATE_CHECK,		//targets spilled, merged and reported (--check-duplicates)
+	PHASE_COUNT
+	};
+
+//!Counters of a run (--stats)
+enum RunCounter
+	{
+	COUNTER_DATASETS,				//datasets whose new name was computed
+	COUNTER_DATASETS_RENAMED,
+	COUNTER_DATASETS_FAILED,
+	COUNTER_DATASETS_SKIPPED,		//already renamed by the resumed run
+	COUNTER_SIBLINGS_RENAMED,
+	COUNTER_BACKUPS,				//existing files moved to their _OldOne name
+	COUNTER_CACHE_HITS,
+	COUNTER_FAST_GEOREF,			//georeferencing read from the headers
+	COUNTER_GDAL_OPEN,
+	COUNTER_HEADER_OPENS,			//headers and world files opened by the fast path
+	COUNTER_STAT_CALLS,
+	COUNTER_DIRECTORY_READS,
+	COUNTER_RENAME_CALLS,			//synchronous renames and exchanges
+	COUNTER_URING_SUBMITS,
+	COUNTER_FSYNC_CALLS,
+	COUNTER_TRANSFORMS,				//coordinate transformations created (--target-srs)
+	COUNTER_REPROJECT_CALLS,		//coordinates arrays transformed
+	COUNTER_OFFGRID,				//datasets not aligned on the tiles grid ({col} and {row} fields)
+	COUNTER_INDEXED,				//datasets written to the tile index
+	COUNTER_TRANSFERS,				//files moved across file systems (copy, sync and unlink)
+	COUNTER_REFLINKS,				//transfers done by a reflink (FICLONE)
+	COUNTER_ARCHIVE_ENTRIES,		//archive entries copied (--archive)
+	COUNTER_DUPLICATE_TARGETS,		//targets of several datasets (--check-duplicates)
+	COUNTER_EXISTING_TARGETS,		//targets held by a file out of the inventory (--check-duplicates)
+	COUNTER_CHECK_SPILLS,			//sorted runs written over the memory budget (--check-duplicates)
+	COUNTER_FAILED_OPEN,			//dataset not opened by GDAL
+	COUNTER_FAILED_NO_GEOREF,		//dataset without geotransform
+	COUNTER_FAILED_NO_SRS,			//dataset without SRS (--target-srs)
+	COUNTER_FAILED_REPROJECTION,	//coordinates not transformed to the target SRS
+	COUNTER_FAILED_TARGET_CONFLICT,	//datasets of the batch renamed to the same name
+	COUNTER_FAILED_TARGET_EXISTS,	//target and its backup name both exist
+	COUNTER_FAILED_BACKUP,			//existing target not moved to its backup name
+	COUNTER_FAILED_RENAME,			//rename refused by the file system
+	COUNTER_FAILED_TRANSFER,		//file not copied to another file system
+	COUNTER_FAILED_ARCHIVE,			//archive not rewritten
+	COUNTER_COUNT
+	};
+
+//!Per phase latency histograms and counters of a run, emitted as JSON
+//!(--stats) and as periodic progress lines (--progress). The phases are
+//!timed only when a RunStats is selected (see setRunStats)
+class RunStats
+	{
+	public:
+		RunStats();
+		~RunStats();
+
+		void Record(RunPhase ePhase, double dfSeconds);
+		void Count(RunCounter eCounter, int nValue = 1);
+		int GetCount(RunCounter eCounter) const;
+		int GetSyscalls() const;
+		double GetElapsed() const;
+
+		void SetProgressInterval(double dfSeconds);
+		void Progress(bool bForce = false);
+		bool WriteJSON(const char* pszPath);
+
+		static double GetTime();
+
+	private:
+		//latencies histogram, bucket i counts the durations below 2^i us
+		enum { HISTOGRAM_BUCKETS = 32 };
+		struct PhaseHistogram
+			{
+			GIntBig	nCount;
+			double	dfTotal;
+			double	dfMin;
+			double	dfMax;
+			GIntBig	anBuckets[HISTOGRAM_BUCKETS];
+			};
+
+		double GetPercentile(const PhaseHistogram& oHistogram, double dfRatio) const;
+
+		CPLMutex		*hMutex;
+		double			dfStart;
+		double			dfProgressInterval;	//0 for no progress lines
+		double			dfLastProgress;
+		volatile int	anCounters[COUNTER_COUNT];
+		PhaseHistogram	aoPhases[PHASE_COUNT];
+	};
+
+//!Time a phase from construction to destruction, nothing is done when no
+//!statistics are collected
+class PhaseTimer
+	{
+	public:
+		PhaseTimer(RunPhase ePhase);
+		~PhaseTimer();
+
+	private:
+		RunPhase	ePhase;
+		double		dfStart;
+	};
+
+//!Select the statistics of the run (NULL for none)
+void setRunStats(RunStats* poStats);
+
+//!Count an event of the run statistics, if any
+void countRunStats(RunCounter eCounter, int nValue = 1);
+
+//!Return number of digits from integer part of double (absolute value, 0 below 1)
+int nDigits (double dValue);
+
+//!Coordinates of one corner of a batch of tiles (far corner : origin + raster size * pixel size)
+void computeTileCorners(size_t nTiles, const double* padfOrigin, const double* padfPixelSize, const double* padfRasterSize,
+						bool bFarCorner, double* padfCoords);
+
+//!Digit counts of the reference points of a batch of tiles (the max of both nDigits)
+void computeDigitCounts(size_t nTiles, const double* padfCoordsX, const double* padfCoordsY, int* panDigits);
+
+//!Get integer coordinate from dataset georeferencing
+double getCoord (char refPointPart, const DatasetGeoRef& oGeoRef);
+//!Get char of coordinate hemisphere from dataset georeferencing
+
+char getCoordHemi (char refPointPart, const DatasetGeoRef& oGeoRef);
+//!Get char of coordinate hemisphere from a (possibly reprojected) coordinate
+char getHemi (char refPointPart, double Coord);
+
+//!Result of a rename
+enum RenameResult
+	{
+	RENAME_FAILED = -1,
+	RENAME_DONE = 0,
+	RENAME_TARGET_EXISTS = 1,
+	RENAME_NOT_DONE = 2
+	};
+
+//!Available rename backends
+enum RenameBackendType
+	{
+	RENAME_BACKEND_VSI,			//VSIRename, portable
+	RENAME_BACKEND_RENAMEAT2,	//renameat2(RENAME_NOREPLACE), Linux
+	RENAME_BACKEND_IO_URING		//renameat2 submitted in batches with io_uring, Linux 5.11
+	};
+
+//!One file (dataset or sibling) to rename
+struct RenameOperation
+	{
+	std::string		sSourcePath;
+	std::string		sTargetPath;
+	size_t			nJob;		//index of the dataset in the renamed batch
+	bool			bMainFile;	//dataset or sibling file
+	RenameResult	nResult;
+	};
+
+//!Order of the renames of a batch computed by the planner
+struct RenamePlan
+	{
+	std::vector<size_t>							anOrder;		//renames of the chains, from their end
+	std::vector<size_t>							anFreedBy;		//rename to do before to free the target, or -1
+	std::vector< std::vector<size_t> >			aanCycles;		//cycles of renames (A->B, B->C, C->A)
+	std::vector< std::pair<size_t, size_t> >	aoDuplicates;	//renames listed twice, and the planned one
+	};
+
+//!A rename read from the journal
+struct JournalRename
+	{
+	std::string	sSourcePath;
+	std::string	sTargetPath;
+	bool		bDone;
+	};
+
+//!Append only journal of the renames of a run : planned renames (P),
+//!done (D) and undone (U) ones, and sync points (S) before which the
+//!records and the renames are durable. Records are synced in groups
+class RenameJournal
+	{
+	public:
+		RenameJournal();
+		~RenameJournal();
+
+		bool Open(const char* pszPath, bool bAppend);
+		void Planned(const std::string& sSourcePath, const std::string& sTargetPath);
+		void Done(const std::string& sSourcePath, const std::string& sTargetPath);
+		void Undone(const std::string& sSourcePath, const std::string& sTargetPath);
+		bool Sync();
+
+		static bool Read(const char* pszPath, std::vector<JournalRename>& aoRenames);
+
+	private:
+		void Write(char chType, const std::string& sSourcePath, const std::string& sTargetPath);
+
+		FILE							*fp;
+		CPLMutex						*hMutex;
+		std::unordered_set<std::string>	oTouchedDirs;	//directories of the renames not synced yet
+		size_t							nUnsynced;
+	};
+
+//!Select the journal recording the renames (NULL for none)
+void setRenameJournal(RenameJournal* poJournal);
+
+//!Replay the renames of an interrupted run not done, return the paths already renamed
+bool resumeJournal(const char* pszPath, std::unordered_set<std::string>& oDonePaths);
+
+//!Undo the renames of a run recorded in its journal
+bool rollbackJournal(const char* pszPath);
+
+//!Select the rename backend ("auto", "vsi", "renameat2" or "io_uring")
+bool setRenameBackend(const char* pszBackend);
+
+//!Rename a file only if the target does not exist
+RenameResult renameNoReplace(const std::string& sSourcePath, const std::string& sTargetPath);
+
+//!Atomically exchange two files (false if not supported)
+bool renameExchange(const std::string& sPath1, const std::string& sPath2);
+
+//!Copy size of one copy_file_range() or sendfile() call
+#define GDAL_RENAME_COPY_CHUNK		(64 * 1024 * 1024)
+
+//!Move a file to another file system : copied (reflink or in kernel copy)
+//!next to its target, synced, renamed to its target then unlinked
+RenameResult moveFileAcrossDevices(const std::string& sSourcePath, const std::string& sTargetPath);
+
+//!Rename a list of files with no overwrite in batches (io_uring backend)
+void renameNoReplaceBatch(std::vector<RenameOperation>& aoOps, SiblingIndex& oSiblingIndex);
+
+//!Call VSIL rename function and rename old file if already existing
+bool renameFileNoOverWrite (std::string sourcePath, std::string newPath, SiblingIndex& oSiblingIndex);
+
+//!Get world file extension of a GDALDataset
+std::string getWorldFileExt (std::string inputFile);
+
+//!Get an array of sibling files extensions of a dataset (ie: tfw, prj
+//!for a tif file). Need to be populated for other datasets !!!
+std::vector<std::string> getSiblingFilesExt (std::string inputFile);
+
+//!Read the raster size, the GeoTIFF georeferencing tags and the EPSG code of a TIFF file
+bool readTiffGeoRef(const char* pszFilePath, DatasetGeoRef& oGeoRef, bool& bHasGeoTransform, int& nEPSG);
+
+//!Read the raster size of a JPEG2000 file (false if it has internal georeferencing)
+bool readJP2Size(const char* pszFilePath, DatasetGeoRef& oGeoRef);
+
+//!Read a world file as a geotransform
+bool readWorldFile(const char* pszWorldFilePath, double *adfGeoTransform);
+
+//!Look for the world file of a dataset and read it
+bool readDatasetWorldFile(const char* pszFilePath, double *adfGeoTransform, SiblingIndex& oSiblingIndex);
+
+//!Look for the .prj file of a dataset and read its SRS definition
+bool readDatasetPrjFile(const char* pszFilePath, std::string& sSRS, SiblingIndex& oSiblingIndex);
+
+//!Read the georeferencing of an ER Mapper .ers header
+bool readERSGeoRef(const char* pszERSPath, DatasetGeoRef& oGeoRef);
+
+//!Read the georeferencing of a dataset (and its SRS if psSRS) from its headers only, without GDALOpen
+bool readGeoRefFast(const char* pszFilePath, DatasetGeoRef& oGeoRef, SiblingIndex& oSiblingIndex, std::string* psSRS);
+
+//!Georeferencing of a file in the cache, valid while the file size,
+//!modification time and inode are unchanged
+struct GeoRefCacheRecord
+	{
+	GUIntBig	nPathHash;
+	GUIntBig	nPathOffset;	//in the paths pool
+	GUIntBig	nSize;
+	GIntBig		nMTime;
+	GUIntBig	nInode;
+	double		adfGeoTransform[6];
+	GInt32		nRasterXSize;
+	GInt32		nRasterYSize;
+	GUInt32		nPathLength;
+	GUInt32		nMTimeNSec;	//0 where stat has no nanoseconds
+	};
+
+//!Persistent cache of the datasets georeferencing, so the datasets of an
+//!archive renamed again (ie: with another naming scheme) are not opened
+class GeoRefCache
+	{
+	public:
+		GeoRefCache();
+		~GeoRefCache();
+
+		bool Open(const char* pszPath);
+		bool Lookup(const char* pszFilePath, GeoRefCacheRecord& oRecord, DatasetGeoRef& oGeoRef) const;
+		void Add(const char* pszFilePath, const GeoRefCacheRecord& oRecord, const DatasetGeoRef& oGeoRef);
+		void Renamed(const std::string& sSourcePath, const std::string& sNewPath);
+		bool Save();
+
+	private:
+		void Close();
+		std::string GetKey(const char* pszFilePath) const;
+
+		std::string									sPath;
+		std::string									sCurrentDir;
+		GByte										*pabyData;		//cache file content
+		size_t										nDataSize;
+		bool										bMapped;
+		const GeoRefCacheRecord						*psRecords;		//sorted by path hash
+		size_t										nRecords;
+		const char									*pszPaths;
+		size_t										nPathsSize;
+		CPLMutex									*hMutex;
+		std::unordered_map<std::string, GeoRefCacheRecord>	oNewRecords;	//read this run, by path
+		std::unordered_map<std::string, std::string>		oRenamed;		//renamed this run, old path -> new path
+	};
+
+struct RenameJob;
+
+//!Number of features written to the tile index per transaction
+#define GDAL_RENAME_TILE_INDEX_TRANSACTION	65536
+
+class ReprojectionCache;
+
+//!Tile index written in the same pass as the renames (--tile-index) :
+//!new path, footprint and SRS of the renamed datasets in a GeoPackage
+//!(R*Tree) or FlatGeobuf (packed Hilbert R-tree) layer. Written by the
+//!rename stage only, by groups of features in large transactions. The
+//!footprints in another SRS than the layer one are reprojected to it
+class TileIndex
+	{
+	public:
+		TileIndex();
+		~TileIndex();
+
+		bool Open(const char* pszPath, const char* pszFormat);
+		void Add(const std::vector<RenameJob>& aoJobs, const char* pszOutputDir);
+		bool Close();
+
+	private:
+		bool CreateLayer(const std::string& sSRS);
+		bool CommitTransaction();
+
+		std::string		sPath;
+		GDALDataset		*poDataset;
+		OGRLayer		*poLayer;		//created with the SRS of the first dataset
+		std::string		sLayerSRS;
+		ReprojectionCache	*poReprojection;	//footprints to the layer SRS, created by the first other SRS
+		int				nLocationField;
+		int				nSRSField;
+		int				nPendingFeatures;	//written since the transaction start
+		bool			bTransaction;		//not supported by FlatGeobuf
+		bool			bSuccess;
+	};
+
+//!Default memory budget (MB) of the duplicate targets check
+#define GDAL_RENAME_CHECK_MEMORY		512
+//!Read buffer of each run file merged by the duplicate targets check
+#define GDAL_RENAME_CHECK_RUN_BUFFER	(64 * 1024)
+
+//!Pre-flight check of the targets of a whole inventory (--check-duplicates),
+//!nothing is renamed : the datasets renamed to the same path, and the
+//!targets held by a file out of the inventory, are reported. The targets
+//!are grouped in a hash table within the memory budget, spilled to sorted
+//!run files once over it and merged at the end (external sort)
+class DuplicateCheck
+	{
+	public:
+		DuplicateCheck();
+		~DuplicateCheck();
+
+		void SetMemoryBudget(size_t nBytes);
+		void Add(const std::vector<RenameJob>& aoJobs, const char* pszOutputDir);
+		bool Report(int& nDuplicateTargets, int& nDuplicateDatasetsOut, int& nExistingTargetsOut);
+
+	private:
+		DuplicateCheck(const DuplicateCheck&);
+		DuplicateCheck& operator=(const DuplicateCheck&);
+
+		bool Spill();
+		void ReportTarget(const std::string& sTarget, const std::vector<std::string>& asSources);
+
+		std::unordered_map< std::string, std::vector<std::string> >	oTargets;	//target -> datasets renamed to it, "" for the dataset renamed from it
+		std::vector<std::string>	asRunPaths;			//sorted runs spilled to disk
+		size_t						nMemoryBudget;
+		size_t						nMemoryUsed;		//estimate of the hash table size
+		int							nDuplicates;		//targets of several datasets
+		int							nDuplicateDatasets;
+		int							nExistingTargets;	//targets held by a file out of the inventory
+		bool						bSuccess;
+	};
+
+//!Buffer of the commands printed with --output-console, written at once when full
+#define GDAL_RENAME_COMMAND_BUFFER	(1024 * 1024)
+
+//!Commands of the renames printed instead of done (--output-console), in
+//!one of the formats : "unix" and "win" commands, "sh" and "cmd" scripts
+//!creating each target directory once, "nul" src\0dst\0 pairs for
+//!xargs -0 and "jsonl" plan. The commands are buffered and written by
+//!large blocks, the paths are quoted for the shell of the format
+class CommandWriter
+	{
+	public:
+		CommandWriter();
+		~CommandWriter();
+
+		static bool IsFormat(const char* pszFormat);
+		bool Open(const char* pszFormat, FILE* fpOutput);
+		void Write(const std::vector<RenameOperation>& aoRenames);
+		bool Flush();
+
+	private:
+		CommandWriter(const CommandWriter&);
+		CommandWriter& operator=(const CommandWriter&);
+
+		bool WriteBuffer();
+
+		std::string							sFormat;
+		FILE								*fp;			//stdout, or NULL to discard the commands
+		std::string							sBuffer;
+		std::unordered_set<std::string>		oDirectories;	//target directories already created by the script
+		CPLMutex							*hMutex;
+		bool								bSuccess;
+	};
+
+//!GDAL drivers registered at startup and allowed to open the datasets
+//!(--drivers), by extension so the identification of a dataset only
+//!probes the drivers of its format
+class DriverAllowList
+	{
+	public:
+		DriverAllowList();
+		~DriverAllowList();
+
+		bool Build(const char* pszDrivers, char** papszExtensions);
+		void AddDriver(const char* pszDriver);
+		void Register(bool bReportMissing) const;
+		char** GetDrivers(const char* pszFilePath) const;
+
+	private:
+		DriverAllowList(const DriverAllowList&);
+		DriverAllowList& operator=(const DriverAllowList&);
+
+		char							**papszDrivers;		//all the allowed drivers
+		std::map<std::string, char**>	oDriversByExt;		//lower case extension -> allowed drivers of the extension
+	};
+
+//!Register a GDAL driver by name (built in or plugin), false if not found
+bool registerDriver(const char* pszDriver);
+
+//!Read the georeferencing of a dataset and its SRS if psSRS (headers fast path or GDALOpenEx with the allowed drivers, all if NULL)
+bool readGeoRef(const char* pszFilePath, DatasetGeoRef& oGeoRef, bool bFastGeoRef, char** papszAllowedDrivers, SiblingIndex& oSiblingIndex, std::string* psSRS);
+
+//!Check whether or not the given refpoint is good
+bool checkRefPoint(const char* CoordRefPoint);
+
+//!format the rename command line for output in the console, the paths quoted for the shell of pszSystemType
+std::string formatRenameCmdLine(const char* pszSystemType, const char* pszSourceName, const char* pszNewName);
+
+struct RenameOptions;
+
+//!Kind of the tokens of a compiled name template
+enum NameTokenType
+	{
+	NAME_TOKEN_LITERAL,	//text (prefix, separator...)
+	NAME_TOKEN_COORD,	//coordinate of the reference point
+	NAME_TOKEN_HEMI,	//hemisphere letter of a coordinate
+	NAME_TOKEN_COL,		//column of the tile in the tiles grid
+	NAME_TOKEN_ROW		//row of the tile in the tiles grid
+	};
+
+//!Token of a compiled name template, the coordinates format is the printf
+//!one : [-][+][0][width][.precision] and d (integer), f (fixed) or t
+//!(integer keeping the precision high weight digits of the coordinates)
+struct NameToken
+	{
+	NameTokenType	eType;
+	std::string		sText;
+	char			chRefPoint;		//W, E, N or S
+	char			chConversion;
+	bool			bLeft;
+	bool			bPlus;
+	bool			bZero;
+	bool			bSpace;			//' ' flag, a space before the positive numbers
+	bool			bAlternate;		//'#' flag, the decimal point of 'f' kept without decimals
+	int				nWidth;
+	int				nPrecision;		//-1 if not given
+
+	NameToken() : eType(NAME_TOKEN_LITERAL), chRefPoint('W'), chConversion('d'), bLeft(false), bPlus(false), bZero(false),
+				  bSpace(false), bAlternate(false), nWidth(0), nPrecision(-1) {}
+	};
+
+//!Relative tolerance (of the tiles size) of a reference point on a grid node
+#define GDAL_RENAME_GRID_TOLERANCE	1e-6
+
+//!Tiles grid of the {col} and {row} fields : the node of index 0,0 and the
+//!tiles size, given (--grid) or inferred from the batch by the rename stage
+struct TileGrid
+	{
+	double	dOriginX;
+	double	dOriginY;
+	double	dTileSizeX;
+	double	dTileSizeY;
+	bool	bInfer;		//inferred from the whole batch (--grid auto)
+	bool	bValid;		//origin and tiles size known
+
+	TileGrid() : dOriginX(0.0), dOriginY(0.0), dTileSizeX(0.0), dTileSizeY(0.0), bInfer(false), bValid(false) {}
+	};
+
+//!Parse a --grid value : "auto" or origin_x,origin_y,tile_size_x,tile_size_y
+bool parseTileGrid(const char* pszGrid, TileGrid& oGrid);
+
+//!Georeferencing of a batch of datasets as structure of arrays (one array
+//!per used geotransform term) for the vector kernels of the names
+struct TileExtents
+	{
+	std::vector<double>	adfOriginX;		//geotransform[0]
+	std::vector<double>	adfPixelSizeX;	//geotransform[1]
+	std::vector<double>	adfOriginY;		//geotransform[3]
+	std::vector<double>	adfPixelSizeY;	//geotransform[5]
+	std::vector<double>	adfRasterSizeX;
+	std::vector<double>	adfRasterSizeY;
+
+	void Add(const DatasetGeoRef& oGeoRef);
+	void Clear();
+	size_t Size() const { return adfOriginX.size(); }
+	};
+
+//!Naming of the datasets (--name-template, --printf-syntax or coordinates
+//!options) compiled and checked once into tokens, then rendered for each
+//!dataset (or batch of datasets) without any format string parsing
+class NameTemplate
+	{
+	public:
+		NameTemplate();
+
+		bool Compile(const RenameOptions& oOptions, std::string& sError);
+		void Render(const DatasetGeoRef& oGeoRef, std::string& sName) const;
+		void GetCoords(const DatasetGeoRef& oGeoRef, double& dCoordX, double& dCoordY) const;
+		void RenderCoords(double dCoordX, double dCoordY, std::string& sName) const;
+		void GetCoordsBatch(const TileExtents& oExtents, std::vector<double>& adfCoordsX, std::vector<double>& adfCoordsY) const;
+		void RenderBatch(const std::vector<double>& adfCoordsX, const std::vector<double>& adfCoordsY, std::vector<std::string>& asNames) const;
+		bool HasGridFields() const;
+		bool GetGridIndex(double dCoordX, double dCoordY, GIntBig& nCol, GIntBig& nRow) const;
+		bool HasRowsNorthward() const { return chRefPointY == 'S'; }
+
+	private:
+		void RenderCoords(double dCoordX, double dCoordY, int nCoordsDigits, std::string& sName) const;
+		bool CompileTemplate(const std::string& sTemplate, const RenameOptions& oOptions, std::string& sError);
+		bool CompilePrintf(const std::string& sFormat, const RenameOptions& oOptions, std::string& sError);
+		bool AddLiteral(const std::string& sText, std::string& sError);
+
+		std::vector<NameToken>	aoTokens;
+		char					chRefPointX;	//W or E
+		char					chRefPointY;	//N or S
+		const TileGrid			*poTileGrid;	//grid of the {col} and {row} fields
+		std::string				sOffGridSuffix;	//appended to the names of the tiles off the grid
+	};
+
+//!Renaming options shared by all the datasets of a run
+struct RenameOptions
+	{
+	const char *pszCoordRefPoint;
+	bool		pszCoordPadding;
+	const char *pszCoordLenght;
+	const char *pszCoordDecLenght;
+	const char *pszCoordType;
+	const char *pszCoordSignType;
+	const char *pszCoordSep;
+	const char *pszPrefix;
+	const char *pszSuffix;
+	const char *pszPrintf;
+	const char *pszNameTemplate;
+	const char *pszOutputConsole;
+	bool		bFastGeoRef;
+	bool		bPlanRenames;	//plan the renames of the whole batch before doing them
+	GeoRefCache	*poGeoRefCache;	//persistent georeferencing cache, or NULL
+	const NameTemplate *poNameTemplate;	//compiled naming of the datasets
+	const char *pszTargetSRS;	//SRS of the coordinates of the names (--target-srs), or NULL
+	TileGrid	*poTileGrid;	//grid of the {col} and {row} fields, or NULL
+	TileIndex	*poTileIndex;	//tile index of the renamed datasets (--tile-index), or NULL
+	const char *pszOffGridSuffix;	//appended to the names of the datasets off the grid
+	const DriverAllowList *poDrivers;	//drivers allowed to open the datasets (--drivers), or NULL for all
+	const char *pszOutputDir;	//directory of the renamed datasets (--output-dir), or NULL for their own directory
+	int			nTransferThreads;	//parallel copies of the datasets moved across file systems
+	DuplicateCheck *poDuplicateCheck;	//targets checked instead of renamed (--check-duplicates), or NULL
+	CommandWriter *poCommandWriter;	//writer of the --output-console commands, or NULL for a writer per batch on stdout
+
+	RenameOptions();
+	};
+
+//!Thread safe FIFO used to feed the worker threads, Push() blocks while
+//!the queue is full so memory use does not depend on the number of inputs
+template <class T> class WorkQueue
+	{
+	public:
+		WorkQueue(size_t nMaxItems);
+		~WorkQueue();
+
+		void Push(const T& oItem);
+		bool Pop(T& oItem);
+		bool TryPop(T& oItem);
+		void Close();
+
+	private:
+		CPLMutex		*hMutex;
+		CPLCond			*hCondNotEmpty;
+		CPLCond			*hCondNotFull;
+		std::deque<T>	oItems;
+		size_t			nMaxItems;
+		bool			bClosed;
+	};
+
+//!A dataset and the new name computed for it by the workers
+struct RenameJob
+	{
+	std::string	sFilePath;
+	std::string	sNewFileName; //without directory nor extension
+	bool		bSuccess;
+	double		dCoordX;		//reference point and tiles size, named by the rename stage
+	double		dCoordY;		//once the grid is inferred (--grid auto)
+	double		dTileSizeX;
+	double		dTileSizeY;
+	DatasetGeoRef	oGeoRef;	//footprint and SRS of the tile index (--tile-index)
+	std::string	sSRS;
+	};
+
+//!Shared state of a batch run : pipeline queues, options and results summary
+struct BatchContext
+	{
+	const RenameOptions			*poOptions;
+	WorkQueue<std::string>		*poQueue;		//reader stage -> workers
+	WorkQueue<RenameJob>		*poJobQueue;	//workers -> rename stage
+	SiblingIndex				*poSiblingIndex;
+	const std::unordered_set<std::string> *poDonePaths;	//renamed by the resumed run, or NULL
+	bool						bWatch;			//datasets arriving until stopped (--watch), no job waits for a group
+	volatile int				nSkipped;
+	int							nSuccess;
+	std::vector<std::string>	aosFailures;
+	};
+
+//!Coordinate transformations from the SRS of the datasets to the target
+//!SRS (--target-srs), created once per source SRS. One cache per thread,
+//!a transformation is not thread safe
+class ReprojectionCache
+	{
+	public:
+		ReprojectionCache(const char* pszTargetSRS);
+		~ReprojectionCache();
+
+		OGRCoordinateTransformationH Get(const std::string& sSourceSRS);
+
+	private:
+		OGRSpatialReferenceH	hTargetSRS;
+		std::map<std::string, OGRCoordinateTransformationH>	oTransforms;	//NULL if the source SRS is not usable
+	};
+
+//!Maximum number of datasets of a name group waiting for their names
+#define GDAL_RENAME_NAME_GROUP	1024
+
+//!Datasets of a worker sharing the same source SRS (all its datasets
+//!without --target-srs), their names are computed together : corners,
+//!transformation to the target SRS and digit counts of the whole group
+struct NameGroup
+	{
+	std::vector<RenameJob>	aoJobs;
+	TileExtents				oExtents;
+	};
+
+//!Read the georeferencing of a dataset (georeferencing cache, headers or GDALOpen) and its SRS if psSRS
+bool readDatasetGeoRef(const char* pszFilePath, const RenameOptions& oOptions, SiblingIndex& oSiblingIndex, DatasetGeoRef& oGeoRef, std::string* psSRS);
+
+//!Infer the tiles grid of a batch from the reference points and tiles sizes of its datasets, in linear time
+bool inferTileGrid(const std::vector<RenameJob>& aoJobs, bool bRowsNorthward, TileGrid& oGrid);
+
+//!Warn about a dataset whose reference point is not on a node of the tiles grid
+void reportOffGridDataset(const NameTemplate& oNameTemplate, const std::string& sFilePath, double dCoordX, double dCoordY);
+
+//!Infer the tiles grid of a whole batch then render the names of its datasets (--grid auto)
+void renderGridNames(std::vector<RenameJob>& aoJobs, const RenameOptions& oOptions);
+
+//!Compute the new file names of a group of datasets, transformed to the target SRS if poCache
+void renderNameGroup(NameGroup& oGroup, const std::string& sSourceSRS, ReprojectionCache* poCache, const RenameOptions& oOptions);
+
+//!Open a dataset and compute its new file name (without directory nor extension)
+bool computeNewFileName(const char* pszFilePath, const RenameOptions& oOptions, SiblingIndex& oSiblingIndex, std::string& sNewFileName);
+
+//!Path of a renamed file (new name and extension) in the output directory, or in its own directory if NULL
+std::string getRenamedPath(const std::string& sFilePath, const std::string& sNewFileName, const std::string& sExt, const char* pszOutputDir);
+
+//!List the renames of a dataset and of its sibling files (to pszOutputDir if not NULL)
+void listRenameOperations(const char* pszFilePath, const std::string& sNewFileName, const char* pszOutputDir, size_t nJob,
+						  SiblingIndex& oSiblingIndex, std::vector<RenameOperation>& aoOps);
+
+//!Perform a list of renames, return false if a dataset (main file) rename failed
+bool executeRenameOperations(std::vector<RenameOperation>& aoOps, SiblingIndex& oSiblingIndex);
+
+//!Perform a list of renames to the output directory, the datasets moved to another file system are copied in parallel
+void executeTransferOperations(std::vector<RenameOperation>& aoOps, SiblingIndex& oSiblingIndex, int nThreads);
+
+//!Build and sort the rename graph of a batch, report the renames to the same target
+void planRenameOperations(std::vector<RenameOperation>& aoOps, RenamePlan& oPlan);
+
+//!Temporary name used to break a cycle of renames
+std::string getTemporaryRenamePath(const std::string& sFilePath, SiblingIndex& oSiblingIndex);
+
+//!List the renames breaking a cycle with one temporary name
+void listCycleRenames(const std::vector<RenameOperation>& aoOps, const std::vector<size_t>& anCycle, size_t nFirst,
+					  const std::string& sTmpPath, std::vector<RenameOperation>& aoRenames);
+
+//!Perform a cycle of renames with exchanges or one temporary name
+void executeRenameCycle(std::vector<RenameOperation>& aoOps, const std::vector<size_t>& anCycle, SiblingIndex& oSiblingIndex);
+
+//!Perform the renames of a batch in the planned order, return false if a dataset (main file) rename failed
+bool executePlannedRenameOperations(std::vector<RenameOperation>& aoOps, const RenamePlan& oPlan, SiblingIndex& oSiblingIndex);
+
+//!Rename datasets and their sibling files to their new names (or print the commands to do it)
+void applyRenames(std::vector<RenameJob>& aoJobs, const RenameOptions& oOptions, SiblingIndex& oSiblingIndex);
+
+//!Rename a dataset and its sibling files to the new name (or print the commands to do it)
+bool applyRename(const char* pszFilePath, const std::string& sNewFileName, const RenameOptions& oOptions, SiblingIndex& oSiblingIndex);
+
+//!Rename a dataset and its sibling files (or print the commands to do it)
+bool renameDataset(const char* pszFilePath, const RenameOptions& oOptions);
+
+//!Buffer of the entries copied to a rewritten archive
+#define GDAL_RENAME_ARCHIVE_CHUNK	(1024 * 1024)
+
+//!Rename the datasets and sibling files inside a ZIP or TAR archive, the
+//!entries are copied to a new archive without recompression
+bool renameArchive(const char* pszArchivePath, char** papszExtensions, const RenameOptions& oOptions, int& nRenamed, int& nFailures);
+
+//!Push the paths read from stdin to the batch queue
+void queueStdinPaths(bool bNulDelimited, WorkQueue<std::string>& oQueue);
+
+//!Push a file to the batch queue, or all the matching files of a directory
+void queueInputPath(const std::string& sInputPath, char** papszExtensions, WorkQueue<std::string>& oQueue);
+
+//!Default settle window of the watch mode : seconds without any write to
+//!a dataset and its sibling files before it is renamed
+#define GDAL_RENAME_WATCH_SETTLE	0.2
+
+//!Number of new paths of the renames kept by the watch mode to know its
+//!own renames from the datasets moved in the watched directories
+#define GDAL_RENAME_WATCH_RENAMES	65536
+
+//!A file of the watched directories being written (--watch)
+struct WatchedFile
+	{
+	double	dfLastEvent;	//last creation, write, close or move in
+	bool	bClosed;		//closed (or moved in) after its last write
+	};
+
+//!Push the datasets written to the watched directories to the batch queue once settled, until SIGINT/SIGTERM
+bool queueWatchedPaths(const std::vector<std::string>& aosDirectories, char** papszExtensions, double dfSettle, SiblingIndex& oSiblingIndex, WorkQueue<std::string>& oQueue);
+
+//!Rename the datasets of the inputs with the batch pipeline
+void runBatch(const std::vector<std::string>& aosInputPaths, bool bFromStdin, bool bNulDelimited, bool bWatch, double dfWatchSettle,
+			  int nThreads, char** papszExtensions, const RenameOptions& oOptions, const std::unordered_set<std::string>* poDonePaths,
+			  BatchContext& oContext);
+
+#endif //GDAL_RENAME_PRIV_H_INCLUDED